@@ -39,6 +39,7 @@
 #include "gegl-buffer-index.h"
 #include "gegl-tile-backend.h"
 #include "gegl-buffer-iterator.h"
+#include "gegl-tile.h"
 
 #if 0
 static inline void
@@ -126,6 +127,57 @@ gegl_buffer_in_abyss( GeglBuffer *buffer,
            tiledx <  abyss_x_total);
 }
 
+/* the hot tile is owned by one thread at a time, a thread accessing a
+ * single pixel takes it from the buffer and puts it back when done,
+ * meanwhile other threads fetch their tiles through the tile chain.
+ * A hot tile fetched before the storage generation last changed might
+ * have been replaced in the cache, also through another buffer on the
+ * same storage, and is dropped.
+ */
+static inline GeglTile *
+gegl_buffer_take_hot_tile (GeglBuffer *buffer)
+{
+  GeglTile *tile;
+
+  do
+    tile = g_atomic_pointer_get ((gpointer *) &buffer->hot_tile);
+  while (tile &&
+         !g_atomic_pointer_compare_and_exchange ((gpointer *) &buffer->hot_tile,
+                                                 tile, NULL));
+
+  if (tile &&
+      g_atomic_int_get (&buffer->hot_generation) !=
+      g_atomic_int_get (&buffer->tile_storage->generation))
+    {
+      gegl_tile_unref (tile);
+      tile = NULL;
+    }
+  return tile;
+}
+
+/* generation is the storage generation read before the tile was fetched */
+static inline void
+gegl_buffer_put_hot_tile (GeglBuffer *buffer,
+                          GeglTile   *tile,
+                          gint        generation)
+{
+  if (generation == g_atomic_int_get (&buffer->tile_storage->generation) &&
+      g_atomic_pointer_compare_and_exchange ((gpointer *) &buffer->hot_tile,
+                                             NULL, tile))
+    g_atomic_int_set (&buffer->hot_generation, generation);
+  else
+    gegl_tile_unref (tile);
+}
+
+static void
+gegl_buffer_drop_hot_tile (GeglBuffer *buffer)
+{
+  GeglTile *tile = gegl_buffer_take_hot_tile (buffer);
+
+  if (tile)
+    gegl_tile_unref (tile);
+}
+
 static inline void
 gegl_buffer_set_pixel (GeglBuffer *buffer,
                        gint        x,
@@ -159,27 +211,23 @@ gegl_buffer_set_pixel (GeglBuffer *buffer,
       }
     else
       {
-        gint      indice_x = gegl_tile_indice (tiledx, tile_width);
-        gint      indice_y = gegl_tile_indice (tiledy, tile_height);
-        GeglTile *tile     = NULL;
-
-        if (buffer->hot_tile &&
-            buffer->hot_tile->x == indice_x &&
-            buffer->hot_tile->y == indice_y)
+        gint      indice_x   = gegl_tile_indice (tiledx, tile_width);
+        gint      indice_y   = gegl_tile_indice (tiledy, tile_height);
+        gint      generation = g_atomic_int_get (&buffer->tile_storage->generation);
+        GeglTile *tile       = NULL;
+
+        tile = gegl_buffer_take_hot_tile (buffer);
+        if (tile &&
+            (tile->x != indice_x ||
+             tile->y != indice_y))
           {
-            tile = buffer->hot_tile;
-          }
-        else
-          {
-            if (buffer->hot_tile)
-              {
-                gegl_tile_unref (buffer->hot_tile);
-                buffer->hot_tile = NULL;
-              }
-            tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
-                                             indice_x, indice_y,
-                                             0);
+            gegl_tile_unref (tile);
+            tile = NULL;
           }
+        if (!tile)
+          tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
+                                           indice_x, indice_y,
+                                           0);
 
         if (tile)
           {
@@ -197,7 +245,7 @@ gegl_buffer_set_pixel (GeglBuffer *buffer,
               memcpy (tp, buf, bpx_size);
 
             gegl_tile_unlock (tile);
-            buffer->hot_tile = tile;
+            gegl_buffer_put_hot_tile (buffer, tile, generation);
           }
       }
   }
@@ -237,41 +285,42 @@ gegl_buffer_get_pixel (GeglBuffer *buffer,
       }
     else
       {
-        gint      indice_x = gegl_tile_indice (tiledx, tile_width);
-        gint      indice_y = gegl_tile_indice (tiledy, tile_height);
-        GeglTile *tile     = NULL;
-
-        if (buffer->hot_tile &&
-            buffer->hot_tile->x == indice_x &&
-            buffer->hot_tile->y == indice_y)
+        gint      indice_x   = gegl_tile_indice (tiledx, tile_width);
+        gint      indice_y   = gegl_tile_indice (tiledy, tile_height);
+        gint      generation = g_atomic_int_get (&buffer->tile_storage->generation);
+        GeglTile *tile       = NULL;
+
+        tile = gegl_buffer_take_hot_tile (buffer);
+        if (tile &&
+            (tile->x != indice_x ||
+             tile->y != indice_y))
           {
-            tile = buffer->hot_tile;
+            gegl_tile_unref (tile);
+            tile = NULL;
           }
-        else
-          {
-            if (buffer->hot_tile)
-              {
-                gegl_tile_unref (buffer->hot_tile);
-                buffer->hot_tile = NULL;
-              }
-            tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
+        if (!tile)
+          tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
                                            indice_x, indice_y,
                                            0);
-          }
 
         if (tile)
           {
             gint    offsetx = gegl_tile_offset (tiledx, tile_width);
             gint    offsety = gegl_tile_offset (tiledy, tile_height);
-            guchar *tp      = gegl_tile_get_data (tile) +
-                              (offsety * tile_width + offsetx) * px_size;
+            guchar *tp;
+
+            /* the hot tile might have been processed on the OpenCL
+             * device meanwhile */
+            gegl_tile_cl_sync (tile);
+
+            tp = gegl_tile_get_data (tile) +
+                 (offsety * tile_width + offsetx) * px_size;
             if (fish)
               babl_process (fish, tp, buf, 1);
             else
               memcpy (buf, tp, px_size);
 
-            /*gegl_tile_unref (tile);*/
-            buffer->hot_tile = tile;
+            gegl_buffer_put_hot_tile (buffer, tile, generation);
           }
       }
   }
@@ -288,11 +337,7 @@ gegl_buffer_flush (GeglBuffer *buffer)
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
   backend = gegl_buffer_backend (buffer);
 
-  if (buffer->hot_tile)
-    {
-      gegl_tile_unref (buffer->hot_tile);
-      buffer->hot_tile = NULL;
-    }
+  gegl_buffer_drop_hot_tile (buffer);
 
   if ((GeglBufferHeader*)(backend->priv->header))
     {
@@ -525,8 +570,10 @@ gegl_buffer_iterate (GeglBuffer          *buffer,
                   }
                 else /* read */
                   {
-                    gint row;
-                    gint y = bufy;
+                    gint     row;
+                    gint     y        = bufy;
+                    gboolean constant = gegl_tile_is_constant (tile);
+                    guchar  *first    = NULL;
 
                     for (row = offsety;
                          row < tile_height && y < height;
@@ -535,7 +582,32 @@ gegl_buffer_iterate (GeglBuffer          *buffer,
                         if (buffer_y + y >= buffer_abyss_y &&
                             buffer_y + y < abyss_y_total)
                           {
-                            if (fish)
+                            if (constant)
+                              {
+                                /* all pixels are equal, convert one and
+                                 * fill the rows with it
+                                 */
+                                if (first)
+                                  {
+                                    memcpy (bp, first, pixels * bpx_size);
+                                  }
+                                else
+                                  {
+                                    gint filled;
+
+                                    if (fish)
+                                      babl_process (fish, tp, bp, 1);
+                                    else
+                                      memcpy (bp, tp, px_size);
+                                    for (filled = bpx_size;
+                                         filled < pixels * bpx_size;
+                                         filled *= 2)
+                                      memcpy (bp + filled, bp,
+                                              MIN (filled, pixels * bpx_size - filled));
+                                    first = bp;
+                                  }
+                              }
+                            else if (fish)
                               babl_process (fish, tp, bp, pixels);
                             else
                               memcpy (bp, tp, pixels * px_size);
@@ -579,13 +651,11 @@ gegl_buffer_set_unlocked (GeglBuffer          *buffer,
   if (format == NULL)
     format = buffer->format;
 
-#if 0 /* XXX: not thread safe */
   if (rect && rect->width == 1 && rect->height == 1) /* fast path */
     {
       gegl_buffer_set_pixel (buffer, rect->x, rect->y, format, src);
     }
   else
-#endif
   gegl_buffer_iterate (buffer, rect, src, rowstride, TRUE, format, 0);
 
   if (gegl_buffer_is_shared(buffer))
@@ -936,8 +1006,6 @@ gegl_buffer_get_unlocked (GeglBuffer          *buffer,
   if (format == NULL)
     format = buffer->format;
 
-#if 0
-  /* not thread-safe */
   if (scale == 1.0 &&
       rect &&
       rect->width == 1 &&
@@ -946,7 +1014,6 @@ gegl_buffer_get_unlocked (GeglBuffer          *buffer,
       gegl_buffer_get_pixel (buffer, rect->x, rect->y, format, dest_buf);
       return;
     }
-#endif
 
   if (!rect && scale == 1.0)
     {
@@ -1069,6 +1136,49 @@ gegl_buffer_get_abyss (GeglBuffer *buffer)
 GType
 gegl_sampler_gtype_from_enum (GeglSamplerType sampler_type);
 
+/* the sampler used by a thread for gegl_buffer_sample */
+typedef struct _GeglBufferSampler
+{
+  GThread     *thread;
+  GeglSampler *sampler;
+  const Babl  *format;   /* the format of the sampler */
+} GeglBufferSampler;
+
+/* the samplers of the buffer are only added to while sampling, and
+ * only changed by the thread they belong to, so looking up the sampler
+ * of the calling thread needs no locking
+ */
+static GeglBufferSampler *
+gegl_buffer_get_thread_sampler (GeglBuffer *buffer)
+{
+  GThread           *thread = g_thread_self ();
+  GeglBufferSampler *entry;
+  GSList            *head;
+  GSList            *iter;
+
+  head = g_atomic_pointer_get ((gpointer *) &buffer->samplers);
+  for (iter = head; iter; iter = iter->next)
+    {
+      entry = iter->data;
+      if (entry->thread == thread)
+        return entry;
+    }
+
+  entry         = g_slice_new0 (GeglBufferSampler);
+  entry->thread = thread;
+  iter          = g_slist_alloc ();
+  iter->data    = entry;
+
+  do
+    {
+      head       = g_atomic_pointer_get ((gpointer *) &buffer->samplers);
+      iter->next = head;
+    }
+  while (!g_atomic_pointer_compare_and_exchange ((gpointer *) &buffer->samplers,
+                                                 head, iter));
+  return entry;
+}
+
 void
 gegl_buffer_sample (GeglBuffer       *buffer,
                     gdouble           x,
@@ -1078,7 +1188,8 @@ gegl_buffer_sample (GeglBuffer       *buffer,
                     const Babl       *format,
                     GeglSamplerType   sampler_type)
 {
-  GType desired_type;
+  GeglBufferSampler *entry;
+  GType              desired_type;
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
 
 /*#define USE_WORKING_SHORTCUT*/
@@ -1088,50 +1199,205 @@ gegl_buffer_sample (GeglBuffer       *buffer,
 #endif
 
   desired_type = gegl_sampler_gtype_from_enum (sampler_type);
+  entry        = gegl_buffer_get_thread_sampler (buffer);
 
   /* unset the cached sampler if it dosn't match the needs */
-  if (buffer->sampler != NULL &&
-     (!G_TYPE_CHECK_INSTANCE_TYPE (buffer->sampler, desired_type) ||
-       buffer->sampler_format != format
+  if (entry->sampler != NULL &&
+     (!G_TYPE_CHECK_INSTANCE_TYPE (entry->sampler, desired_type) ||
+       entry->format != format
       ))
     {
-      g_object_unref (buffer->sampler);
-      buffer->sampler = NULL;
+      g_object_unref (entry->sampler);
+      entry->sampler = NULL;
     }
 
   /* look up appropriate sampler,. */
-  if (buffer->sampler == NULL)
+  if (entry->sampler == NULL)
     {
-      buffer->sampler = g_object_new (desired_type,
-                                      "buffer", buffer,
-                                      "format", format,
-                                      NULL);
-      buffer->sampler_format = format;
-      gegl_sampler_prepare (buffer->sampler);
+      entry->sampler = g_object_new (desired_type,
+                                     "buffer", buffer,
+                                     "format", format,
+                                     NULL);
+      entry->format = format;
+      gegl_sampler_prepare (entry->sampler);
     }
 
-  gegl_sampler_get (buffer->sampler, x, y, scale, dest);
+  gegl_sampler_get (entry->sampler, x, y, scale, dest);
 }
 
+/* operations clean up after processing, while other threads might still
+ * be sampling the same buffer with their own samplers
+ */
 void
 gegl_buffer_sample_cleanup (GeglBuffer *buffer)
 {
+  GThread *thread = g_thread_self ();
+  GSList  *iter;
+
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
 
-  if (buffer->sampler)
+  for (iter = g_atomic_pointer_get ((gpointer *) &buffer->samplers);
+       iter; iter = iter->next)
     {
-      g_object_unref (buffer->sampler);
-      buffer->sampler = NULL;
+      GeglBufferSampler *entry = iter->data;
+
+      if (entry->thread == thread && entry->sampler)
+        {
+          g_object_unref (entry->sampler);
+          entry->sampler = NULL;
+        }
     }
 }
 
+void
+gegl_buffer_free_samplers (GeglBuffer *buffer)
+{
+  GSList *samplers = buffer->samplers;
+  GSList *iter;
+
+  buffer->samplers = NULL;
+
+  for (iter = samplers; iter; iter = iter->next)
+    {
+      GeglBufferSampler *entry = iter->data;
+
+      if (entry->sampler)
+        g_object_unref (entry->sampler);
+      g_slice_free (GeglBufferSampler, entry);
+    }
+  g_slist_free (samplers);
+}
+
+static void
+gegl_buffer_copy_pixels (GeglBuffer          *src,
+                         const GeglRectangle *src_rect,
+                         GeglBuffer          *dst,
+                         const GeglRectangle *dst_rect)
+{
+  Babl               *fish;
+  GeglRectangle       dest_rect_r = *dst_rect;
+  GeglBufferIterator *i;
+  gint                read;
+
+  if (src_rect->width <= 0 || src_rect->height <= 0)
+    return;
+
+  fish = babl_fish (src->format, dst->format);
+
+  dest_rect_r.width = src_rect->width;
+  dest_rect_r.height = src_rect->height;
+
+  i = gegl_buffer_iterator_new (dst, &dest_rect_r, dst->format, GEGL_BUFFER_WRITE);
+  read = gegl_buffer_iterator_add (i, src, src_rect, src->format, GEGL_BUFFER_READ);
+  while (gegl_buffer_iterator_next (i))
+    babl_process (fish, i->data[read], i->data[0], i->length);
+}
+
+/* whether the tiles of src can be shared with dst instead of copying
+ * pixels: the pixel data has to be identical, the rectangles have to
+ * map tiles onto tiles and be clear of the abysses, and dst has to sit
+ * directly on its storage so the shared tiles get voided with it.
+ */
+static gboolean
+gegl_buffer_copy_can_share (GeglBuffer          *src,
+                            const GeglRectangle *src_rect,
+                            GeglBuffer          *dst,
+                            const GeglRectangle *dst_rect)
+{
+  GeglRectangle dst_r = *dst_rect;
+
+  dst_r.width  = src_rect->width;
+  dst_r.height = src_rect->height;
+
+  return src->format == dst->format &&
+         src->tile_width == dst->tile_width &&
+         src->tile_height == dst->tile_height &&
+         src->tile_storage != dst->tile_storage &&
+         GEGL_IS_TILE_STORAGE (GEGL_TILE_HANDLER (dst)->source) &&
+         !g_object_get_data (G_OBJECT (src), "linear-tile") &&
+         !g_object_get_data (G_OBJECT (dst), "linear-tile") &&
+         GEGL_REMAINDER (src_rect->x + src->shift_x - dst_rect->x - dst->shift_x,
+                         dst->tile_width) == 0 &&
+         GEGL_REMAINDER (src_rect->y + src->shift_y - dst_rect->y - dst->shift_y,
+                         dst->tile_height) == 0 &&
+         gegl_rectangle_contains (&src->abyss, src_rect) &&
+         gegl_rectangle_contains (&dst->abyss, &dst_r);
+}
+
+/* splits rect into the whole tiles it covers, returned as a range of
+ * tile indices in storage coordinates, and the strips of partial tiles
+ * along its edges, returns FALSE when rect doesn't cover a whole tile.
+ */
+static gboolean
+gegl_buffer_get_whole_tiles (GeglBuffer          *buffer,
+                             const GeglRectangle *rect,
+                             GeglRectangle       *tiles,
+                             GeglRectangle        strips[4])
+{
+  gint          tile_width  = buffer->tile_width;
+  gint          tile_height = buffer->tile_height;
+  gint          x0, y0, x1, y1;
+  GeglRectangle whole;
+
+  x0 = gegl_tile_indice (rect->x + buffer->shift_x + tile_width - 1, tile_width);
+  y0 = gegl_tile_indice (rect->y + buffer->shift_y + tile_height - 1, tile_height);
+  x1 = gegl_tile_indice (rect->x + buffer->shift_x + rect->width, tile_width);
+  y1 = gegl_tile_indice (rect->y + buffer->shift_y + rect->height, tile_height);
+
+  if (x1 <= x0 || y1 <= y0)
+    return FALSE;
+
+  gegl_rectangle_set (tiles, x0, y0, x1 - x0, y1 - y0);
+
+  whole.x      = x0 * tile_width - buffer->shift_x;
+  whole.y      = y0 * tile_height - buffer->shift_y;
+  whole.width  = (x1 - x0) * tile_width;
+  whole.height = (y1 - y0) * tile_height;
+
+  /* above, below, left and right of the whole tiles */
+  gegl_rectangle_set (&strips[0], rect->x, rect->y,
+                      rect->width, whole.y - rect->y);
+  gegl_rectangle_set (&strips[1], rect->x, whole.y + whole.height,
+                      rect->width, rect->y + rect->height - (whole.y + whole.height));
+  gegl_rectangle_set (&strips[2], rect->x, whole.y,
+                      whole.x - rect->x, whole.height);
+  gegl_rectangle_set (&strips[3], whole.x + whole.width, whole.y,
+                      rect->x + rect->width - (whole.x + whole.width), whole.height);
+
+  return TRUE;
+}
+
+/* replaces the tile at (tx, ty) of a buffer sitting directly on its
+ * storage, the tile is put in the cache and written back from there.
+ */
+static void
+gegl_buffer_insert_tile (GeglBuffer *buffer,
+                         GeglTile   *tile,
+                         gint        tx,
+                         gint        ty)
+{
+  tile->tile_storage = buffer->tile_storage;
+  tile->x = tx;
+  tile->y = ty;
+  tile->z = 0;
+  tile->rev++; /* not yet stored in the backend */
+
+  g_atomic_int_inc (&buffer->tile_storage->generation);
+  gegl_tile_handler_cache_insert (buffer->tile_storage->cache, tile, tx, ty, 0);
+  gegl_tile_void_pyramid (tile);
+
+  gegl_buffer_track_tile (buffer, tx, ty, 0);
+}
+
 void
 gegl_buffer_copy (GeglBuffer          *src,
                   const GeglRectangle *src_rect,
                   GeglBuffer          *dst,
                   const GeglRectangle *dst_rect)
 {
-  Babl         *fish;
+  GeglRectangle dst_r;
+  GeglRectangle tiles;
+  GeglRectangle strips[4];
 
   g_return_if_fail (GEGL_IS_BUFFER (src));
   g_return_if_fail (GEGL_IS_BUFFER (dst));
@@ -1146,20 +1412,86 @@ gegl_buffer_copy (GeglBuffer          *src,
       dst_rect = src_rect;
     }
 
-  fish = babl_fish (src->format, dst->format);
+  dst_r = *dst_rect;
+  dst_r.width  = src_rect->width;
+  dst_r.height = src_rect->height;
 
+  if (gegl_buffer_copy_can_share (src, src_rect, dst, dst_rect) &&
+      gegl_buffer_get_whole_tiles (dst, &dst_r, &tiles, strips))
     {
-      GeglRectangle dest_rect_r = *dst_rect;
-      GeglBufferIterator *i;
-      gint read;
+      /* the offset from dst to src in tiles */
+      gint src_tile_x = (src_rect->x + src->shift_x - dst_rect->x - dst->shift_x) / dst->tile_width;
+      gint src_tile_y = (src_rect->y + src->shift_y - dst_rect->y - dst->shift_y) / dst->tile_height;
+      gint tx, ty;
+      gint i;
+
+      gegl_buffer_drop_hot_tile (dst);
+
+      for (ty = tiles.y; ty < tiles.y + tiles.height; ty++)
+        for (tx = tiles.x; tx < tiles.x + tiles.width; tx++)
+          {
+            GeglTile *src_tile;
+            GeglTile *dst_tile;
+
+            src_tile = gegl_tile_source_get_tile ((GeglTileSource *) src,
+                                                  tx + src_tile_x,
+                                                  ty + src_tile_y, 0);
+            if (!src_tile)
+              {
+                /* nothing to share, the pixels are copied instead of
+                 * leaving the old content of the tile in dst */
+                GeglRectangle dst_tile_rect;
+                GeglRectangle src_tile_rect;
+
+                gegl_rectangle_set (&dst_tile_rect,
+                                    tx * dst->tile_width - dst->shift_x,
+                                    ty * dst->tile_height - dst->shift_y,
+                                    dst->tile_width, dst->tile_height);
+                src_tile_rect    = dst_tile_rect;
+                src_tile_rect.x += src_rect->x - dst_rect->x;
+                src_tile_rect.y += src_rect->y - dst_rect->y;
+                gegl_buffer_copy_pixels (src, &src_tile_rect, dst, &dst_tile_rect);
+                continue;
+              }
+
+            dst_tile = gegl_tile_dup (src_tile);
+            gegl_buffer_insert_tile (dst, dst_tile, tx, ty);
+
+            gegl_tile_unref (dst_tile);
+            gegl_tile_unref (src_tile);
+          }
 
-      dest_rect_r.width = src_rect->width;
-      dest_rect_r.height = src_rect->height;
+      for (i = 0; i < 4; i++)
+        {
+          GeglRectangle src_strip = strips[i];
+
+          src_strip.x += src_rect->x - dst_rect->x;
+          src_strip.y += src_rect->y - dst_rect->y;
+          gegl_buffer_copy_pixels (src, &src_strip, dst, &strips[i]);
+        }
+      return;
+    }
+
+  gegl_buffer_copy_pixels (src, src_rect, dst, dst_rect);
+}
+
+static void
+gegl_buffer_clear_pixels (GeglBuffer          *dst,
+                          const GeglRectangle *dst_rect)
+{
+  GeglBufferIterator *i;
+  gint                pxsize;
+
+  if (dst_rect->width <= 0 ||
+      dst_rect->height <= 0)
+    return;
 
-      i = gegl_buffer_iterator_new (dst, &dest_rect_r, dst->format, GEGL_BUFFER_WRITE);
-      read = gegl_buffer_iterator_add (i, src, src_rect, src->format, GEGL_BUFFER_READ);
-      while (gegl_buffer_iterator_next (i))
-        babl_process (fish, i->data[read], i->data[0], i->length);
+  pxsize = babl_format_get_bytes_per_pixel (dst->format);
+
+  i = gegl_buffer_iterator_new (dst, dst_rect, dst->format, GEGL_BUFFER_WRITE);
+  while (gegl_buffer_iterator_next (i))
+    {
+      memset (((guchar*)(i->data[0])), 0, i->length * pxsize);
     }
 }
 
@@ -1167,8 +1499,8 @@ void
 gegl_buffer_clear (GeglBuffer          *dst,
                    const GeglRectangle *dst_rect)
 {
-  GeglBufferIterator *i;
-  gint                pxsize;
+  GeglRectangle tiles;
+  GeglRectangle strips[4];
 
   g_return_if_fail (GEGL_IS_BUFFER (dst));
 
@@ -1180,16 +1512,36 @@ gegl_buffer_clear (GeglBuffer          *dst,
       dst_rect->height == 0)
     return;
 
-  pxsize = babl_format_get_bytes_per_pixel (dst->format);
-
-  /* FIXME: this can be even further optimized by special casing it so
-   * that fully voided tiles are dropped.
-   */
-  i = gegl_buffer_iterator_new (dst, dst_rect, dst->format, GEGL_BUFFER_WRITE);
-  while (gegl_buffer_iterator_next (i))
+  /* whole tiles are replaced with shared constant tiles */
+  if (GEGL_IS_TILE_STORAGE (GEGL_TILE_HANDLER (dst)->source) &&
+      !g_object_get_data (G_OBJECT (dst), "linear-tile") &&
+      gegl_rectangle_contains (&dst->abyss, dst_rect) &&
+      gegl_buffer_get_whole_tiles (dst, dst_rect, &tiles, strips))
     {
-      memset (((guchar*)(i->data[0])), 0, i->length * pxsize);
+      gint    px_size   = babl_format_get_bytes_per_pixel (dst->format);
+      gint    tile_size = dst->tile_storage->tile_size;
+      guchar *zero      = g_malloc0 (px_size);
+      gint    tx, ty;
+      gint    i;
+
+      gegl_buffer_drop_hot_tile (dst);
+
+      for (ty = tiles.y; ty < tiles.y + tiles.height; ty++)
+        for (tx = tiles.x; tx < tiles.x + tiles.width; tx++)
+          {
+            GeglTile *tile = gegl_tile_new_constant (tile_size, px_size, zero);
+
+            gegl_buffer_insert_tile (dst, tile, tx, ty);
+            gegl_tile_unref (tile);
+          }
+      g_free (zero);
+
+      for (i = 0; i < 4; i++)
+        gegl_buffer_clear_pixels (dst, &strips[i]);
+      return;
     }
+
+  gegl_buffer_clear_pixels (dst, dst_rect);
 }
 
 GeglBuffer *
@@ -1199,7 +1551,16 @@ gegl_buffer_dup (GeglBuffer *buffer)
 
   g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
 
-  new_buffer = gegl_buffer_new (gegl_buffer_get_extent (buffer), buffer->format);
+  /* same tile size as the original, so the tiles can be shared */
+  new_buffer = g_object_new (GEGL_TYPE_BUFFER,
+                             "x",           buffer->extent.x,
+                             "y",           buffer->extent.y,
+                             "width",       buffer->extent.width,
+                             "height",      buffer->extent.height,
+                             "format",      buffer->format,
+                             "tile-width",  buffer->tile_width,
+                             "tile-height", buffer->tile_height,
+                             NULL);
   gegl_buffer_copy (buffer, gegl_buffer_get_extent (buffer),
                     new_buffer, gegl_buffer_get_extent (buffer));
   return new_buffer;
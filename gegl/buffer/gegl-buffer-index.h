@@ -97,8 +97,21 @@ typedef struct {
                             revision changes, the existing loaded index
                             can be compare the revision of tiles and update
                             own state when revision differs. */
+
+  guint32 size;          /* number of bytes stored at offset, 0 for tiles
+                            written before this field existed, meaning a
+                            full uncompressed tile */
+  guint32 codec;         /* GEGL_TILE_CODEC_* the data at offset is encoded
+                            with */
 } GeglBufferTile;
 
+/* encodings of the tile data stored for a GeglBufferTile, only swap files
+ * use anything but GEGL_TILE_CODEC_NONE
+ */
+#define GEGL_TILE_CODEC_NONE     0 /* the raw pixel data */
+#define GEGL_TILE_CODEC_CONSTANT 1 /* a single pixel repeated for the tile */
+#define GEGL_TILE_CODEC_RLE      2 /* runs of repeated and literal pixels */
+
 /* A convenience union to allow quick and simple casting */
 typedef union {
   guint32          length;
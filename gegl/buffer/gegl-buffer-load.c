@@ -33,6 +33,7 @@
 #include "gegl-buffer.h"
 #include "gegl-tile-storage.h"
 #include "gegl-tile-backend.h"
+#include "gegl-tile-backend-file.h"
 #include "gegl-tile-handler.h"
 #include "gegl-tile.h"
 #include "gegl-tile-handler-cache.h"
@@ -194,10 +195,11 @@ static GeglBufferItem *read_block (int           i,
     }
   else if (block.length < own_size)
     {
-      ret = g_malloc (own_size);
+      /* fields added in later versions are left zeroed */
+      ret = g_malloc0 (own_size);
       memcpy (ret, &block, sizeof (GeglBufferBlock));
       {
-        ssize_t sz_read = read (i, ret + sizeof(GeglBufferBlock),
+        ssize_t sz_read = read (i, ((gchar*)ret) + sizeof(GeglBufferBlock),
 								block.length - sizeof (GeglBufferBlock));
 		if(sz_read != -1)
 		  byte_read += sz_read;
@@ -325,11 +327,23 @@ gegl_buffer_load (const gchar *path)
         data = gegl_tile_get_data (tile);
         g_assert (data);
 
-        {
-          ssize_t sz_read = read (info->i, data, info->tile_size);
-          if(sz_read != -1)
-            info->offset += sz_read;
-        }
+        if (entry->codec == GEGL_TILE_CODEC_NONE)
+          {
+            ssize_t sz_read = read (info->i, data, info->tile_size);
+            if(sz_read != -1)
+              info->offset += sz_read;
+          }
+        else
+          {
+            guchar  *encoded = g_malloc (entry->size);
+            ssize_t  sz_read = read (info->i, encoded, entry->size);
+            if(sz_read != -1)
+              info->offset += sz_read;
+            gegl_tile_backend_file_decode (entry->codec, encoded, entry->size,
+                                           data, info->tile_size,
+                                           info->header.bytes_per_pixel);
+            g_free (encoded);
+          }
         /*g_assert (info->offset == entry->offset + info->tile_size);*/
 
         gegl_tile_unlock (tile);
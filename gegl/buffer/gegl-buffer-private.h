@@ -25,6 +25,8 @@
 #include "gegl-tile-handler.h"
 #include "gegl-buffer-iterator.h"
 
+#include "opencl/gegl-cl.h"
+
 #define GEGL_BUFFER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_BUFFER, GeglBufferClass))
 #define GEGL_IS_BUFFER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_BUFFER))
 #define GEGL_IS_BUFFER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_BUFFER))
@@ -49,11 +51,12 @@ struct _GeglBuffer
 
   GeglTile         *hot_tile; /* cached tile for speeding up gegl_buffer_get_pixel
                                  and gegl_buffer_set_pixel (1x1 sized gets/sets)*/
+  gint              hot_generation; /* storage generation the hot tile was
+                                       fetched in */
 
-  GeglSampler      *sampler; /* cached sampler for speeding up random
-                                access interpolated fetches from the
-                                buffer */
-  const Babl       *sampler_format; /* the format of the cached sampler */
+  GSList           *samplers; /* cached samplers for speeding up random
+                                 access interpolated fetches from the
+                                 buffer, one for every thread sampling it */
 
   GeglTileStorage  *tile_storage;
 
@@ -98,10 +101,23 @@ void              gegl_tile_cache_init    (void);
 
 void              gegl_tile_cache_destroy (void);
 
+void              gegl_tile_cache_stats   (void);
+
 GeglTileBackend * gegl_buffer_backend     (GeglBuffer *buffer);
 
 gboolean          gegl_buffer_is_shared   (GeglBuffer *buffer);
 
+/* extends the range of tiles voided along with the buffer to include
+ * the tile at x, y, z, may be called from several threads at once
+ */
+void              gegl_buffer_track_tile  (GeglBuffer *buffer,
+                                           gint        x,
+                                           gint        y,
+                                           gint        z);
+
+/* frees the samplers of all threads, when the buffer is disposed */
+void              gegl_buffer_free_samplers (GeglBuffer *buffer);
+
 gboolean          gegl_buffer_try_lock    (GeglBuffer *buffer);
 gboolean          gegl_buffer_lock        (GeglBuffer *buffer);
 gboolean          gegl_buffer_unlock      (GeglBuffer *buffer);
@@ -129,6 +145,36 @@ void            gegl_buffer_sampler           (GeglBuffer     *buffer,
                                                const Babl     *format,
                                                gpointer        sampler);
 
+/* gets a tile like getting it from the buffer as a tile source, but
+ * leaves data that is more recent on the OpenCL device there, for
+ * processing it on the device
+ */
+GeglTile *      gegl_buffer_cl_get_tile       (GeglBuffer     *buffer,
+                                               gint            x,
+                                               gint            y,
+                                               gint            z);
+
+/* Tiles can have a copy of their data on the OpenCL device, which is
+ * more recent than the data on the host after gegl_tile_cl_set_data.
+ * Getting a tile from a buffer, locking it and storing it brings the
+ * data on the host up to date, so that only the tiles the cpu needs are
+ * read back from the device.
+ */
+
+/* returns a new reference to the device copy of the tile, copying the
+ * data to the device first if there is none, or NULL on failure
+ */
+cl_mem          gegl_tile_cl_get_data         (GeglTile       *tile);
+
+/* replaces the data of the tile with data on the device, taking over
+ * the reference to it
+ */
+void            gegl_tile_cl_set_data         (GeglTile       *tile,
+                                               cl_mem          data);
+
+/* reads the data back from the device if it is more recent there */
+void            gegl_tile_cl_sync             (GeglTile       *tile);
+
 
 
 /* the instance size of a GeglTile is a bit large, and should if possible be
@@ -167,11 +213,25 @@ struct _GeglTile
   GeglDestroyNotify destroy_notify;
   gpointer          destroy_notify_data;
 
+  /* the data is borrowed, for instance from a memory mapped file, and
+   * is copied before the tile is modified
+   */
+  gboolean          read_only;
+
+  /* the tile had constant data when locked, see gegl_tile_lock () */
+  gboolean          check_constant;
+
   /* called when the tile has been unlocked which typically means tile
    * data has changed
    */
   GeglTileCallback unlock_notify;
   gpointer         unlock_notify_data;
+
+  /* a copy of the data on the OpenCL device, more recent than the data
+   * on the host when cl_dirty is set
+   */
+  cl_mem           cl_data;
+  gboolean         cl_dirty;
 };
 
 #ifndef __GEGL_TILE_C
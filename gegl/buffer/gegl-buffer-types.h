@@ -43,6 +43,9 @@ struct _GeglTileBackendPrivate
   gpointer   header;
   gpointer   storage;
   gboolean   shared;
+
+  GMutex    *mutex;     /* held by the backends while executing a command,
+                           tiles are fetched and stored from any thread */
 };
 
 
@@ -371,7 +371,7 @@ gegl_buffer_dispose (GObject *object)
   GeglBuffer  *buffer  = GEGL_BUFFER (object);
   GeglTileHandler *handler = GEGL_TILE_HANDLER (object);
 
-  gegl_buffer_sample_cleanup (buffer);
+  gegl_buffer_free_samplers (buffer);
 
   if (handler->source &&
       GEGL_IS_TILE_STORAGE (handler->source))
@@ -542,6 +542,7 @@ gegl_buffer_constructor (GType                  type,
                                    "tile-height", 64,
                                    "format", buffer->format?buffer->format:babl_format ("RGBA float"),
                                    "path", buffer->path,
+                                   "mmap", TRUE,
                                    NULL);
           storage = gegl_tile_storage_new (backend);
 
@@ -701,17 +702,22 @@ gegl_buffer_constructor (GType                  type,
   return object;
 }
 
+/* gets the tile without reading its data back from the OpenCL device,
+ * also from the buffers this one is a sub-buffer of
+ */
 static GeglTile *
-gegl_buffer_get_tile (GeglTileSource *source,
-                      gint        x,
-                      gint        y,
-                      gint        z)
+gegl_buffer_get_tile_unsynced (GeglTileSource *source,
+                               gint            x,
+                               gint            y,
+                               gint            z)
 {
   GeglTileHandler *handler = GEGL_TILE_HANDLER (source);
   GeglTile    *tile   = NULL;
   source = handler->source;
 
-  if (source)
+  if (source && GEGL_IS_BUFFER (source))
+    tile = gegl_buffer_get_tile_unsynced (source, x, y, z);
+  else if (source)
     tile = gegl_tile_source_get_tile (source, x, y, z);
   else
     g_assert (0);
@@ -720,18 +726,7 @@ gegl_buffer_get_tile (GeglTileSource *source,
     {
       GeglBuffer *buffer = GEGL_BUFFER (handler);
 
-      /* XXX: lock buffer? */
-
-      if (x < buffer->min_x)
-        buffer->min_x = x;
-      if (y < buffer->min_y)
-        buffer->min_y = y;
-      if (x > buffer->max_x)
-        buffer->max_x = x;
-      if (y > buffer->max_y)
-        buffer->max_y = y;
-      if (z > buffer->max_z)
-        buffer->max_z = z;
+      gegl_buffer_track_tile (buffer, x, y, z);
 
       /* storing information in tile, to enable the dispose function of the
        * tile instance to "hook" back to the storage with correct
@@ -740,9 +735,19 @@ gegl_buffer_get_tile (GeglTileSource *source,
       {
         if (!tile->tile_storage)
           {
-            gegl_tile_lock (tile);
-            tile->tile_storage = buffer->tile_storage;
-            gegl_tile_unlock (tile);
+            /* constant tiles are regenerated or already stored, adopting
+             * them must not copy their shared data
+             */
+            if (gegl_tile_is_constant (tile))
+              {
+                tile->tile_storage = buffer->tile_storage;
+              }
+            else
+              {
+                gegl_tile_lock (tile);
+                tile->tile_storage = buffer->tile_storage;
+                gegl_tile_unlock (tile);
+              }
           }
         tile->x = x;
         tile->y = y;
@@ -753,6 +758,58 @@ gegl_buffer_get_tile (GeglTileSource *source,
   return tile;
 }
 
+static GeglTile *
+gegl_buffer_get_tile (GeglTileSource *source,
+                      gint            x,
+                      gint            y,
+                      gint            z)
+{
+  GeglTile *tile = gegl_buffer_get_tile_unsynced (source, x, y, z);
+
+  /* the tile is handed to code reading its data on the host */
+  if (tile)
+    gegl_tile_cl_sync (tile);
+
+  return tile;
+}
+
+GeglTile *
+gegl_buffer_cl_get_tile (GeglBuffer *buffer,
+                         gint        x,
+                         gint        y,
+                         gint        z)
+{
+  return gegl_buffer_get_tile_unsynced (GEGL_TILE_SOURCE (buffer), x, y, z);
+}
+
+
+static GStaticMutex track_mutex = G_STATIC_MUTEX_INIT;
+
+void
+gegl_buffer_track_tile (GeglBuffer *buffer,
+                        gint        x,
+                        gint        y,
+                        gint        z)
+{
+  /* the range rarely grows, only take the lock when it does */
+  if (x >= buffer->min_x && x <= buffer->max_x &&
+      y >= buffer->min_y && y <= buffer->max_y &&
+      z <= buffer->max_z)
+    return;
+
+  g_static_mutex_lock (&track_mutex);
+  if (x < buffer->min_x)
+    buffer->min_x = x;
+  if (y < buffer->min_y)
+    buffer->min_y = y;
+  if (x > buffer->max_x)
+    buffer->max_x = x;
+  if (y > buffer->max_y)
+    buffer->max_y = y;
+  if (z > buffer->max_z)
+    buffer->max_z = z;
+  g_static_mutex_unlock (&track_mutex);
+}
 
 static gpointer
 gegl_buffer_command (GeglTileSource *source,
@@ -1205,6 +1262,8 @@ gegl_tile_storage_new_cached (gint tile_width, gint tile_height,
                                   "tile-height", tile_height,
                                   "format", babl_fmt,
                                   "path", path,
+                                  "compression", gegl_config()->swap_compression,
+                                  "async-writes", gegl_config()->swap_queue_size > 0,
                                   NULL);
           storage = gegl_tile_storage_new (backend);
           g_free (path);
@@ -1266,6 +1325,7 @@ gegl_buffer_void (GeglBuffer *buffer)
   gint bufy        = 0;
 
   g_mutex_lock (buffer->tile_storage->mutex);
+  g_atomic_int_inc (&buffer->tile_storage->generation);
   {
     gint z;
     gint factor = 1;
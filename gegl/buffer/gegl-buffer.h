@@ -326,7 +326,8 @@ GeglBuffer *    gegl_buffer_dup               (GeglBuffer       *buffer);
  *
  * Query interpolate pixel values at a given coordinate using a specified form
  * of interpolation. The samplers used cache for a small neighbourhood of the
- * buffer for more efficient access.
+ * buffer for more efficient access. Every thread sampling the buffer gets its
+ * own sampler, several threads can sample the same buffer at once.
  */
 void gegl_buffer_sample (GeglBuffer       *buffer,
                          gdouble           x,
@@ -346,7 +347,8 @@ void gegl_buffer_sample (GeglBuffer       *buffer,
  * Clean up resources used by sampling framework of buffer (will be freed
  * automatically later when the buffer is destroyed, for long lived buffers
  * cleaning up the sampling infrastructure when it has been used for its
- * purpose will sometimes be more efficient).
+ * purpose will sometimes be more efficient). Only the sampler of the calling
+ * thread is freed, other threads might still be sampling the buffer.
  */
 void            gegl_buffer_sample_cleanup    (GeglBuffer *buffer);
 
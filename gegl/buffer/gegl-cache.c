@@ -420,3 +420,31 @@ gegl_cache_computed (GeglCache           *self,
   g_signal_emit (self, gegl_cache_signals[COMPUTED], 0, rect, NULL);
   g_mutex_unlock (self->mutex);
 }
+
+gboolean
+gegl_cache_has_room (GeglCache           *self,
+                     const GeglRectangle *rect,
+                     gint                 limit)
+{
+  GeglRegion    *region;
+  GeglRectangle *rectangles;
+  gint           n_rectangles;
+  gint64         pixels = 0;
+  gint           i;
+
+  g_return_val_if_fail (GEGL_IS_CACHE (self), FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  g_mutex_lock (self->mutex);
+  region = gegl_region_copy (self->valid_region);
+  g_mutex_unlock (self->mutex);
+
+  gegl_region_union_with_rect (region, rect);
+  gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+  for (i = 0; i < n_rectangles; i++)
+    pixels += (gint64) rectangles[i].width * rectangles[i].height;
+  g_free (rectangles);
+  gegl_region_destroy (region);
+
+  return pixels * babl_format_get_bytes_per_pixel (self->format) <= limit;
+}
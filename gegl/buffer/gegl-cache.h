@@ -52,6 +52,13 @@ void     gegl_cache_invalidate  (GeglCache           *self,
 void     gegl_cache_computed    (GeglCache           *self,
                                  const GeglRectangle *rect);
 
+/* whether the valid region of the cache stays within limit bytes when
+ * rect is computed as well
+ */
+gboolean gegl_cache_has_room    (GeglCache           *self,
+                                 const GeglRectangle *rect,
+                                 gint                 limit);
+
 G_END_DECLS
 
 #endif /* __GEGL_CACHE_H__ */
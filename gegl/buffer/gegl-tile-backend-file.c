@@ -25,13 +25,18 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #include <glib-object.h>
 #include <glib/gprintf.h>
 
 #include "gegl.h"
+#include "gegl-config.h"
 #include "gegl-tile-backend.h"
 #include "gegl-tile-backend-file.h"
+#include "gegl-tile.h"
 #include "gegl-buffer-index.h"
 #include "gegl-buffer-types.h"
 #include "gegl-debug.h"
@@ -46,6 +51,16 @@
 
 #endif
 
+/* number of size classes of the free list */
+#define GEGL_FILE_FREE_BUCKETS 16
+
+/* compaction on GEGL_TILE_IDLE starts once at least this many bytes,
+ * and half of the file, are free; each idle moves at most
+ * GEGL_FILE_COMPACT_BATCH tiles.
+ */
+#define GEGL_FILE_COMPACT_MIN   (1024 * 1024)
+#define GEGL_FILE_COMPACT_BATCH 16
+
 struct _GeglTileBackendFile
 {
   GeglTileBackend  parent_instance;
@@ -68,8 +83,14 @@ struct _GeglTileBackendFile
    */
   GHashTable      *index;
 
-  /* list of offsets to tiles that are free */
-  GSList          *free_list;
+  /* GeglFileExtents describing free regions of the file, bucketed by
+   * size
+   */
+  GSList          *free_list[GEGL_FILE_FREE_BUCKETS];
+
+  /* bytes used by tiles, and bytes of the file free for reuse */
+  guint64          live_bytes;
+  guint64          dead_bytes;
 
   /* offset to next pre allocated tile slot */
   guint            next_pre_alloc;
@@ -108,29 +129,731 @@ struct _GeglTileBackendFile
 
   /* for reading */
   int              i;
+
+  /* whether tiles are compressed when written, tiles are decoded
+   * according to their index entry regardless of this setting
+   */
+  gboolean         compression;
+
+  /* scratch space of tile_size bytes for encoding and decoding tiles */
+  guchar          *codec_buf;
+
+  /* whether tiles are read through a memory mapping of the file, tiles
+   * then borrow their data from the mapping until they are modified
+   */
+  gboolean         mmap;
+
+  /* the tiles currently using mapped data, and the most recent mapping */
+  struct _GeglFileMap    *map;
+  struct _GeglFileWindow *window;
+
+  /* GeglFileExtents freed while tiles were still using their mapped
+   * data, they are moved to the free list once no longer in use
+   */
+  GSList          *retired;
+
+  /* whether tile data is written by the writer thread, the offsets of
+   * tiles still waiting to be written map to their GeglFileWrite and
+   * pending_count is the number of queued writes, including cancelled
+   * ones.
+   */
+  gboolean         async_writes;
+  GHashTable      *pending;
+  gint             pending_count;
 };
 
+/* a region of the file not used by any tile */
+typedef struct
+{
+  guint64 offset;
+  guint   size;
+} GeglFileExtent;
+
+/* tile data is placed at 16 byte granularity, a tile written with the
+ * index entry size 0 predates compression and occupies a full tile.
+ */
+#define GEGL_FILE_SLOT_ALIGN 16
+
+/* files read through mappings grow by at least this much at a time, to
+ * avoid remapping the file for every few tiles written
+ */
+#define GEGL_FILE_MMAP_EXTENT (8 * 1024 * 1024)
+
+/* the bytes of the file mapped at once, around the tile being read */
+#define GEGL_FILE_MMAP_WINDOW (32 * 1024 * 1024)
+#define GEGL_FILE_SLOT_SIZE(size, tile_size) \
+  ((size) ? (((size) + GEGL_FILE_SLOT_ALIGN - 1) & ~(GEGL_FILE_SLOT_ALIGN - 1)) \
+          : (tile_size))
+
 
 static void     gegl_tile_backend_file_ensure_exist (GeglTileBackendFile *self);
 static gboolean gegl_tile_backend_file_write_block  (GeglTileBackendFile *self,
                                                      GeglBufferBlock     *block);
 static void     gegl_tile_backend_file_dbg_alloc    (int                  size);
 static void     gegl_tile_backend_file_dbg_dealloc  (int                  size);
+static void     gegl_tile_backend_file_dbg_dead     (int                  size);
 
 
-static inline void
-gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
-                                        GeglBufferTile      *entry,
-                                        guchar              *dest)
+/* bookkeeping shared by a file backend and the tiles borrowing mapped
+ * data from it, tiles might outlive the backend.
+ */
+typedef struct _GeglFileMap
+{
+  gint        ref_count;
+  GMutex     *mutex;
+  GHashTable *readers; /* offset -> number of tiles using the data there */
+} GeglFileMap;
+
+/* a read only mapping of length bytes of the file from offset */
+typedef struct _GeglFileWindow
+{
+  gint         ref_count;
+  guchar      *base;
+  guint64      offset;
+  gsize        length;
+  GeglFileMap *map;
+} GeglFileWindow;
+
+static gboolean
+gegl_tile_backend_file_slot_busy (GeglTileBackendFile *self,
+                                  guint64              offset)
+{
+  gboolean busy;
+
+  if (!self->map)
+    return FALSE;
+
+  g_mutex_lock (self->map->mutex);
+  busy = g_hash_table_lookup (self->map->readers,
+                              GSIZE_TO_POINTER ((gsize) offset)) != NULL;
+  g_mutex_unlock (self->map->mutex);
+
+  return busy;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+
+static void
+gegl_file_map_unref (GeglFileMap *map)
+{
+  if (!g_atomic_int_dec_and_test (&map->ref_count))
+    return;
+
+  g_mutex_free (map->mutex);
+  g_hash_table_unref (map->readers);
+  g_slice_free (GeglFileMap, map);
+}
+
+static void
+gegl_file_window_unref (GeglFileWindow *window)
+{
+  if (!g_atomic_int_dec_and_test (&window->ref_count))
+    return;
+
+  munmap (window->base, window->length);
+  gegl_file_map_unref (window->map);
+  g_slice_free (GeglFileWindow, window);
+}
+
+/* destroy notify of tiles borrowing mapped data */
+static void
+gegl_file_window_release (gpointer data,
+                          gpointer userdata)
+{
+  GeglFileWindow *window = userdata;
+  GeglFileMap    *map    = window->map;
+  gpointer        key    = GSIZE_TO_POINTER ((gsize) (window->offset +
+                                                          ((guchar *) data - window->base)));
+  gint            count;
+
+  g_mutex_lock (map->mutex);
+  count = GPOINTER_TO_INT (g_hash_table_lookup (map->readers, key)) - 1;
+  if (count > 0)
+    g_hash_table_insert (map->readers, key, GINT_TO_POINTER (count));
+  else
+    g_hash_table_remove (map->readers, key);
+  g_mutex_unlock (map->mutex);
+
+  gegl_file_window_unref (window);
+}
+
+/* returns a pointer to size bytes at offset in a mapping of the file.
+ * A window of the file around offset is mapped when offset lies outside
+ * the current one, earlier windows stay mapped while tiles use them.
+ */
+static guchar *
+gegl_tile_backend_file_map (GeglTileBackendFile *self,
+                            guint64              offset,
+                            gint                 size)
+{
+  if (!self->window ||
+      offset < self->window->offset ||
+      offset + size > self->window->offset + self->window->length)
+    {
+      GeglFileWindow *window;
+      struct stat     st;
+      gpointer        base;
+      guint64         start;
+      gsize           length;
+
+      if (fstat (self->i, &st) == -1 || offset + size > st.st_size)
+        return NULL;
+
+      /* mappings start on a page */
+      start  = offset - offset % sysconf (_SC_PAGESIZE);
+      length = MIN (MAX ((guint64) GEGL_FILE_MMAP_WINDOW, offset + size - start),
+                    (guint64) st.st_size - start);
+
+      base = mmap (NULL, length, PROT_READ, MAP_SHARED, self->i, start);
+      if (base == MAP_FAILED)
+        {
+          GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "unable to map %s: %s",
+                     self->path, g_strerror (errno));
+          return NULL;
+        }
+
+      if (!self->map)
+        {
+          self->map = g_slice_new (GeglFileMap);
+          self->map->ref_count = 1;
+          self->map->mutex     = g_mutex_new ();
+          self->map->readers   = g_hash_table_new (g_direct_hash, g_direct_equal);
+        }
+
+      window = g_slice_new (GeglFileWindow);
+      window->ref_count = 1;
+      window->base      = base;
+      window->offset    = start;
+      window->length    = length;
+      window->map       = self->map;
+      g_atomic_int_inc (&self->map->ref_count);
+
+      if (self->window)
+        gegl_file_window_unref (self->window);
+      self->window = window;
+
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "mapped %i bytes at %i of %s",
+                 (gint) window->length, (gint) window->offset, self->path);
+    }
+
+  return self->window->base + (offset - self->window->offset);
+}
+
+/* makes the tile use the mapped data at offset without copying it */
+static void
+gegl_tile_backend_file_borrow (GeglTileBackendFile *self,
+                               GeglTile            *tile,
+                               guchar              *data,
+                               guint64              offset)
+{
+  GeglFileWindow *window = self->window;
+  gpointer        key    = GSIZE_TO_POINTER ((gsize) offset);
+  gint            count;
+
+  g_mutex_lock (self->map->mutex);
+  count = GPOINTER_TO_INT (g_hash_table_lookup (self->map->readers, key)) + 1;
+  g_hash_table_insert (self->map->readers, key, GINT_TO_POINTER (count));
+  g_mutex_unlock (self->map->mutex);
+
+  g_atomic_int_inc (&window->ref_count);
+  gegl_tile_set_data_read_only (tile, data,
+                                gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)),
+                                gegl_file_window_release, window);
+}
+
+#endif
+
+/* run length encoding working on whole pixels, every run is introduced
+ * by a control byte, values 0-127 are followed by 1-128 literal pixels,
+ * values 128-255 by a single pixel repeated 2-129 times. Returns the
+ * number of bytes written to dest, or -1 if the encoding would not fit
+ * in max bytes.
+ */
+static gint
+gegl_tile_backend_file_rle_encode (const guchar *src,
+                                   gint          n_pixels,
+                                   gint          px_size,
+                                   guchar       *dest,
+                                   gint          max)
+{
+  gint i = 0;
+  gint o = 0;
+
+#define PIXEL(n) (src + (n) * px_size)
+
+  while (i < n_pixels)
+    {
+      gint run = 1;
+
+      while (i + run < n_pixels && run < 129 &&
+             !memcmp (PIXEL (i + run), PIXEL (i), px_size))
+        run++;
+
+      if (run > 1)
+        {
+          if (o + 1 + px_size > max)
+            return -1;
+          dest[o++] = 126 + run;
+          memcpy (dest + o, PIXEL (i), px_size);
+          o += px_size;
+          i += run;
+        }
+      else
+        {
+          gint literal = 1;
+
+          /* extend the literal until a repeated pixel starts a run */
+          while (i + literal < n_pixels && literal < 128 &&
+                 (i + literal + 1 >= n_pixels ||
+                  memcmp (PIXEL (i + literal), PIXEL (i + literal + 1), px_size)))
+            literal++;
+
+          if (o + 1 + literal * px_size > max)
+            return -1;
+          dest[o++] = literal - 1;
+          memcpy (dest + o, PIXEL (i), literal * px_size);
+          o += literal * px_size;
+          i += literal;
+        }
+    }
+#undef PIXEL
+
+  return o;
+}
+
+/* encodes the tile data into self->codec_buf if that is smaller than
+ * the tile, returns the codec used, and sets *encoded and *size to the
+ * data to write.
+ */
+static guint32
+gegl_tile_backend_file_encode (GeglTileBackendFile *self,
+                               guchar              *data,
+                               guchar             **encoded,
+                               guint32             *size)
+{
+  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+  gint px_size   = GEGL_TILE_BACKEND (self)->priv->px_size;
+  gint n_pixels  = tile_size / px_size;
+  gint rle_size;
+  gint i;
+
+  *encoded = data;
+  *size    = tile_size;
+
+  if (!self->compression)
+    return GEGL_TILE_CODEC_NONE;
+
+  for (i = 1; i < n_pixels; i++)
+    if (memcmp (data, data + i * px_size, px_size))
+      break;
+
+  if (i == n_pixels)
+    {
+      *size = px_size;
+      return GEGL_TILE_CODEC_CONSTANT;
+    }
+
+  if (!self->codec_buf)
+    self->codec_buf = g_malloc (tile_size);
+
+  rle_size = gegl_tile_backend_file_rle_encode (data, n_pixels, px_size,
+                                                self->codec_buf, tile_size - 1);
+  if (rle_size < 0)
+    return GEGL_TILE_CODEC_NONE;
+
+  *encoded = self->codec_buf;
+  *size    = rle_size;
+  return GEGL_TILE_CODEC_RLE;
+}
+
+void
+gegl_tile_backend_file_decode (guint32       codec,
+                               const guchar *src,
+                               gint          size,
+                               guchar       *dest,
+                               gint          tile_size,
+                               gint          px_size)
+{
+  gint i = 0;
+  gint o = 0;
+
+  switch (codec)
+    {
+      case GEGL_TILE_CODEC_NONE:
+        memcpy (dest, src, MIN (size, tile_size));
+        break;
+
+      case GEGL_TILE_CODEC_CONSTANT:
+        for (o = 0; o + px_size <= tile_size; o += px_size)
+          memcpy (dest + o, src, px_size);
+        break;
+
+      case GEGL_TILE_CODEC_RLE:
+        while (i < size && o < tile_size)
+          {
+            guint control = src[i++];
+
+            if (control < 128)
+              {
+                gint bytes = (control + 1) * px_size;
+
+                bytes = MIN (bytes, MIN (tile_size - o, size - i));
+                memcpy (dest + o, src + i, bytes);
+                i += bytes;
+                o += bytes;
+              }
+            else
+              {
+                gint run = control - 126;
+
+                if (i + px_size > size)
+                  break;
+                while (run-- && o + px_size <= tile_size)
+                  {
+                    memcpy (dest + o, src + i, px_size);
+                    o += px_size;
+                  }
+                i += px_size;
+              }
+          }
+        if (o < tile_size)
+          g_warning ("corrupt tile data, decoded %i of %i bytes", o, tile_size);
+        break;
+
+      default:
+        g_warning ("unknown tile codec %u", codec);
+        memset (dest, 0, tile_size);
+        break;
+    }
+}
+
+#ifndef G_OS_WIN32
+
+/* tile data waiting to be written by the writer thread */
+typedef struct
+{
+  GeglTileBackendFile *file;
+  gint                 fd;
+  guint64              offset;
+  guint                size;
+  guchar              *data;
+  gboolean             cancelled; /* superseded or freed before written */
+} GeglFileWrite;
+
+/* a single writer thread serves all files with async writes enabled,
+ * write_mutex protects the queue as well as the pending tables and
+ * counts of the files.
+ */
+static GStaticMutex  write_mutex       = G_STATIC_MUTEX_INIT;
+static GCond        *write_cond        = NULL; /* work has been queued */
+static GCond        *write_done_cond   = NULL; /* work has been completed */
+static GQueue        write_queue       = G_QUEUE_INIT;
+static gint          write_queue_bytes = 0;
+static GThread      *writer            = NULL;
+static gboolean      writer_quit       = FALSE; /* exit once the queue is empty */
+
+/* the writes in a batch are sorted by file and offset so that
+ * adjacent tiles go out as a single write, writes to the same offset
+ * never appear twice in a batch since the older one is cancelled.
+ */
+static gint
+gegl_file_write_compare (gconstpointer a,
+                         gconstpointer b)
+{
+  const GeglFileWrite *wa = a;
+  const GeglFileWrite *wb = b;
+
+  if (wa->fd != wb->fd)
+    return wa->fd < wb->fd ? -1 : 1;
+  if (wa->offset != wb->offset)
+    return wa->offset < wb->offset ? -1 : 1;
+  return 0;
+}
+
+static void
+gegl_file_write_out (gint          fd,
+                     guint64       offset,
+                     const guchar *data,
+                     gsize         size)
+{
+  while (size > 0)
+    {
+      gssize wrote = pwrite (fd, data, size, offset);
+
+      if (wrote <= 0)
+        {
+          g_message ("unable to write tile data to swap: %s (%d bytes left)",
+                     g_strerror (errno), (gint) size);
+          return;
+        }
+      data   += wrote;
+      offset += wrote;
+      size   -= wrote;
+    }
+}
+
+static gpointer
+gegl_file_writer_thread (gpointer data)
+{
+  GMutex *mutex = g_static_mutex_get_mutex (&write_mutex);
+  GList  *batch;
+  GList  *cancelled;
+  GList  *iter;
+
+  g_mutex_lock (mutex);
+  while (TRUE)
+    {
+      while (g_queue_is_empty (&write_queue) && !writer_quit)
+        g_cond_wait (write_cond, mutex);
+
+      if (g_queue_is_empty (&write_queue))
+        break;
+
+      /* writes cancelled later on still go out, a newer write to the
+       * same offset is queued after them
+       */
+      batch     = NULL;
+      cancelled = NULL;
+      while (!g_queue_is_empty (&write_queue))
+        {
+          GeglFileWrite *write = g_queue_pop_tail (&write_queue);
+
+          if (write->cancelled)
+            cancelled = g_list_prepend (cancelled, write);
+          else
+            batch = g_list_prepend (batch, write);
+        }
+      g_mutex_unlock (mutex);
+
+      batch = g_list_sort (batch, gegl_file_write_compare);
+
+      for (iter = batch; iter;)
+        {
+          GeglFileWrite *first = iter->data;
+          GList         *end   = iter->next;
+          gsize          size  = first->size;
+
+          /* gather the run of contiguous writes to the same file */
+          while (end)
+            {
+              GeglFileWrite *next = end->data;
+
+              if (next->fd != first->fd ||
+                  next->offset != first->offset + size)
+                break;
+              size += next->size;
+              end = end->next;
+            }
+
+          if (iter->next == end)
+            {
+              gegl_file_write_out (first->fd, first->offset, first->data, size);
+            }
+          else
+            {
+              guchar *run = g_malloc (size);
+              gsize   pos = 0;
+              GList  *i;
+
+              for (i = iter; i != end; i = i->next)
+                {
+                  GeglFileWrite *write = i->data;
+
+                  memcpy (run + pos, write->data, write->size);
+                  pos += write->size;
+                }
+              gegl_file_write_out (first->fd, first->offset, run, size);
+              g_free (run);
+            }
+          iter = end;
+        }
+
+      batch = g_list_concat (batch, cancelled);
+
+      g_mutex_lock (mutex);
+      for (iter = batch; iter; iter = iter->next)
+        {
+          GeglFileWrite *write = iter->data;
+          gpointer       key   = GSIZE_TO_POINTER ((gsize) write->offset);
+
+          if (g_hash_table_lookup (write->file->pending, key) == write)
+            g_hash_table_remove (write->file->pending, key);
+          write->file->pending_count--;
+          write_queue_bytes -= write->size;
+
+          g_free (write->data);
+          g_slice_free (GeglFileWrite, write);
+        }
+      g_list_free (batch);
+      g_cond_broadcast (write_done_cond);
+    }
+
+  g_mutex_unlock (mutex);
+  return NULL;
+}
+
+/* queues size bytes of source to be written at offset, blocking while
+ * more than the configured swap queue size is waiting to be written.
+ */
+static void
+gegl_tile_backend_file_queue_write (GeglTileBackendFile *self,
+                                    guint64              offset,
+                                    const guchar        *source,
+                                    guint                size)
+{
+  GMutex        *mutex = g_static_mutex_get_mutex (&write_mutex);
+  GeglFileWrite *write;
+  GeglFileWrite *old;
+  gpointer       key   = GSIZE_TO_POINTER ((gsize) offset);
+
+  write = g_slice_new (GeglFileWrite);
+  write->file      = self;
+  write->fd        = self->o;
+  write->offset    = offset;
+  write->size      = size;
+  write->data      = g_memdup (source, size);
+  write->cancelled = FALSE;
+
+  g_mutex_lock (mutex);
+  if (!writer)
+    {
+      write_cond      = g_cond_new ();
+      write_done_cond = g_cond_new ();
+      writer = g_thread_create (gegl_file_writer_thread, NULL, TRUE, NULL);
+    }
+
+  while (write_queue_bytes > 0 &&
+         write_queue_bytes + size > gegl_config ()->swap_queue_size)
+    g_cond_wait (write_done_cond, mutex);
+
+  old = g_hash_table_lookup (self->pending, key);
+  if (old)
+    old->cancelled = TRUE;
+  g_hash_table_insert (self->pending, key, write);
+
+  g_queue_push_tail (&write_queue, write);
+  write_queue_bytes += size;
+  self->pending_count++;
+  g_cond_signal (write_cond);
+  g_mutex_unlock (mutex);
+}
+
+/* drops a queued write to a slot that has been freed */
+static void
+gegl_tile_backend_file_cancel_write (GeglTileBackendFile *self,
+                                     guint64              offset)
+{
+  GMutex        *mutex = g_static_mutex_get_mutex (&write_mutex);
+  GeglFileWrite *write;
+  gpointer       key   = GSIZE_TO_POINTER ((gsize) offset);
+
+  if (!self->pending)
+    return;
+
+  g_mutex_lock (mutex);
+  write = g_hash_table_lookup (self->pending, key);
+  if (write)
+    {
+      write->cancelled = TRUE;
+      g_hash_table_remove (self->pending, key);
+    }
+  g_mutex_unlock (mutex);
+}
+
+/* serves a read of data still waiting to be written from memory */
+static gboolean
+gegl_tile_backend_file_read_pending (GeglTileBackendFile *self,
+                                     guint64              offset,
+                                     guchar              *dest)
+{
+  GMutex        *mutex = g_static_mutex_get_mutex (&write_mutex);
+  GeglFileWrite *write;
+
+  if (!self->pending)
+    return FALSE;
+
+  g_mutex_lock (mutex);
+  write = g_hash_table_lookup (self->pending, GSIZE_TO_POINTER ((gsize) offset));
+  if (write)
+    memcpy (dest, write->data, write->size);
+  g_mutex_unlock (mutex);
+
+  return write != NULL;
+}
+
+/* writes out everything queued and stops the writer thread */
+void
+gegl_tile_backend_file_cleanup (void)
+{
+  GMutex *mutex = g_static_mutex_get_mutex (&write_mutex);
+
+  g_mutex_lock (mutex);
+  if (!writer)
+    {
+      g_mutex_unlock (mutex);
+      return;
+    }
+  writer_quit = TRUE;
+  g_cond_signal (write_cond);
+  g_mutex_unlock (mutex);
+
+  g_thread_join (writer);
+
+  g_mutex_lock (mutex);
+  g_cond_free (write_cond);
+  g_cond_free (write_done_cond);
+  write_cond      = NULL;
+  write_done_cond = NULL;
+  writer          = NULL;
+  writer_quit     = FALSE;
+  g_mutex_unlock (mutex);
+}
+
+/* waits until all writes queued for the file have been done */
+static void
+gegl_tile_backend_file_drain (GeglTileBackendFile *self)
+{
+  GMutex *mutex = g_static_mutex_get_mutex (&write_mutex);
+
+  if (!self->pending)
+    return;
+
+  g_mutex_lock (mutex);
+  while (self->pending_count > 0)
+    g_cond_wait (write_done_cond, mutex);
+  g_mutex_unlock (mutex);
+}
+
+#else
+
+void
+gegl_tile_backend_file_cleanup (void)
+{
+}
+
+#endif
+
+/* reads the data stored for the entry as is, without decoding it */
+static void
+gegl_tile_backend_file_read_raw (GeglTileBackendFile *self,
+                                 GeglBufferTile      *entry,
+                                 guchar              *tdest)
 {
   gint     to_be_read;
+  gint     size;
   gboolean success;
   gint     tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
   goffset  offset = entry->offset;
-  guchar  *tdest = dest;
 
   gegl_tile_backend_file_ensure_exist (self);
 
+#ifndef G_OS_WIN32
+  if (gegl_tile_backend_file_read_pending (self, offset, tdest))
+    return;
+#endif
+
+  size = entry->size ? entry->size : tile_size;
+
   if (self->foffset != offset)
     {
       success = (lseek (self->i, offset, SEEK_SET) >= 0);
@@ -142,14 +865,14 @@ gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
         }
       self->foffset = offset;
     }
-  to_be_read = tile_size;
+  to_be_read = size;
 
   while (to_be_read > 0)
     {
       GError *error = NULL;
       gint byte_read;
 
-      byte_read = read (self->i, tdest + tile_size - to_be_read, to_be_read);
+      byte_read = read (self->i, tdest + size - to_be_read, to_be_read);
       if (byte_read <= 0)
         {
           g_message ("unable to read tile data from self: "
@@ -160,8 +883,30 @@ gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
       to_be_read -= byte_read;
       self->foffset += byte_read;
     }
+}
 
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "read entry %i,%i,%i at %i", entry->x, entry->y, entry->z, (gint)offset);
+static inline void
+gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
+                                        GeglBufferTile      *entry,
+                                        guchar              *dest)
+{
+  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+  if (entry->codec == GEGL_TILE_CODEC_NONE)
+    {
+      gegl_tile_backend_file_read_raw (self, entry, dest);
+    }
+  else
+    {
+      if (!self->codec_buf)
+        self->codec_buf = g_malloc (tile_size);
+      gegl_tile_backend_file_read_raw (self, entry, self->codec_buf);
+      gegl_tile_backend_file_decode (entry->codec, self->codec_buf,
+                                     entry->size, dest, tile_size,
+                                     GEGL_TILE_BACKEND (self)->priv->px_size);
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "read entry %i,%i,%i at %i", entry->x, entry->y, entry->z, (gint)entry->offset);
 }
 
 static inline void
@@ -172,10 +917,22 @@ gegl_tile_backend_file_file_entry_write (GeglTileBackendFile *self,
   gint     to_be_written;
   gboolean success;
   goffset  offset = entry->offset;
-  gint     tile_size;
+  gint     size;
 
   gegl_tile_backend_file_ensure_exist (self);
 
+  size = entry->size ? entry->size :
+                       gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+#ifndef G_OS_WIN32
+  if (self->pending)
+    {
+      gegl_tile_backend_file_queue_write (self, offset, source, size);
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "queued entry %i,%i,%i at %i", entry->x, entry->y, entry->z, (gint)offset);
+      return;
+    }
+#endif
+
   if (self->foffset != offset)
     {
       success = (lseek (self->o, offset, SEEK_SET) >= 0);
@@ -187,15 +944,13 @@ gegl_tile_backend_file_file_entry_write (GeglTileBackendFile *self,
       self->foffset = offset;
     }
 
-  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
-
-  to_be_written = tile_size;
+  to_be_written = size;
 
   while (to_be_written > 0)
     {
       gint wrote;
       wrote = write (self->o,
-                     source + tile_size - to_be_written,
+                     source + size - to_be_written,
                      to_be_written);
       if (wrote <= 0)
         {
@@ -210,48 +965,385 @@ gegl_tile_backend_file_file_entry_write (GeglTileBackendFile *self,
   GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "wrote entry %i,%i,%i at %i", entry->x, entry->y, entry->z, (gint)offset);
 }
 
-static inline GeglBufferTile *
-gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+/* the free list bucket holding extents of size bytes, bucket n holds
+ * extents of 2^n up to 2^(n+1) slots, the last one everything larger
+ */
+static inline gint
+gegl_tile_backend_file_bucket (guint size)
 {
-  GeglBufferTile *entry = gegl_tile_entry_new (0,0,0);
+  gint bucket = g_bit_storage (size / GEGL_FILE_SLOT_ALIGN) - 1;
 
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
+  return CLAMP (bucket, 0, GEGL_FILE_FREE_BUCKETS - 1);
+}
+
+static void
+gegl_tile_backend_file_add_free (GeglTileBackendFile *self,
+                                 GeglFileExtent      *extent)
+{
+  gint bucket = gegl_tile_backend_file_bucket (extent->size);
+
+  self->free_list[bucket] = g_slist_prepend (self->free_list[bucket], extent);
+}
+
+/* takes size bytes from the start of the extent in the given bucket,
+ * filing what remains under its new size
+ */
+static guint64
+gegl_tile_backend_file_take (GeglTileBackendFile *self,
+                             gint                 bucket,
+                             GSList              *link,
+                             guint                size)
+{
+  GeglFileExtent *extent = link->data;
+  guint64         offset = extent->offset;
+
+  self->free_list[bucket] = g_slist_delete_link (self->free_list[bucket], link);
+  self->dead_bytes -= size;
+  gegl_tile_backend_file_dbg_dead (-(gint) size);
+
+  extent->offset += size;
+  extent->size   -= size;
+
+  if (extent->size)
+    gegl_tile_backend_file_add_free (self, extent);
+  else
+    g_slice_free (GeglFileExtent, extent);
+
+  return offset;
+}
+
+/* finds free space of size bytes located before limit, returns
+ * G_MAXUINT64 if there is none
+ */
+static guint64
+gegl_tile_backend_file_alloc_below (GeglTileBackendFile *self,
+                                    guint                size,
+                                    guint64              limit)
+{
+  gint    bucket = gegl_tile_backend_file_bucket (size);
+  GSList *iter;
+
+  /* extents in the bucket of size itself might be too small and are
+   * scanned, in the larger buckets any extent fits and the head is taken
+   */
+  for (iter = self->free_list[bucket]; iter; iter = iter->next)
+    {
+      GeglFileExtent *extent = iter->data;
+
+      if (extent->size >= size && extent->offset < limit)
+        return gegl_tile_backend_file_take (self, bucket, iter, size);
+    }
+
+  for (bucket++; bucket < GEGL_FILE_FREE_BUCKETS; bucket++)
+    {
+      iter = self->free_list[bucket];
+
+      if (iter && ((GeglFileExtent *) iter->data)->offset < limit)
+        return gegl_tile_backend_file_take (self, bucket, iter, size);
+    }
+
+  return G_MAXUINT64;
+}
+
+/* hands out size bytes of the file, reusing free space when there is
+ * an extent large enough, otherwise the file is grown.
+ */
+static guint64
+gegl_tile_backend_file_alloc (GeglTileBackendFile *self,
+                              guint                size)
+{
+  guint64 offset;
 
   gegl_tile_backend_file_ensure_exist (self);
 
-  if (self->free_list)
+  offset = gegl_tile_backend_file_alloc_below (self, size, G_MAXUINT64);
+  if (offset != G_MAXUINT64)
     {
-      /* XXX: losing precision ?
-       * the free list seems to operate with fixed size datums and
-       * only keep track of offsets.
-       */
-      gint offset = GPOINTER_TO_INT (self->free_list->data);
-      entry->offset = offset;
-      self->free_list = g_slist_remove (self->free_list, self->free_list->data);
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i from free list", (gint)offset);
+      return offset;
+    }
+
+  offset = self->next_pre_alloc;
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i (next allocation)", (gint)offset);
+  self->next_pre_alloc += size;
+
+  if (self->next_pre_alloc >= self->total) /* automatic growing ensuring that
+                                              we have room for next allocation..
+                                            */
+    {
+      gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+      if (self->mmap)
+        self->total = self->total + MAX (32 * tile_size, GEGL_FILE_MMAP_EXTENT);
+      else
+        self->total = self->total + 32 * tile_size;
+
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "growing file to %i bytes", (gint)self->total);
 
-      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i from free list", ((gint)entry->offset));
+      if (ftruncate (self->o, self->total) == -1)
+        GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "unable to grow %s: %s",
+                   self->path, g_strerror (errno));
+      self->foffset = -1;
     }
+  return offset;
+}
+
+static void
+gegl_tile_backend_file_free (GeglTileBackendFile *self,
+                             guint64              offset,
+                             guint                size)
+{
+  GeglFileExtent *extent;
+
+  if (size == 0)
+    return;
+
+#ifndef G_OS_WIN32
+  gegl_tile_backend_file_cancel_write (self, offset);
+#endif
+
+  extent = g_slice_new (GeglFileExtent);
+  extent->offset = offset;
+  extent->size   = size;
+
+  self->dead_bytes += size;
+  gegl_tile_backend_file_dbg_dead (size);
+
+  /* tiles might still be showing the mapped data */
+  if (gegl_tile_backend_file_slot_busy (self, offset))
+    self->retired = g_slist_prepend (self->retired, extent);
   else
+    gegl_tile_backend_file_add_free (self, extent);
+}
+
+/* moves the retired extents no tile is showing anymore to the free
+ * list, only done when idle as it walks all of them.
+ */
+static void
+gegl_tile_backend_file_sweep_retired (GeglTileBackendFile *self)
+{
+  GSList *iter;
+
+  for (iter = self->retired; iter;)
     {
-      gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+      GeglFileExtent *extent = iter->data;
 
-      entry->offset = self->next_pre_alloc;
-      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i (next allocation)", (gint)entry->offset);
-      self->next_pre_alloc += tile_size;
+      iter = iter->next;
+      if (!gegl_tile_backend_file_slot_busy (self, extent->offset))
+        {
+          self->retired = g_slist_remove (self->retired, extent);
+          gegl_tile_backend_file_add_free (self, extent);
+        }
+    }
+}
 
-      if (self->next_pre_alloc >= self->total) /* automatic growing ensuring that
-                                                  we have room for next allocation..
-                                                */
+static void
+gegl_tile_backend_file_free_list_clear (GeglTileBackendFile *self)
+{
+  GSList *iter;
+  gint    bucket;
+
+  for (bucket = 0; bucket < GEGL_FILE_FREE_BUCKETS; bucket++)
+    {
+      for (iter = self->free_list[bucket]; iter; iter = iter->next)
+        g_slice_free (GeglFileExtent, iter->data);
+      g_slist_free (self->free_list[bucket]);
+      self->free_list[bucket] = NULL;
+    }
+
+  for (iter = self->retired; iter; iter = iter->next)
+    g_slice_free (GeglFileExtent, iter->data);
+  g_slist_free (self->retired);
+  self->retired = NULL;
+
+  gegl_tile_backend_file_dbg_dead (-(gint) self->dead_bytes);
+  self->dead_bytes  = 0;
+}
+
+static gint
+gegl_file_extent_compare (gconstpointer a,
+                          gconstpointer b)
+{
+  const GeglFileExtent *ea = a;
+  const GeglFileExtent *eb = b;
+
+  if (ea->offset == eb->offset)
+    return 0;
+  return ea->offset < eb->offset ? -1 : 1;
+}
+
+/* merges adjacent free extents and gives free space at the end of the
+ * file back, retired extents are left alone.
+ */
+static void
+gegl_tile_backend_file_coalesce (GeglTileBackendFile *self)
+{
+  GSList *extents = NULL;
+  GSList *iter;
+  GSList *merged  = NULL;
+  gint    bucket;
+
+  for (bucket = 0; bucket < GEGL_FILE_FREE_BUCKETS; bucket++)
+    {
+      extents = g_slist_concat (self->free_list[bucket], extents);
+      self->free_list[bucket] = NULL;
+    }
+  extents = g_slist_sort (extents, gegl_file_extent_compare);
+
+  for (iter = extents; iter; iter = iter->next)
+    {
+      GeglFileExtent *extent = iter->data;
+      GeglFileExtent *last   = merged ? merged->data : NULL;
+
+      if (last && last->offset + last->size == extent->offset)
+        {
+          last->size += extent->size;
+          g_slice_free (GeglFileExtent, extent);
+        }
+      else
         {
-          self->total = self->total + 32 * tile_size;
+          merged = g_slist_prepend (merged, extent);
+        }
+    }
+  g_slist_free (extents);
 
-          GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "growing file to %i bytes", (gint)self->total);
+  /* merged is in descending order, the tail of the file comes first */
+  if (merged)
+    {
+      GeglFileExtent *last = merged->data;
 
-          ftruncate (self->o, self->total);
-          self->foffset = -1;
+      if (last->offset + last->size == self->next_pre_alloc)
+        {
+          self->next_pre_alloc = last->offset;
+          self->dead_bytes    -= last->size;
+          gegl_tile_backend_file_dbg_dead (-(gint) last->size);
+          merged = g_slist_delete_link (merged, merged);
+          g_slice_free (GeglFileExtent, last);
         }
     }
-  gegl_tile_backend_file_dbg_alloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
+
+  for (iter = merged; iter; iter = iter->next)
+    gegl_tile_backend_file_add_free (self, iter->data);
+  g_slist_free (merged);
+}
+
+static gint
+gegl_buffer_tile_compare_offset (gconstpointer a,
+                                 gconstpointer b)
+{
+  const GeglBufferTile *ea = a;
+  const GeglBufferTile *eb = b;
+
+  if (ea->offset == eb->offset)
+    return 0;
+  return ea->offset > eb->offset ? -1 : 1;
+}
+
+static gpointer gegl_tile_backend_file_flush (GeglTileSource *source,
+                                               GeglTile       *tile,
+                                               gint            x,
+                                               gint            y,
+                                               gint            z);
+
+/* one step of online compaction, done when at least half of the file is
+ * dead space: the tiles stored last in the file are moved into free
+ * space in front of them, and the file is truncated after the last
+ * tile. An index written by an earlier flush no longer matches the
+ * file afterwards and is written anew. Returns TRUE if anything was done.
+ */
+static gboolean
+gegl_tile_backend_file_compact (GeglTileBackendFile *self)
+{
+  GeglTileBackend *backend   = GEGL_TILE_BACKEND (self);
+  gint             tile_size = gegl_tile_backend_get_tile_size (backend);
+  guint64          old_end   = self->next_pre_alloc;
+  GList           *entries;
+  GList           *iter;
+  guchar          *buf;
+  gint             moved = 0;
+
+  gegl_tile_backend_file_sweep_retired (self);
+
+  if (!self->exist || backend->priv->shared ||
+      self->dead_bytes < GEGL_FILE_COMPACT_MIN ||
+      self->dead_bytes * 2 < self->next_pre_alloc - 256)
+    return FALSE;
+
+  gegl_tile_backend_file_coalesce (self);
+
+  entries = g_hash_table_get_keys (self->index);
+  entries = g_list_sort (entries, gegl_buffer_tile_compare_offset);
+  buf     = g_malloc (tile_size);
+
+  for (iter = entries; iter && moved < GEGL_FILE_COMPACT_BATCH; iter = iter->next)
+    {
+      GeglBufferTile *entry = iter->data;
+      guint           slot  = GEGL_FILE_SLOT_SIZE (entry->size, tile_size);
+      guint64         offset;
+
+      if (gegl_tile_backend_file_slot_busy (self, entry->offset))
+        break;
+
+      offset = gegl_tile_backend_file_alloc_below (self, slot, entry->offset);
+      if (offset == G_MAXUINT64)
+        break;
+
+      gegl_tile_backend_file_read_raw (self, entry, buf);
+      gegl_tile_backend_file_free (self, entry->offset, slot);
+      entry->offset = offset;
+      gegl_tile_backend_file_file_entry_write (self, entry, buf);
+      moved++;
+    }
+
+  g_free (buf);
+  g_list_free (entries);
+
+  gegl_tile_backend_file_coalesce (self);
+
+  if (self->next_pre_alloc < old_end)
+    {
+#ifndef G_OS_WIN32
+      /* cancelled writes might still land past the new end */
+      gegl_tile_backend_file_drain (self);
+#endif
+      self->total = self->next_pre_alloc;
+      if (ftruncate (self->o, self->total) == -1)
+        GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "unable to shrink %s: %s",
+                   self->path, g_strerror (errno));
+      self->foffset = -1;
+    }
+
+  if (self->header.next && (moved > 0 || self->next_pre_alloc < old_end))
+    gegl_tile_backend_file_flush (GEGL_TILE_SOURCE (self), NULL, 0, 0, 0);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "compacted %s, moved %i tiles, %i bytes file, %i dead",
+             self->path, moved, (gint) self->next_pre_alloc, (gint) self->dead_bytes);
+
+  return moved > 0 || self->next_pre_alloc < old_end;
+}
+
+void
+gegl_tile_backend_file_get_stats (GeglTileBackendFile *self,
+                                  guint64             *live_bytes,
+                                  guint64             *dead_bytes)
+{
+  if (live_bytes)
+    *live_bytes = self->live_bytes;
+  if (dead_bytes)
+    *dead_bytes = self->dead_bytes;
+}
+
+static inline GeglBufferTile *
+gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+{
+  GeglBufferTile *entry = gegl_tile_entry_new (0,0,0);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
+
+  /* space in the file is allocated when the size of the encoded tile
+   * is known, in set_tile
+   */
+  gegl_tile_backend_file_ensure_exist (self);
   return entry;
 }
 
@@ -259,13 +1351,14 @@ static inline void
 gegl_tile_backend_file_file_entry_destroy (GeglBufferTile      *entry,
                                            GeglTileBackendFile *self)
 {
-  /* XXX: EEEk, throwing away bits */
-  guint offset = entry->offset;
-  self->free_list = g_slist_prepend (self->free_list,
-                                     GUINT_TO_POINTER (offset));
+  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+  gint slot      = GEGL_FILE_SLOT_SIZE (entry->size, tile_size);
+
+  gegl_tile_backend_file_free (self, entry->offset, slot);
   g_hash_table_remove (self->index, entry);
 
-  gegl_tile_backend_file_dbg_dealloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
+  self->live_bytes -= slot;
+  gegl_tile_backend_file_dbg_dealloc (slot);
   g_free (entry);
 }
 
@@ -372,13 +1465,15 @@ static gint allocs         = 0;
 static gint file_size      = 0;
 static gint peak_allocs    = 0;
 static gint peak_file_size = 0;
+static gint dead_size      = 0;
 
 void
 gegl_tile_backend_file_stats (void)
 {
-  g_warning ("leaked: %i chunks (%f mb)  peak: %i (%i bytes %fmb))",
+  g_warning ("leaked: %i chunks (%f mb)  peak: %i (%i bytes %fmb))  dead: %fmb",
              allocs, file_size / 1024 / 1024.0,
-             peak_allocs, peak_file_size, peak_file_size / 1024 / 1024.0);
+             peak_allocs, peak_file_size, peak_file_size / 1024 / 1024.0,
+             dead_size / 1024 / 1024.0);
 }
 
 static void
@@ -399,6 +1494,12 @@ gegl_tile_backend_file_dbg_dealloc (gint size)
   file_size -= size;
 }
 
+static void
+gegl_tile_backend_file_dbg_dead (gint size)
+{
+  dead_size += size;
+}
+
 static inline GeglBufferTile *
 gegl_tile_backend_file_lookup_entry (GeglTileBackendFile *self,
               gint                 x,
@@ -437,6 +1538,40 @@ gegl_tile_backend_file_get_tile (GeglTileSource *self,
     return NULL;
 
   tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+#ifdef HAVE_SYS_MMAN_H
+  if (tile_backend_file->mmap
+#ifndef G_OS_WIN32
+      && !tile_backend_file->pending
+#endif
+      )
+    {
+      gint    size = entry->size ? entry->size : tile_size;
+      guchar *data = gegl_tile_backend_file_map (tile_backend_file,
+                                                 entry->offset, size);
+
+      if (data)
+        {
+          if (entry->codec == GEGL_TILE_CODEC_NONE)
+            {
+              tile = gegl_tile_new_bare ();
+              gegl_tile_backend_file_borrow (tile_backend_file, tile,
+                                             data, entry->offset);
+            }
+          else
+            {
+              tile = gegl_tile_new (tile_size);
+              gegl_tile_backend_file_decode (entry->codec, data, size,
+                                             gegl_tile_get_data (tile), tile_size,
+                                             backend->priv->px_size);
+            }
+          gegl_tile_set_rev (tile, entry->rev);
+          gegl_tile_mark_as_stored (tile);
+          return tile;
+        }
+    }
+#endif
+
   tile      = gegl_tile_new (tile_size);
   gegl_tile_set_rev (tile, entry->rev);
   gegl_tile_mark_as_stored (tile);
@@ -455,10 +1590,21 @@ gegl_tile_backend_file_set_tile (GeglTileSource *self,
   GeglTileBackend     *backend;
   GeglTileBackendFile *tile_backend_file;
   GeglBufferTile      *entry;
+  guchar              *data;
+  guint32              size;
+  guint32              codec;
+  guint                slot;
+  gint                 tile_size;
 
   backend           = GEGL_TILE_BACKEND (self);
   tile_backend_file = GEGL_TILE_BACKEND_FILE (backend);
   entry             = gegl_tile_backend_file_lookup_entry (tile_backend_file, x, y, z);
+  tile_size         = gegl_tile_backend_get_tile_size (backend);
+
+  codec = gegl_tile_backend_file_encode (tile_backend_file,
+                                         gegl_tile_get_data (tile),
+                                         &data, &size);
+  slot  = GEGL_FILE_SLOT_SIZE (size, tile_size);
 
   if (entry == NULL)
     {
@@ -466,11 +1612,39 @@ gegl_tile_backend_file_set_tile (GeglTileSource *self,
       entry->x = x;
       entry->y = y;
       entry->z = z;
+      entry->offset = gegl_tile_backend_file_alloc (tile_backend_file, slot);
       g_hash_table_insert (tile_backend_file->index, entry, entry);
+      tile_backend_file->live_bytes += slot;
+      gegl_tile_backend_file_dbg_alloc (slot);
     }
-  entry->rev = gegl_tile_get_rev (tile);
+  else
+    {
+      guint old_slot = GEGL_FILE_SLOT_SIZE (entry->size, tile_size);
 
-  gegl_tile_backend_file_file_entry_write (tile_backend_file, entry, gegl_tile_get_data (tile));
+      /* rewrite in place when the encoded tile still fits, and no tile
+       * is using the mapped old data
+       */
+      if (slot <= old_slot &&
+          !gegl_tile_backend_file_slot_busy (tile_backend_file, entry->offset))
+        {
+          gegl_tile_backend_file_free (tile_backend_file,
+                                       entry->offset + slot, old_slot - slot);
+        }
+      else
+        {
+          gegl_tile_backend_file_free (tile_backend_file, entry->offset, old_slot);
+          entry->offset = gegl_tile_backend_file_alloc (tile_backend_file, slot);
+        }
+      tile_backend_file->live_bytes -= old_slot;
+      tile_backend_file->live_bytes += slot;
+      gegl_tile_backend_file_dbg_dealloc (old_slot);
+      gegl_tile_backend_file_dbg_alloc (slot);
+    }
+  entry->rev   = gegl_tile_get_rev (tile);
+  entry->size  = size;
+  entry->codec = codec;
+
+  gegl_tile_backend_file_file_entry_write (tile_backend_file, entry, data);
   gegl_tile_mark_as_stored (tile);
   return NULL;
 }
@@ -533,6 +1707,10 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
 
   gegl_tile_backend_file_ensure_exist (self);
 
+#ifndef G_OS_WIN32
+  gegl_tile_backend_file_drain (self);
+#endif
+
   GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "flushing %s", self->path);
 
 
@@ -568,7 +1746,10 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
 enum
 {
   PROP_0,
-  PROP_PATH
+  PROP_PATH,
+  PROP_COMPRESSION,
+  PROP_MMAP,
+  PROP_ASYNC_WRITES
 };
 
 static gpointer
@@ -579,32 +1760,46 @@ gegl_tile_backend_file_command (GeglTileSource  *self,
                                 gint             z,
                                 gpointer         data)
 {
+  GeglTileBackend *backend = GEGL_TILE_BACKEND (self);
+  gpointer         result  = NULL;
+
+  /* the index and the file are shared by all threads using the buffer */
+  g_mutex_lock (backend->priv->mutex);
   switch (command)
     {
       case GEGL_TILE_GET:
-        return gegl_tile_backend_file_get_tile (self, x, y, z);
+        result = gegl_tile_backend_file_get_tile (self, x, y, z);
+        break;
       case GEGL_TILE_SET:
-        return gegl_tile_backend_file_set_tile (self, data, x, y, z);
+        result = gegl_tile_backend_file_set_tile (self, data, x, y, z);
+        break;
 
       case GEGL_TILE_IDLE:
-        return NULL;       /* we could perhaps lazily be writing indexes
-                            * at some intervals, making it work as an
-                            * autosave for the buffer?
-                            */
+        /* we could perhaps lazily be writing indexes at some intervals,
+         * making it work as an autosave for the buffer?
+         */
+        result = GINT_TO_POINTER (
+                   gegl_tile_backend_file_compact (GEGL_TILE_BACKEND_FILE (self)));
+        break;
 
       case GEGL_TILE_VOID:
-        return gegl_tile_backend_file_void_tile (self, data, x, y, z);
+        result = gegl_tile_backend_file_void_tile (self, data, x, y, z);
+        break;
 
       case GEGL_TILE_EXIST:
-        return gegl_tile_backend_file_exist_tile (self, data, x, y, z);
+        result = gegl_tile_backend_file_exist_tile (self, data, x, y, z);
+        break;
       case GEGL_TILE_FLUSH:
-        return gegl_tile_backend_file_flush (self, data, x, y, z);
+        result = gegl_tile_backend_file_flush (self, data, x, y, z);
+        break;
 
       default:
         g_assert (command < GEGL_TILE_LAST_COMMAND &&
                   command >= 0);
     }
-  return FALSE;
+  g_mutex_unlock (backend->priv->mutex);
+
+  return result;
 }
 
 static void
@@ -623,6 +1818,18 @@ gegl_tile_backend_file_set_property (GObject      *object,
         self->path = g_value_dup_string (value);
         break;
 
+      case PROP_COMPRESSION:
+        self->compression = g_value_get_boolean (value);
+        break;
+
+      case PROP_MMAP:
+        self->mmap = g_value_get_boolean (value);
+        break;
+
+      case PROP_ASYNC_WRITES:
+        self->async_writes = g_value_get_boolean (value);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -643,6 +1850,18 @@ gegl_tile_backend_file_get_property (GObject    *object,
         g_value_set_string (value, self->path);
         break;
 
+      case PROP_COMPRESSION:
+        g_value_set_boolean (value, self->compression);
+        break;
+
+      case PROP_MMAP:
+        g_value_set_boolean (value, self->mmap);
+        break;
+
+      case PROP_ASYNC_WRITES:
+        g_value_set_boolean (value, self->async_writes);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -654,9 +1873,31 @@ gegl_tile_backend_file_finalize (GObject *object)
 {
   GeglTileBackendFile *self = (GeglTileBackendFile *) object;
 
+#ifndef G_OS_WIN32
+  /* the writer thread is still using the file descriptor */
+  if (self->pending)
+    {
+      gegl_tile_backend_file_drain (self);
+      g_hash_table_unref (self->pending);
+    }
+#endif
+
   if (self->index)
     g_hash_table_unref (self->index);
 
+  gegl_tile_backend_file_free_list_clear (self);
+
+  if (self->codec_buf)
+    g_free (self->codec_buf);
+
+#ifdef HAVE_SYS_MMAN_H
+  /* tiles still borrowing mapped data keep the mapping alive */
+  if (self->window)
+    gegl_file_window_unref (self->window);
+  if (self->map)
+    gegl_file_map_unref (self->map);
+#endif
+
   if (self->exist)
     {
       GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "finalizing buffer %s", self->path);
@@ -775,8 +2016,8 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
 
       GeglBufferItem *existing = g_hash_table_lookup (self->index, item);
 
-      if (item->tile.offset > max)
-        max = item->tile.offset + tile_size;
+      if (item->tile.offset + GEGL_FILE_SLOT_SIZE (item->tile.size, tile_size) > max)
+        max = item->tile.offset + GEGL_FILE_SLOT_SIZE (item->tile.size, tile_size);
 
       if (existing)
         {
@@ -819,8 +2060,18 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
       g_hash_table_insert (self->index, iter->data, iter->data);
     }
   g_list_free (self->tiles);
-  g_slist_free (self->free_list);
-  self->free_list      = NULL;
+  gegl_tile_backend_file_free_list_clear (self);
+
+  self->live_bytes = 0;
+  {
+    GHashTableIter  hiter;
+    GeglBufferTile *entry;
+
+    g_hash_table_iter_init (&hiter, self->index);
+    while (g_hash_table_iter_next (&hiter, (gpointer *) &entry, NULL))
+      self->live_bytes += GEGL_FILE_SLOT_SIZE (entry->size, tile_size);
+  }
+
   self->next_pre_alloc = max; /* if bigger than own? */
   self->total          = max;
   self->tiles          = NULL;
@@ -859,6 +2110,11 @@ gegl_tile_backend_file_constructor (GType                  type,
   self->i = self->o = -1;
   self->index = g_hash_table_new (gegl_tile_backend_file_hashfunc, gegl_tile_backend_file_equalfunc);
 
+#ifndef G_OS_WIN32
+  if (self->async_writes)
+    self->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+#endif
+
 
   /* If the file already exists open it, assuming it is a GeglBuffer. */
   if (access (self->path, F_OK) != -1)
@@ -986,6 +2242,30 @@ gegl_tile_backend_file_class_init (GeglTileBackendFileClass *klass)
                                                         NULL,
                                                         G_PARAM_CONSTRUCT |
                                                         G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_COMPRESSION,
+                                   g_param_spec_boolean ("compression",
+                                                         "compression",
+                                                         "Compress tiles written to the file",
+                                                         FALSE,
+                                                         G_PARAM_CONSTRUCT |
+                                                         G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_MMAP,
+                                   g_param_spec_boolean ("mmap",
+                                                         "mmap",
+                                                         "Read tiles through a memory mapping of the file",
+                                                         FALSE,
+                                                         G_PARAM_CONSTRUCT_ONLY |
+                                                         G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_ASYNC_WRITES,
+                                   g_param_spec_boolean ("async-writes",
+                                                         "async writes",
+                                                         "Write tiles from a background thread",
+                                                         FALSE,
+                                                         G_PARAM_CONSTRUCT_ONLY |
+                                                         G_PARAM_READWRITE));
 }
 
 static void
@@ -997,7 +2277,12 @@ gegl_tile_backend_file_init (GeglTileBackendFile *self)
   self->i              = -1;
   self->o              = -1;
   self->index          = NULL;
-  self->free_list      = NULL;
+  self->codec_buf      = NULL;
+  self->map            = NULL;
+  self->window         = NULL;
+  self->retired        = NULL;
+  self->pending        = NULL;
+  self->pending_count  = 0;
   self->next_pre_alloc = 256;  /* reserved space for header */
   self->total          = 256;  /* reserved space for header */
 }
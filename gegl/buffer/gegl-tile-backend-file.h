@@ -48,6 +48,26 @@ GType gegl_tile_backend_file_get_type (void) G_GNUC_CONST;
 
 void  gegl_tile_backend_file_stats    (void);
 
+/* writes out all queued swap writes and stops the writer thread */
+void  gegl_tile_backend_file_cleanup  (void);
+
+/* expands tile data stored with one of the GEGL_TILE_CODEC_* encodings
+ * into tile_size bytes at dest
+ */
+void     gegl_tile_backend_file_decode   (guint32              codec,
+                                          const guchar        *src,
+                                          gint                 size,
+                                          guchar              *dest,
+                                          gint                 tile_size,
+                                          gint                 px_size);
+
+/* bytes of the file used by tiles, and bytes free for reuse or waiting
+ * to be given back by compaction
+ */
+void     gegl_tile_backend_file_get_stats (GeglTileBackendFile *file,
+                                           guint64             *live_bytes,
+                                           guint64             *dead_bytes);
+
 gboolean gegl_tile_backend_file_try_lock (GeglTileBackendFile *file);
 gboolean gegl_tile_backend_file_unlock   (GeglTileBackendFile *file);
 
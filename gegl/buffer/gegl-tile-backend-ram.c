@@ -25,6 +25,7 @@
 #include "gegl-buffer-backend.h"
 #include "gegl-tile-backend.h"
 #include "gegl-tile-backend-ram.h"
+#include "gegl-buffer-types.h"
 
 static void dbg_alloc (int size);
 static void dbg_dealloc (int size);
@@ -37,6 +38,7 @@ struct _RamEntry
   gint    y;
   gint    z;
   guchar *offset;
+  GeglTile *constant; /* shared data of a constant tile, instead of offset */
 };
 
 static inline void
@@ -52,21 +54,47 @@ ram_entry_read (GeglTileBackendRam *ram,
 static inline void
 ram_entry_write (GeglTileBackendRam *ram,
                  RamEntry           *entry,
-                 guchar             *source)
+                 GeglTile           *tile)
 {
   gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
+  gint px_size   = GEGL_TILE_BACKEND (ram)->priv->px_size;
 
-  memcpy (entry->offset, source, tile_size);
+  if (gegl_tile_is_constant (tile))
+    {
+      /* keep a reference to the shared data instead of a copy */
+      if (entry->offset)
+        {
+          g_free (entry->offset);
+          entry->offset = NULL;
+          dbg_dealloc (tile_size);
+        }
+      if (entry->constant)
+        gegl_tile_unref (entry->constant);
+      entry->constant = gegl_tile_new_constant (tile_size, px_size,
+                                                gegl_tile_get_data (tile));
+      return;
+    }
+
+  if (entry->constant)
+    {
+      gegl_tile_unref (entry->constant);
+      entry->constant = NULL;
+    }
+  if (!entry->offset)
+    {
+      entry->offset = g_malloc (tile_size);
+      dbg_alloc (tile_size);
+    }
+  memcpy (entry->offset, gegl_tile_get_data (tile), tile_size);
 }
 
 static inline RamEntry *
 ram_entry_new (GeglTileBackendRam *ram)
 {
   RamEntry *self = g_slice_new (RamEntry);
-  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
 
-  self->offset = g_malloc (tile_size);
-  dbg_alloc (tile_size);
+  self->offset   = NULL;
+  self->constant = NULL;
   return self;
 }
 
@@ -75,10 +103,16 @@ ram_entry_destroy (RamEntry           *entry,
                    GeglTileBackendRam *ram)
 {
   gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
-  g_free (entry->offset);
+
+  if (entry->offset)
+    {
+      g_free (entry->offset);
+      dbg_dealloc (tile_size);
+    }
+  if (entry->constant)
+    gegl_tile_unref (entry->constant);
   g_hash_table_remove (ram->entries, entry);
 
-  dbg_dealloc (tile_size);
   g_slice_free (RamEntry, entry);
 }
 
@@ -152,6 +186,10 @@ get_tile (GeglTileSource *tile_store,
     if (!entry)
       return NULL;
 
+    if (entry->constant)
+      return gegl_tile_new_constant (tile_size, backend->priv->px_size,
+                                     gegl_tile_get_data (entry->constant));
+
     tile = gegl_tile_new (tile_size);
 
     ram_entry_read (tile_backend_ram, entry, gegl_tile_get_data (tile));
@@ -179,7 +217,7 @@ gboolean set_tile (GeglTileSource *store,
       entry->z = z;
       g_hash_table_insert (tile_backend_ram->entries, entry, entry);
     }
-  ram_entry_write (tile_backend_ram, entry, gegl_tile_get_data (tile));
+  ram_entry_write (tile_backend_ram, entry, tile);
   gegl_tile_mark_as_stored (tile);
   return TRUE;
 }
@@ -231,30 +269,39 @@ gegl_tile_backend_ram_command (GeglTileSource     *tile_store,
                                gint            z,
                                gpointer        data)
 {
+  GeglTileBackend *backend = GEGL_TILE_BACKEND (tile_store);
+  gpointer         result  = NULL;
+
+  /* the entries are shared by all threads using the buffer */
+  g_mutex_lock (backend->priv->mutex);
   switch (command)
     {
       case GEGL_TILE_GET:
-        return get_tile (tile_store, x, y, z);
+        result = get_tile (tile_store, x, y, z);
+        break;
 
       case GEGL_TILE_SET:
         set_tile (tile_store, data, x, y, z);
-        return NULL;
+        break;
 
       case GEGL_TILE_IDLE:
-        return NULL;
+        break;
 
       case GEGL_TILE_VOID:
         void_tile (tile_store, data, x, y, z);
-        return NULL;
+        break;
 
       case GEGL_TILE_EXIST:
-        return GINT_TO_POINTER(exist_tile (tile_store, data, x, y, z));
+        result = GINT_TO_POINTER(exist_tile (tile_store, data, x, y, z));
+        break;
 
       default:
         g_assert (command < GEGL_TILE_LAST_COMMAND &&
                   command >= 0);
     }
-  return FALSE;
+  g_mutex_unlock (backend->priv->mutex);
+
+  return result;
 }
 
 static void set_property (GObject       *object,
@@ -240,29 +240,40 @@ gegl_tile_backend_tiledir_command (GeglTileSource  *tile_store,
                                    gint             z,
                                    gpointer         data)
 {
+  GeglTileBackend *backend = GEGL_TILE_BACKEND (tile_store);
+  gpointer         result  = NULL;
+
+  /* the directory is shared by all threads using the buffer */
+  g_mutex_lock (backend->priv->mutex);
   switch (command)
     {
       case GEGL_TILE_GET:
-        return get_tile (tile_store, x, y, z);
+        result = get_tile (tile_store, x, y, z);
+        break;
 
       case GEGL_TILE_SET:
-        return set_tile (tile_store, data, x, y, z);
+        result = set_tile (tile_store, data, x, y, z);
+        break;
 
       case GEGL_TILE_IDLE:
         /* this backend has nothing to do on idle calls */
-        return NULL;
+        break;
 
       case GEGL_TILE_VOID:
-        return void_tile (tile_store, data, x, y, z);
+        result = void_tile (tile_store, data, x, y, z);
+        break;
 
       case GEGL_TILE_EXIST:
-        return GINT_TO_POINTER (exist_tile (tile_store, data, x, y, z));
+        result = GINT_TO_POINTER (exist_tile (tile_store, data, x, y, z));
+        break;
 
       default:
         g_assert (command < GEGL_TILE_LAST_COMMAND &&
                   command >= 0);
     }
-  return NULL;
+  g_mutex_unlock (backend->priv->mutex);
+
+  return result;
 }
 
 static void
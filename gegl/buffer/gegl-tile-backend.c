@@ -123,6 +123,16 @@ constructor (GType                  type,
   return object;
 }
 
+static void
+finalize (GObject *object)
+{
+  GeglTileBackend *backend = GEGL_TILE_BACKEND (object);
+
+  g_mutex_free (backend->priv->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gegl_tile_backend_class_init (GeglTileBackendClass *klass)
 {
@@ -133,6 +143,7 @@ gegl_tile_backend_class_init (GeglTileBackendClass *klass)
   gobject_class->set_property = set_property;
   gobject_class->get_property = get_property;
   gobject_class->constructor  = constructor;
+  gobject_class->finalize     = finalize;
 
   g_object_class_install_property (gobject_class, PROP_TILE_WIDTH,
                                    g_param_spec_int ("tile-width", "tile-width", "Tile width in pixels",
@@ -168,6 +179,7 @@ gegl_tile_backend_init (GeglTileBackend *self)
 {
   self->priv = GEGL_TILE_BACKEND_GET_PRIVATE (self);
   self->priv->shared = FALSE;
+  self->priv->mutex  = g_mutex_new ();
 }
 
 
@@ -30,28 +30,91 @@
 #include "gegl-tile-handler-cache.h"
 #include "gegl-debug.h"
 
-/*
-#define GEGL_DEBUG_CACHE_HITS
-*/
+/* the cache is split in a number of shards, each with its own lock, hash
+ * table and LRU queue; the shard of a tile is picked from the same hash that
+ * is used for the lookup, so that concurrent lookups of different tiles
+ * rarely contend for the same lock. Must be a power of two.
+ */
+#define GEGL_CACHE_SHARDS 16
+
+/* the maximum number of dirty tiles written back per GEGL_TILE_IDLE */
+#define GEGL_CACHE_WASH_BATCH 8
+
+/* the share of the bytes in a shard the 2Q policy allows the probation
+ * queue to hold before evicting from it
+ */
+#define GEGL_CACHE_2Q_PROBATION_PERCENTAGE 25
+
+/* the minimum number of evicted keys the 2Q policy remembers per shard */
+#define GEGL_CACHE_2Q_MIN_GHOSTS 64
 
 typedef struct CacheItem
 {
   GeglTileHandlerCache *handler; /* The specific handler that cached this item*/
+  guint      serial;             /* The serial of handler, which tells ghosts
+                                    of a disposed handler apart from items of
+                                    a new one at the same address */
   GeglTile *tile;                /* The tile */
+  GList     link;                /* Link in the LRU or probation queue of the
+                                    shard, the data of the link points back
+                                    to the item */
+  GList     dirty_link;          /* Link in the dirty queue of the shard */
+  GList     handler_link;        /* Link in the list of items of handler */
+  gboolean  dirty;               /* Whether dirty_link is in the dirty queue */
+  gboolean  probation;           /* Whether link is in the probation queue */
 
   gint      x;                   /* The coordinates this tile was cached for */
   gint      y;
   gint      z;
 } CacheItem;
 
+typedef struct CacheShard
+{
+  GStaticMutex  mutex;
+  GQueue        queue;           /* most recently used items at the head */
+  GQueue        probation;       /* items only referenced once since they were
+                                    inserted, used by scan resistant policies */
+  gint          bytes;           /* bytes of the tiles in queue and probation */
+  gint          probation_bytes; /* bytes of the tiles in probation */
+  GQueue        ghosts;          /* keys of items recently evicted from
+                                    probation, stored as CacheItems without
+                                    a tile, most recent at the head */
+  GHashTable   *ghost_ht;
+  GQueue        dirty;           /* items whose tile was modified since it was
+                                    last stored, most recently dirtied items
+                                    at the head. Items are removed lazily, an
+                                    item might have been stored by other means
+                                    by the time it is taken off the queue. */
+  GHashTable   *ht;
+} CacheShard;
+
+/* an eviction policy decides in which queue of a shard items are kept and
+ * which item to evict next, the callbacks are called with the lock of the
+ * shard held.
+ */
+typedef struct CachePolicy
+{
+  const gchar *name;
+  void        (*insert) (CacheShard *shard,   /* place a newly cached item */
+                         CacheItem  *item);
+  void        (*touch)  (CacheShard *shard,   /* item was referenced again */
+                         CacheItem  *item);
+  CacheItem * (*victim) (CacheShard *shard);  /* the next item to evict */
+} CachePolicy;
+
 struct _GeglTileHandlerCache
 {
   GeglTileHandler parent_instance;
   GSList *free_list;
+  GQueue  items;     /* all items cached for this handler, used for
+                        disposing without visiting the whole cache */
+  GMutex *mutex;     /* protects items, nests inside the shard locks */
+  guint   serial;    /* unique among all cache handlers */
 };
 
 
 static void       gegl_tile_handler_cache_dispose    (GObject              *object);
+static void       gegl_tile_handler_cache_finalize   (GObject              *object);
 static gboolean   gegl_tile_handler_cache_wash       (GeglTileHandlerCache *cache);
 static gpointer   gegl_tile_handler_cache_command    (GeglTileSource       *tile_store,
                                                       GeglTileCommand       command,
@@ -82,15 +145,29 @@ static void       gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cach
                                                       gint                  z);
 
 
-static GStaticMutex mutex                 = G_STATIC_MUTEX_INIT;
-static GQueue      *cache_queue           = NULL;
-static GHashTable  *cache_ht              = NULL;
-static gint         cache_wash_percentage = 20;
-static gint         cache_total           = 0; /* approximate amount of bytes stored */
-#ifdef GEGL_DEBUG_CACHE_HITS
-static gint         cache_hits            = 0;
-static gint         cache_misses          = 0;
-#endif
+static guint       gegl_tile_handler_cache_hashfunc   (gconstpointer         key);
+static gboolean    gegl_tile_handler_cache_equalfunc  (gconstpointer         a,
+                                                       gconstpointer         b);
+static gboolean    gegl_tile_handler_cache_ghost_equalfunc
+                                                      (gconstpointer         a,
+                                                       gconstpointer         b);
+
+
+static CacheShard    cache_shards[GEGL_CACHE_SHARDS];
+static gboolean      cache_initialized     = FALSE;
+static gint          cache_serial          = 0;
+static GStaticMutex  store_mutex           = G_STATIC_MUTEX_INIT; /* serializes
+                                                 writing back evicted and washed
+                                                 tiles and the statistics of
+                                                 it */
+static volatile gint cache_total           = 0; /* approximate amount of bytes stored */
+static volatile gint cache_trim_shard      = 0; /* shard to start next trim at */
+static volatile gint cache_wash_shard      = 0; /* shard to start next wash at */
+static gint          cache_tiles_washed    = 0; /* protected by store_mutex */
+static guint64       cache_bytes_washed    = 0; /* protected by store_mutex */
+static volatile gint cache_hits            = 0;
+static volatile gint cache_misses          = 0;
+static volatile gint cache_evictions       = 0;
 
 
 G_DEFINE_TYPE (GeglTileHandlerCache, gegl_tile_handler_cache, GEGL_TYPE_TILE_HANDLER)
@@ -101,29 +178,246 @@ gegl_tile_handler_cache_class_init (GeglTileHandlerCacheClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
-  gobject_class->dispose = gegl_tile_handler_cache_dispose;
+  gobject_class->dispose  = gegl_tile_handler_cache_dispose;
+  gobject_class->finalize = gegl_tile_handler_cache_finalize;
 }
 
 static void
 gegl_tile_handler_cache_init (GeglTileHandlerCache *cache)
 {
   ((GeglTileSource*)cache)->command = gegl_tile_handler_cache_command;
+  g_queue_init (&cache->items);
+  cache->mutex = g_mutex_new ();
+  cache->serial = g_atomic_int_exchange_and_add (&cache_serial, 1);
   gegl_tile_cache_init ();
 }
 
+/* returns the shard responsible for the coordinates and handler of item,
+ * the low bits of the morton order hash are not well distributed so they
+ * are mixed with a multiplicative hash first.
+ */
+static inline CacheShard *
+gegl_tile_handler_cache_shard (const CacheItem *item)
+{
+  guint hash = gegl_tile_handler_cache_hashfunc (item) * 2654435761u;
+
+  return &cache_shards[(hash >> 16) & (GEGL_CACHE_SHARDS - 1)];
+}
+
+/* looks up the item for x,y,z in cache, the shard lock must be held */
+static inline CacheItem *
+gegl_tile_handler_cache_lookup (CacheShard           *shard,
+                                GeglTileHandlerCache *cache,
+                                gint                  x,
+                                gint                  y,
+                                gint                  z)
+{
+  CacheItem pin;
+
+  pin.x = x;
+  pin.y = y;
+  pin.z = z;
+  pin.handler = cache;
+
+  return g_hash_table_lookup (shard->ht, &pin);
+}
+
+/* puts item at the head of the LRU or the probation queue of shard */
+static inline void
+gegl_tile_handler_cache_place (CacheShard *shard,
+                               CacheItem  *item,
+                               gboolean    probation)
+{
+  item->probation = probation;
+  shard->bytes += item->tile->size;
+  if (probation)
+    {
+      g_queue_push_head_link (&shard->probation, &item->link);
+      shard->probation_bytes += item->tile->size;
+    }
+  else
+    {
+      g_queue_push_head_link (&shard->queue, &item->link);
+    }
+}
+
+/* takes item out of the queue it is in */
+static inline void
+gegl_tile_handler_cache_displace (CacheShard *shard,
+                                  CacheItem  *item)
+{
+  shard->bytes -= item->tile->size;
+  if (item->probation)
+    {
+      g_queue_unlink (&shard->probation, &item->link);
+      shard->probation_bytes -= item->tile->size;
+    }
+  else
+    {
+      g_queue_unlink (&shard->queue, &item->link);
+    }
+}
+
+static void
+gegl_tile_handler_cache_lru_insert (CacheShard *shard,
+                                    CacheItem  *item)
+{
+  gegl_tile_handler_cache_place (shard, item, FALSE);
+}
+
 static void
-gegl_tile_handler_cache_dispose_buffer_tiles (gpointer itm,
-                                              gpointer userdata)
+gegl_tile_handler_cache_lru_touch (CacheShard *shard,
+                                   CacheItem  *item)
+{
+  gegl_tile_handler_cache_displace (shard, item);
+  gegl_tile_handler_cache_place (shard, item, FALSE);
+}
+
+static CacheItem *
+gegl_tile_handler_cache_lru_victim (CacheShard *shard)
+{
+  /* items can be left in probation when switching from another policy */
+  if (shard->probation.tail)
+    return shard->probation.tail->data;
+  if (shard->queue.tail)
+    return shard->queue.tail->data;
+  return NULL;
+}
+
+/* 2Q: new items are put on probation and only promoted to the LRU queue
+ * when they are inserted again shortly after having been evicted from
+ * probation. A sequential scan thus only cycles through the probation
+ * queue and leaves the working set in the LRU queue alone.
+ */
+static void
+gegl_tile_handler_cache_2q_insert (CacheShard *shard,
+                                   CacheItem  *item)
+{
+  CacheItem *ghost = g_hash_table_lookup (shard->ghost_ht, item);
+
+  if (ghost)
+    {
+      g_queue_unlink (&shard->ghosts, &ghost->link);
+      g_hash_table_remove (shard->ghost_ht, ghost);
+      g_slice_free (CacheItem, ghost);
+      gegl_tile_handler_cache_place (shard, item, FALSE);
+    }
+  else
+    {
+      gegl_tile_handler_cache_place (shard, item, TRUE);
+    }
+}
+
+static void
+gegl_tile_handler_cache_2q_touch (CacheShard *shard,
+                                  CacheItem  *item)
+{
+  /* references while on probation are considered correlated, and do
+   * not change the order
+   */
+  if (item->probation)
+    return;
+  gegl_tile_handler_cache_displace (shard, item);
+  gegl_tile_handler_cache_place (shard, item, FALSE);
+}
+
+static CacheItem *
+gegl_tile_handler_cache_2q_victim (CacheShard *shard)
 {
   CacheItem *item;
-  item = itm;
-  if (item->handler == userdata)
+  CacheItem *ghost;
+  guint      max_ghosts;
+
+  if (shard->probation.tail == NULL ||
+      (shard->queue.tail != NULL &&
+       (gint64) shard->probation_bytes * 100 <=
+       (gint64) shard->bytes * GEGL_CACHE_2Q_PROBATION_PERCENTAGE))
+    return shard->queue.tail ? shard->queue.tail->data : NULL;
+
+  item = shard->probation.tail->data;
+
+  /* remember the key, so that the item is promoted if it comes back */
+  ghost = g_slice_new0 (CacheItem);
+  ghost->handler   = item->handler;
+  ghost->serial    = item->serial;
+  ghost->x         = item->x;
+  ghost->y         = item->y;
+  ghost->z         = item->z;
+  ghost->link.data = ghost;
+  g_queue_push_head_link (&shard->ghosts, &ghost->link);
+  g_hash_table_insert (shard->ghost_ht, ghost, ghost);
+
+  max_ghosts = MAX (GEGL_CACHE_2Q_MIN_GHOSTS,
+                    (shard->queue.length + shard->probation.length) / 2);
+  while (shard->ghosts.length > max_ghosts)
+    {
+      ghost = shard->ghosts.tail->data;
+      g_queue_unlink (&shard->ghosts, &ghost->link);
+      g_hash_table_remove (shard->ghost_ht, ghost);
+      g_slice_free (CacheItem, ghost);
+    }
+
+  return item;
+}
+
+/* indexed by GeglTileCachePolicy */
+static const CachePolicy cache_policies[] =
+{
+  { "lru",
+    gegl_tile_handler_cache_lru_insert,
+    gegl_tile_handler_cache_lru_touch,
+    gegl_tile_handler_cache_lru_victim },
+  { "2q",
+    gegl_tile_handler_cache_2q_insert,
+    gegl_tile_handler_cache_2q_touch,
+    gegl_tile_handler_cache_2q_victim },
+};
+
+/* returns the eviction policy selected by GeglConfig:cache-policy */
+static inline const CachePolicy *
+gegl_tile_handler_cache_policy (void)
+{
+  return &cache_policies[g_atomic_int_get (&gegl_config ()->tile_cache_policy)];
+}
+
+/* queues item for being written back, the shard lock must be held */
+static inline void
+gegl_tile_handler_cache_mark_dirty (CacheShard *shard,
+                                    CacheItem  *item)
+{
+  if (!item->dirty)
     {
-      GeglTileHandlerCache *cache = userdata;
-      cache->free_list = g_slist_prepend (cache->free_list, item);
+      item->dirty = TRUE;
+      g_queue_push_head_link (&shard->dirty, &item->dirty_link);
     }
 }
 
+/* removes item from the dirty queue, the shard lock must be held */
+static inline void
+gegl_tile_handler_cache_unmark_dirty (CacheShard *shard,
+                                      CacheItem  *item)
+{
+  if (item->dirty)
+    {
+      item->dirty = FALSE;
+      g_queue_unlink (&shard->dirty, &item->dirty_link);
+    }
+}
+
+/* unlinks item from shard, the shard lock must be held */
+static inline void
+gegl_tile_handler_cache_unlink (CacheShard *shard,
+                                CacheItem  *item)
+{
+  gegl_tile_handler_cache_unmark_dirty (shard, item);
+  gegl_tile_handler_cache_displace (shard, item);
+  g_mutex_lock (item->handler->mutex);
+  g_queue_unlink (&item->handler->items, &item->handler_link);
+  g_mutex_unlock (item->handler->mutex);
+  g_hash_table_remove (shard->ht, item);
+  g_atomic_int_add (&cache_total, -item->tile->size);
+}
+
 static void
 gegl_tile_handler_cache_dispose (GObject *object)
 {
@@ -131,36 +425,68 @@ gegl_tile_handler_cache_dispose (GObject *object)
   CacheItem            *item;
   GSList               *iter;
 
-  g_static_mutex_lock (&mutex);
   cache = GEGL_TILE_HANDLER_CACHE (object);
 
-  /* only throw out items belonging to this cache instance */
+  /* only throw out items belonging to this cache instance, these are found
+   * through the item list of the handler so the cost is proportional to the
+   * number of tiles of this buffer rather than to the size of the cache.
+   */
 
   cache->free_list = NULL;
-  /* XXX: for optimization this could be delayed,. or collected among multiple
-   * buffer destructions, to avoid the overhead of walking the full queue for
-   * every tiny buffer being destroyed.
-   */
-  g_queue_foreach (cache_queue, gegl_tile_handler_cache_dispose_buffer_tiles, cache);
+  while (TRUE)
+    {
+      CacheShard *shard;
+      CacheItem   pin;
+
+      g_mutex_lock (cache->mutex);
+      if (cache->items.head == NULL)
+        {
+          g_mutex_unlock (cache->mutex);
+          break;
+        }
+      item = cache->items.head->data;
+      pin.x = item->x;
+      pin.y = item->y;
+      pin.z = item->z;
+      pin.handler = cache;
+      g_mutex_unlock (cache->mutex);
+
+      /* the shard lock has to be taken before the handler lock, look the
+       * item up again since it might have been evicted in the meantime
+       */
+      shard = gegl_tile_handler_cache_shard (&pin);
+      g_static_mutex_lock (&shard->mutex);
+      item = g_hash_table_lookup (shard->ht, &pin);
+      if (item)
+        {
+          gegl_tile_handler_cache_unlink (shard, item);
+          cache->free_list = g_slist_prepend (cache->free_list, item);
+        }
+      g_static_mutex_unlock (&shard->mutex);
+    }
+
   for (iter = cache->free_list; iter; iter = g_slist_next (iter))
     {
         item = iter->data;
-        if (item->tile)
-          {
-            cache_total -= item->tile->size;
-            gegl_tile_unref (item->tile);
-          }
-        g_queue_remove (cache_queue, item);
-        g_hash_table_remove (cache_ht, item);
+        gegl_tile_unref (item->tile);
         g_slice_free (CacheItem, item);
     }
   g_slist_free (cache->free_list);
   cache->free_list = NULL;
-  g_static_mutex_unlock (&mutex);
 
   G_OBJECT_CLASS (gegl_tile_handler_cache_parent_class)->dispose (object);
 }
 
+static void
+gegl_tile_handler_cache_finalize (GObject *object)
+{
+  GeglTileHandlerCache *cache = GEGL_TILE_HANDLER_CACHE (object);
+
+  g_mutex_free (cache->mutex);
+
+  G_OBJECT_CLASS (gegl_tile_handler_cache_parent_class)->finalize (object);
+}
+
 static GeglTile *
 gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
                                           gint        x,
@@ -174,24 +500,101 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
   tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
   if (tile)
     {
-#ifdef GEGL_DEBUG_CACHE_HITS
-      cache_hits++;
-#endif
+      g_atomic_int_inc (&cache_hits);
       return tile;
     }
-#ifdef GEGL_DEBUG_CACHE_HITS
-  cache_misses++;
-#endif
+  g_atomic_int_inc (&cache_misses);
 
   if (source)
     tile = gegl_tile_source_get_tile (source, x, y, z);
 
+  /* several threads may miss the same tile at once, they all continue
+   * with the tile cached first
+   */
   if (tile)
-    gegl_tile_handler_cache_insert (cache, tile, x, y, z);
+    tile = gegl_tile_handler_cache_adopt (cache, tile, x, y, z);
 
   return tile;
 }
 
+/* stores the tiles of batch, and drops the references held on them */
+static void
+gegl_tile_handler_cache_store_batch (GeglTile **batch,
+                                     gint       count)
+{
+  gint i;
+
+  g_static_mutex_lock (&store_mutex);
+  for (i = 0; i < count; i++)
+    {
+      if (!gegl_tile_is_stored (batch[i]) &&
+          gegl_tile_store (batch[i]))
+        {
+          cache_tiles_washed ++;
+          cache_bytes_washed += batch[i]->size;
+        }
+    }
+  g_static_mutex_unlock (&store_mutex);
+
+  for (i = 0; i < count; i++)
+    gegl_tile_unref (batch[i]);
+}
+
+/* stores all dirty tiles belonging to cache, only the items of cache
+ * are visited.
+ */
+static void
+gegl_tile_handler_cache_flush (GeglTileHandlerCache *cache)
+{
+  GeglTile *batch[GEGL_CACHE_WASH_BATCH];
+  GSList   *dirty = NULL;
+  GSList   *iter;
+  GList    *link;
+  gint      count = 0;
+
+  /* the items can't go away while the handler lock is held, their keys
+   * are copied and their tiles kept alive by the references taken here
+   */
+  g_mutex_lock (cache->mutex);
+  for (link = cache->items.head; link; link = link->next)
+    {
+      CacheItem *item = link->data;
+
+      if (!gegl_tile_is_stored (item->tile))
+        {
+          CacheItem *pin = g_slice_dup (CacheItem, item);
+
+          pin->tile = gegl_tile_ref (item->tile);
+          dirty     = g_slist_prepend (dirty, pin);
+        }
+    }
+  g_mutex_unlock (cache->mutex);
+
+  for (iter = dirty; iter; iter = g_slist_next (iter))
+    {
+      CacheItem  *pin   = iter->data;
+      CacheShard *shard = gegl_tile_handler_cache_shard (pin);
+      CacheItem  *item;
+
+      g_static_mutex_lock (&shard->mutex);
+      item = g_hash_table_lookup (shard->ht, pin);
+      if (item && item->tile == pin->tile)
+        gegl_tile_handler_cache_unmark_dirty (shard, item);
+      g_static_mutex_unlock (&shard->mutex);
+
+      batch[count++] = pin->tile;
+      g_slice_free (CacheItem, pin);
+      if (count == GEGL_CACHE_WASH_BATCH)
+        {
+          gegl_tile_handler_cache_store_batch (batch, count);
+          count = 0;
+        }
+    }
+  g_slist_free (dirty);
+
+  gegl_tile_handler_cache_store_batch (batch, count);
+}
+
 static gpointer
 gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
                                  GeglTileCommand  command,
@@ -206,21 +609,7 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
   switch (command)
     {
       case GEGL_TILE_FLUSH:
-        {
-          GList     *link;
-
-          for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
-            {
-              CacheItem *item = link->data;
-              GeglTile  *tile = item->tile;
-
-              if (tile != NULL &&
-                  item->handler == cache)
-                {
-                  gegl_tile_store (tile);
-                }
-            }
-        }
+        gegl_tile_handler_cache_flush (cache);
         break;
       case GEGL_TILE_GET:
         /* XXX: we should perhaps store a NIL result, and place the empty
@@ -258,37 +647,41 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
   return gegl_tile_handler_source_command (handler, command, x, y, z, data);
 }
 
-/* write the least recently used dirty tile to disk if it
- * is in the wash_percentage (20%) least recently used tiles,
- * calling this function in an idle handler distributes the
- * tile flushing overhead over time.
+/* write a batch of the tiles that have been dirty the longest to disk,
+ * calling this function in an idle handler distributes the tile flushing
+ * overhead over time. The dirty queues are visited round robin starting
+ * with a different shard for each call.
  */
 gboolean
 gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
 {
-  GeglTile  *last_dirty = NULL;
-  guint      count      = 0;
-  gint       length     = g_queue_get_length (cache_queue);
-  gint       wash_tiles = cache_wash_percentage * length / 100;
-  GList     *link;
+  GeglTile *batch[GEGL_CACHE_WASH_BATCH];
+  gint      start = g_atomic_int_exchange_and_add (&cache_wash_shard, 1);
+  gint      count = 0;
+  gint      i;
 
-  for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+  for (i = 0; i < GEGL_CACHE_SHARDS && count < GEGL_CACHE_WASH_BATCH; i++)
     {
-      CacheItem *item = link->data;
-      GeglTile  *tile = item->tile;
+      CacheShard *shard = &cache_shards[(start + i) & (GEGL_CACHE_SHARDS - 1)];
 
-      count++;
-      if (!gegl_tile_is_stored (tile))
-        if (count > length - wash_tiles)
-          last_dirty = tile;
-    }
+      g_static_mutex_lock (&shard->mutex);
+      while (shard->dirty.tail && count < GEGL_CACHE_WASH_BATCH)
+        {
+          CacheItem *item = shard->dirty.tail->data;
 
-  if (last_dirty != NULL)
-    {
-      gegl_tile_store (last_dirty);
-      return TRUE;
+          gegl_tile_handler_cache_unmark_dirty (shard, item);
+          if (!gegl_tile_is_stored (item->tile))
+            batch[count++] = gegl_tile_ref (item->tile);
+        }
+      g_static_mutex_unlock (&shard->mutex);
     }
-  return FALSE;
+
+  if (count == 0)
+    return FALSE;
+
+  GEGL_NOTE (GEGL_DEBUG_CACHE, "washing %i tiles", count);
+  gegl_tile_handler_cache_store_batch (batch, count);
+  return TRUE;
 }
 
 /* returns the requested Tile if it is in the cache, NULL otherwize.
@@ -299,25 +692,26 @@ gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
                                   gint                  y,
                                   gint                  z)
 {
-  CacheItem *result;
-  CacheItem pin;
+  CacheShard *shard;
+  CacheItem  *result;
+  CacheItem   pin;
+  GeglTile   *tile = NULL;
 
   pin.x = x;
   pin.y = y;
   pin.z = z;
   pin.handler = cache;
+  shard = gegl_tile_handler_cache_shard (&pin);
 
-  g_static_mutex_lock (&mutex);
-  result = g_hash_table_lookup (cache_ht, &pin);
+  g_static_mutex_lock (&shard->mutex);
+  result = g_hash_table_lookup (shard->ht, &pin);
   if (result)
     {
-      g_queue_remove (cache_queue, result);
-      g_queue_push_head (cache_queue, result);
-      g_static_mutex_unlock (&mutex);
-      return gegl_tile_ref (result->tile);
+      gegl_tile_handler_cache_policy ()->touch (shard, result);
+      tile = gegl_tile_ref (result->tile);
     }
-  g_static_mutex_unlock (&mutex);
-  return NULL;
+  g_static_mutex_unlock (&shard->mutex);
+  return tile;
 }
 
 static gboolean
@@ -337,20 +731,40 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
   return FALSE;
 }
 
+/* evicts the item the eviction policy picks from one shard, the shard to
+ * evict from is picked round robin to approximate a global order.
+ */
 static gboolean
-gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
+gegl_tile_handler_cache_trim (void)
 {
-  CacheItem *last_writable;
+  const CachePolicy *policy = gegl_tile_handler_cache_policy ();
+  gint               start  = g_atomic_int_exchange_and_add (&cache_trim_shard, 1);
+  gint               i;
 
-  last_writable = g_queue_pop_tail (cache_queue);
-
-  if (last_writable != NULL)
+  for (i = 0; i < GEGL_CACHE_SHARDS; i++)
     {
-      g_hash_table_remove (cache_ht, last_writable);
-      cache_total  -= last_writable->tile->size;
-      gegl_tile_unref (last_writable->tile);
-      g_slice_free (CacheItem, last_writable);
-      return TRUE;
+      CacheShard *shard = &cache_shards[(start + i) & (GEGL_CACHE_SHARDS - 1)];
+      CacheItem  *last_writable = NULL;
+
+      g_static_mutex_lock (&shard->mutex);
+      last_writable = policy->victim (shard);
+      if (last_writable)
+        gegl_tile_handler_cache_unlink (shard, last_writable);
+      g_static_mutex_unlock (&shard->mutex);
+
+      if (last_writable != NULL)
+        {
+          g_atomic_int_inc (&cache_evictions);
+
+          /* dropping the last reference might write the tile to the
+           * backend
+           */
+          g_static_mutex_lock (&store_mutex);
+          gegl_tile_unref (last_writable->tile);
+          g_static_mutex_unlock (&store_mutex);
+          g_slice_free (CacheItem, last_writable);
+          return TRUE;
+        }
     }
 
   return FALSE;
@@ -362,32 +776,31 @@ gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cache,
                                     gint                  y,
                                     gint                  z)
 {
-  GList *link;
+  CacheShard *shard;
+  CacheItem  *item;
+  CacheItem   pin;
 
-  g_static_mutex_lock (&mutex);
-  for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+  pin.x = x;
+  pin.y = y;
+  pin.z = z;
+  pin.handler = cache;
+  shard = gegl_tile_handler_cache_shard (&pin);
+
+  g_static_mutex_lock (&shard->mutex);
+  item = gegl_tile_handler_cache_lookup (shard, cache, x, y, z);
+  if (item)
+    gegl_tile_handler_cache_unlink (shard, item);
+  g_static_mutex_unlock (&shard->mutex);
+
+  if (item)
     {
-      CacheItem *item = link->data;
-      GeglTile  *tile = item->tile;
+      GeglTile *tile = item->tile;
 
-      if (tile != NULL &&
-          item->x == x &&
-          item->y == y &&
-          item->z == z &&
-          item->handler == cache)
-        {
-          cache_total  -= item->tile->size;
-          tile->tile_storage = NULL;
-          gegl_tile_mark_as_stored (tile); /* to cheat it out of being stored */
-          gegl_tile_unref (tile);
-          g_hash_table_remove (cache_ht, item);
-          g_slice_free (CacheItem, item);
-          g_queue_delete_link (cache_queue, link);
-          g_static_mutex_unlock (&mutex);
-          return;
-        }
+      tile->tile_storage = NULL;
+      gegl_tile_mark_as_stored (tile); /* to cheat it out of being stored */
+      gegl_tile_unref (tile);
+      g_slice_free (CacheItem, item);
     }
-  g_static_mutex_unlock (&mutex);
 }
 
 
@@ -397,34 +810,130 @@ gegl_tile_handler_cache_void (GeglTileHandlerCache *cache,
                               gint                  y,
                               gint                  z)
 {
-  GList *link;
+  CacheShard *shard;
+  CacheItem  *item;
+  CacheItem   pin;
 
-  if (!cache_queue)
+  if (!cache_initialized)
     return;
 
-  g_static_mutex_lock (&mutex);
-  for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+  pin.x = x;
+  pin.y = y;
+  pin.z = z;
+  pin.handler = cache;
+  shard = gegl_tile_handler_cache_shard (&pin);
+
+  g_static_mutex_lock (&shard->mutex);
+  item = gegl_tile_handler_cache_lookup (shard, cache, x, y, z);
+  if (item)
+    gegl_tile_handler_cache_unlink (shard, item);
+  g_static_mutex_unlock (&shard->mutex);
+
+  if (item)
     {
-      CacheItem *item = link->data;
-      GeglTile  *tile = item->tile;
+      gegl_tile_void (item->tile);
+      gegl_tile_unref (item->tile);
+      g_slice_free (CacheItem, item);
+    }
+}
+
+/* caches tile for x,y,z, a tile already cached for the coordinates is
+ * replaced when replace is set, otherwise it is kept. Returns a new
+ * reference to the tile cached after the call.
+ */
+static GeglTile *
+gegl_tile_handler_cache_insert_item (GeglTileHandlerCache *cache,
+                                     GeglTile             *tile,
+                                     gint                  x,
+                                     gint                  y,
+                                     gint                  z,
+                                     gboolean              replace)
+{
+  CacheItem  *item = g_slice_new (CacheItem);
+  CacheItem  *existing;
+  CacheShard *shard;
+  GeglTile   *replaced = NULL;
+  GeglTile   *cached   = NULL;
+
+  item->handler           = cache;
+  item->serial            = cache->serial;
+  item->tile              = gegl_tile_ref (tile);
+  item->link.data         = item;
+  item->link.next         = NULL;
+  item->link.prev         = NULL;
+  item->dirty_link.data   = item;
+  item->dirty_link.next   = NULL;
+  item->dirty_link.prev   = NULL;
+  item->dirty             = FALSE;
+  item->probation         = FALSE;
+  item->handler_link.data = item;
+  item->handler_link.next = NULL;
+  item->handler_link.prev = NULL;
+  item->x                 = x;
+  item->y                 = y;
+  item->z                 = z;
+  shard = gegl_tile_handler_cache_shard (item);
+
+  g_static_mutex_lock (&shard->mutex);
+  existing = g_hash_table_lookup (shard->ht, item);
+  if (existing)
+    {
+      /* the tile was already inserted further down the chain (by the empty
+       * or zoom handler), or replaces an older tile for the same coordinates
+       */
+      gegl_tile_handler_cache_displace (shard, existing);
+      if (existing->tile != tile && !replace)
+        {
+          /* another thread cached the tile first, it is the one used */
+          cached = gegl_tile_ref (existing->tile);
+        }
+      else if (existing->tile != tile)
+        {
+          replaced = existing->tile;
+          existing->tile = item->tile;
+          g_atomic_int_add (&cache_total, tile->size - replaced->size);
+          if (!gegl_tile_is_stored (tile))
+            gegl_tile_handler_cache_mark_dirty (shard, existing);
+          item->tile = NULL;
+        }
+      gegl_tile_handler_cache_place (shard, existing, existing->probation);
+    }
+  else
+    {
+      gegl_tile_handler_cache_policy ()->insert (shard, item);
+      g_hash_table_insert (shard->ht, item, item);
+      g_mutex_lock (cache->mutex);
+      g_queue_push_head_link (&cache->items, &item->handler_link);
+      g_mutex_unlock (cache->mutex);
+      if (!gegl_tile_is_stored (tile))
+        gegl_tile_handler_cache_mark_dirty (shard, item);
+      g_atomic_int_add (&cache_total, tile->size);
+    }
+  g_static_mutex_unlock (&shard->mutex);
 
-      if (tile != NULL &&
-          item->x == x &&
-          item->y == y &&
-          item->z == z &&
-          item->handler == cache)
+  if (existing)
+    {
+      if (item->tile)
+        gegl_tile_unref (item->tile);
+      g_slice_free (CacheItem, item);
+      if (replaced)
         {
-          gegl_tile_void (tile);
-          cache_total -= item->tile->size;
-          gegl_tile_unref (tile);
-          g_hash_table_remove (cache_ht, item);
-          g_slice_free (CacheItem, item);
-          g_queue_delete_link (cache_queue, link);
-          g_static_mutex_unlock (&mutex);
-          return;
+          g_static_mutex_lock (&store_mutex);
+          gegl_tile_unref (replaced);
+          g_static_mutex_unlock (&store_mutex);
         }
+      return cached ? cached : gegl_tile_ref (tile);
+    }
+
+  while (g_atomic_int_get (&cache_total) > gegl_config()->cache_size)
+    {
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:%i > cache_size:%i", cache_total, gegl_config()->cache_size);
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i evicted:%i", cache_hits*100.0/MAX (cache_hits+cache_misses, 1), cache_hits, cache_misses, cache_evictions);
+      if (!gegl_tile_handler_cache_trim ())
+        break;
     }
-  g_static_mutex_unlock (&mutex);
+
+  return gegl_tile_ref (tile);
 }
 
 void
@@ -434,29 +943,71 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
                                 gint                  y,
                                 gint                  z)
 {
-  CacheItem *item = g_slice_new (CacheItem);
+  gegl_tile_unref (gegl_tile_handler_cache_insert_item (cache, tile,
+                                                        x, y, z, TRUE));
+}
 
-  item->handler = cache;
-  item->tile    = gegl_tile_ref (tile);
-  item->x       = x;
-  item->y       = y;
-  item->z       = z;
+GeglTile *
+gegl_tile_handler_cache_adopt (GeglTileHandlerCache *cache,
+                               GeglTile             *tile,
+                               gint                  x,
+                               gint                  y,
+                               gint                  z)
+{
+  GeglTile *cached = gegl_tile_handler_cache_insert_item (cache, tile,
+                                                          x, y, z, FALSE);
 
-  g_static_mutex_lock (&mutex);
-  cache_total  += item->tile->size;
-  g_queue_push_head (cache_queue, item);
+  gegl_tile_unref (tile);
+  return cached;
+}
 
-  g_hash_table_insert (cache_ht, item, item);
+void
+gegl_tile_handler_cache_tile_dirtied (GeglTileHandlerCache *cache,
+                                      GeglTile             *tile)
+{
+  CacheShard *shard;
+  CacheItem  *item;
+  CacheItem   pin;
 
-  while (cache_total > gegl_config()->cache_size)
-    {
-#ifdef GEGL_DEBUG_CACHE_HITS
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:%i > cache_size:%i", cache_total, gegl_config()->cache_size);
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i  %i]", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses, g_queue_get_length (cache_queue));
-#endif
-      gegl_tile_handler_cache_trim (cache);
-    }
-  g_static_mutex_unlock (&mutex);
+  pin.x = tile->x;
+  pin.y = tile->y;
+  pin.z = tile->z;
+  pin.handler = cache;
+  shard = gegl_tile_handler_cache_shard (&pin);
+
+  g_static_mutex_lock (&shard->mutex);
+  item = g_hash_table_lookup (shard->ht, &pin);
+  if (item && item->tile == tile)
+    gegl_tile_handler_cache_mark_dirty (shard, item);
+  g_static_mutex_unlock (&shard->mutex);
+}
+
+void
+gegl_tile_handler_cache_get_stats (gint *hits,
+                                   gint *misses,
+                                   gint *evictions,
+                                   gint *total)
+{
+  if (hits)
+    *hits = g_atomic_int_get (&cache_hits);
+  if (misses)
+    *misses = g_atomic_int_get (&cache_misses);
+  if (evictions)
+    *evictions = g_atomic_int_get (&cache_evictions);
+  if (total)
+    *total = g_atomic_int_get (&cache_total);
+}
+
+void
+gegl_tile_handler_cache_get_wash_stats (gint    *tiles_washed,
+                                        guint64 *bytes_written)
+{
+  g_static_mutex_lock (&store_mutex);
+  if (tiles_washed)
+    *tiles_washed = cache_tiles_washed;
+  if (bytes_written)
+    *bytes_written = cache_bytes_washed;
+  g_static_mutex_unlock (&store_mutex);
 }
 
 GeglTileHandlerCache *
@@ -507,22 +1058,87 @@ gegl_tile_handler_cache_equalfunc (gconstpointer a,
   return FALSE;
 }
 
+/* ghosts keep the address of a handler that might have been disposed
+ * since, they only match items of the same handler serial
+ */
+static gboolean
+gegl_tile_handler_cache_ghost_equalfunc (gconstpointer a,
+                                         gconstpointer b)
+{
+  const CacheItem *ea = a;
+  const CacheItem *eb = b;
+
+  return gegl_tile_handler_cache_equalfunc (a, b) &&
+         ea->serial == eb->serial;
+}
+
 void
 gegl_tile_cache_init (void)
 {
-  if (cache_queue == NULL)
-    cache_queue = g_queue_new ();
-  if (cache_ht == NULL)
-    cache_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc, gegl_tile_handler_cache_equalfunc);
+  gint i;
+
+  if (cache_initialized)
+    return;
+
+  for (i = 0; i < GEGL_CACHE_SHARDS; i++)
+    {
+      CacheShard *shard = &cache_shards[i];
+
+      g_static_mutex_init (&shard->mutex);
+      g_queue_init (&shard->queue);
+      g_queue_init (&shard->probation);
+      g_queue_init (&shard->dirty);
+      g_queue_init (&shard->ghosts);
+      shard->bytes           = 0;
+      shard->probation_bytes = 0;
+      shard->ht       = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                          gegl_tile_handler_cache_equalfunc);
+      shard->ghost_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                          gegl_tile_handler_cache_ghost_equalfunc);
+    }
+  cache_total       = 0;
+  cache_initialized = TRUE;
 }
 
 void
 gegl_tile_cache_destroy (void)
 {
-  if (cache_queue)
-    g_queue_free (cache_queue);
-  if (cache_ht)
-    g_hash_table_destroy (cache_ht);
-  cache_queue = NULL;
-  cache_ht = NULL;
+  gint i;
+
+  if (!cache_initialized)
+    return;
+
+  for (i = 0; i < GEGL_CACHE_SHARDS; i++)
+    {
+      CacheShard *shard = &cache_shards[i];
+
+      /* the links are embedded in the items, so there is nothing to free
+       * for the queue itself
+       */
+      g_queue_init (&shard->queue);
+      g_queue_init (&shard->probation);
+      g_queue_init (&shard->dirty);
+      g_hash_table_destroy (shard->ht);
+      shard->ht = NULL;
+
+      while (shard->ghosts.head)
+        {
+          CacheItem *ghost = shard->ghosts.head->data;
+
+          g_queue_unlink (&shard->ghosts, &ghost->link);
+          g_slice_free (CacheItem, ghost);
+        }
+      g_hash_table_destroy (shard->ghost_ht);
+      shard->ghost_ht = NULL;
+      g_static_mutex_free (&shard->mutex);
+    }
+  cache_initialized = FALSE;
+}
+
+void
+gegl_tile_cache_stats (void)
+{
+  g_warning ("tile cache (%s): %i hits %i misses %i evictions %i bytes",
+             gegl_tile_handler_cache_policy ()->name,
+             cache_hits, cache_misses, cache_evictions, cache_total);
 }
@@ -50,4 +50,37 @@ void                   gegl_tile_handler_cache_insert   (GeglTileHandlerCache *c
                                                          gint                  y,
                                                          gint                  z);
 
+/* caches tile for x,y,z unless a tile is cached for the coordinates
+ * already, consumes the reference to tile held by the caller and returns
+ * a reference to the tile that is cached. Used for tiles fetched or
+ * created on a cache miss, that might have been missed by several
+ * threads at once.
+ */
+GeglTile *             gegl_tile_handler_cache_adopt    (GeglTileHandlerCache *cache,
+                                                         GeglTile             *tile,
+                                                         gint                  x,
+                                                         gint                  y,
+                                                         gint                  z);
+
+/* called by gegl_tile_unlock when the tile changes from being stored to
+ * being dirty, queues the tile for being written back by the cache
+ */
+void                   gegl_tile_handler_cache_tile_dirtied
+                                                        (GeglTileHandlerCache *cache,
+                                                         GeglTile             *tile);
+
+/* hit, miss and eviction counts across all tile caches, and the number of
+ * bytes currently cached
+ */
+void                   gegl_tile_handler_cache_get_stats
+                                                        (gint                 *hits,
+                                                         gint                 *misses,
+                                                         gint                 *evictions,
+                                                         gint                 *total);
+
+/* statistics on the tiles written back by washing and flushing */
+void                   gegl_tile_handler_cache_get_wash_stats
+                                                        (gint                 *tiles_washed,
+                                                         guint64              *bytes_written);
+
 #endif
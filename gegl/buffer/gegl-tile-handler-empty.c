@@ -28,6 +28,7 @@
 #include "gegl-tile-handler-empty.h"
 #include "gegl-tile-handler-cache.h"
 #include "gegl-tile-backend.h"
+#include "gegl-tile.h"
 
 G_DEFINE_TYPE (GeglTileHandlerEmpty, gegl_tile_handler_empty, GEGL_TYPE_TILE_HANDLER)
 
@@ -58,13 +59,14 @@ get_tile (GeglTileSource *gegl_tile_source,
   if (tile != NULL)
     return tile;
 
-  tile = gegl_tile_dup (empty->tile);
+  tile = gegl_tile_new_constant (empty->tile->size, empty->px_size,
+                                 gegl_tile_get_data (empty->tile));
   tile->x = x;
   tile->y = y;
   tile->z = z;
 
   if (empty->cache)
-    gegl_tile_handler_cache_insert (empty->cache, tile, x, y, z);
+    tile = gegl_tile_handler_cache_adopt (empty->cache, tile, x, y, z);
 
   return tile;
 }
@@ -101,9 +103,15 @@ gegl_tile_handler_empty_new (GeglTileBackend      *backend,
 {
   GeglTileHandlerEmpty *empty = g_object_new (GEGL_TYPE_TILE_HANDLER_EMPTY, NULL);
   gint tile_size = gegl_tile_backend_get_tile_size (backend);
+  guchar *zero;
+
   empty->backend = backend;
   empty->cache = cache;
-  empty->tile = gegl_tile_new (tile_size);
-  memset (gegl_tile_get_data (empty->tile), 0x00, tile_size);
+  empty->px_size = babl_format_get_bytes_per_pixel (gegl_tile_backend_get_format (backend));
+
+  /* empty tiles of all storages with this tile size share the data */
+  zero = g_malloc0 (empty->px_size);
+  empty->tile = gegl_tile_new_constant (tile_size, empty->px_size, zero);
+  g_free (zero);
   return (void*)empty;
 }
@@ -46,6 +46,7 @@ struct _GeglTileHandlerEmpty
   GeglTileHandler         parent_instance;
 
   GeglTile               *tile;
+  gint                    px_size;
   GeglTileBackend        *backend;
   GeglTileHandlerCache   *cache;
 };
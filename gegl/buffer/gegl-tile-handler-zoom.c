@@ -35,11 +35,6 @@ G_DEFINE_TYPE (GeglTileHandlerZoom, gegl_tile_handler_zoom, GEGL_TYPE_TILE_HANDL
 #include "gegl-tile-backend.h"
 #include "gegl-tile-storage.h"
 
-void gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
-                                     GeglTile             *tile,
-                                     gint                  x,
-                                     gint                  y,
-                                     gint                  z);
 static inline void set_blank (GeglTile *dst_tile,
                               gint      width,
                               gint      height,
@@ -263,9 +258,6 @@ get_tile (GeglTileSource *gegl_tile_source,
         tile->y = y;
         tile->z = z;
         tile->tile_storage = zoom->tile_storage;
-
-        if (zoom->cache)
-          gegl_tile_handler_cache_insert (zoom->cache, tile, x, y, z);
       }
     gegl_tile_lock (tile);
 
@@ -274,6 +266,8 @@ get_tile (GeglTileSource *gegl_tile_source,
         {
           if (source_tile[i][j])
             {
+              /* the level below may have been written on the device */
+              gegl_tile_cl_sync (source_tile[i][j]);
               set_half (tile, source_tile[i][j], tile_width, tile_height, format, i, j);
               gegl_tile_unref (source_tile[i][j]);
             }
@@ -283,6 +277,12 @@ get_tile (GeglTileSource *gegl_tile_source,
             }
         }
     gegl_tile_unlock (tile);
+
+    /* only cached once it is complete, other threads missing it meanwhile
+     * make their own, and the first one cached is kept
+     */
+    if (zoom->cache)
+      tile = gegl_tile_handler_cache_adopt (zoom->cache, tile, x, y, z);
   }
 
   return tile;
@@ -27,6 +27,27 @@
  * GeglTileSource is the very top classes of the tile/buffer handling of Gegl. It defines the generic
  * command mechanism to interact with a set of tiles. This classe is derived in GeglTileBackend and
  * GeglTileHandler.
+ *
+ * Locking: commands are issued to a tile chain from any number of threads at
+ * once, every thread rendering a part of the graph does so.
+ *
+ *  - The cache keeps its items in shards, each with a mutex held while an
+ *    item of the shard is looked up or changed. A miss is fetched from the
+ *    rest of the chain without holding any lock, several threads might
+ *    fetch or create the same tile at once, only the first one to be cached
+ *    is kept and returned to all of them (gegl_tile_handler_cache_adopt).
+ *  - Writing back evicted and washed tiles is serialized by the cache.
+ *  - The backends hold their own mutex while executing a command, the
+ *    other handlers of the chain keep no state that needs locking.
+ *  - The data of a tile is protected by gegl_tile_lock/gegl_tile_unlock,
+ *    which also separate the copies of shared (copy on write) tiles.
+ *    Readers don't lock, threads writing to the same tile at once write to
+ *    different pixels of it.
+ *  - The hot tile of a GeglBuffer is owned by one thread at a time, and
+ *    every thread sampling a buffer has a sampler of its own.
+ *
+ * Locks are taken in this order: tile storage, cache shard, cache handler,
+ * write back, backend.
  */
 
 G_BEGIN_DECLS
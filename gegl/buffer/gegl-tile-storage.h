@@ -48,6 +48,9 @@ struct _GeglTileStorage
   gint           height;
   gchar         *path;
   gint           seen_zoom; /* the maximum zoom level we've seen tiles for */
+  gint           generation; /* bumped when cached tiles are replaced or
+                                voided, outdating the hot tiles of all
+                                buffers on the storage */
 
   guint          idle_swapper;
 };
@@ -45,6 +45,107 @@ static void default_free (gpointer data,
   gegl_free (data);
 }
 
+/* Tiles where every pixel has the same value share their data, kept in
+ * a global table keyed on the tile size and the pixel value. The data
+ * is read only and copied by gegl_tile_lock like borrowed data.
+ */
+typedef struct _GeglTileConstant GeglTileConstant;
+
+struct _GeglTileConstant
+{
+  gint    ref_count;
+  gint    size;
+  gint    px_size;
+  guchar *data;  /* size bytes, px_size byte pixel repeated */
+};
+
+static GStaticMutex  constant_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable   *constant_table = NULL;
+
+static guint
+gegl_tile_constant_hash (gconstpointer key)
+{
+  const GeglTileConstant *constant = key;
+  guint                   hash     = constant->size * 31 + constant->px_size;
+  gint                    i;
+
+  for (i = 0; i < constant->px_size; i++)
+    hash = hash * 33 + constant->data[i];
+  return hash;
+}
+
+static gboolean
+gegl_tile_constant_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const GeglTileConstant *ca = a;
+  const GeglTileConstant *cb = b;
+
+  return ca->size == cb->size &&
+         ca->px_size == cb->px_size &&
+         memcmp (ca->data, cb->data, ca->px_size) == 0;
+}
+
+static GeglTileConstant *
+gegl_tile_constant_get (gint          size,
+                        gint          px_size,
+                        const guchar *pixel)
+{
+  GeglTileConstant  key;
+  GeglTileConstant *constant;
+
+  key.size    = size;
+  key.px_size = px_size;
+  key.data    = (guchar *) pixel;
+
+  g_static_mutex_lock (&constant_mutex);
+  if (!constant_table)
+    constant_table = g_hash_table_new (gegl_tile_constant_hash,
+                                       gegl_tile_constant_equal);
+
+  constant = g_hash_table_lookup (constant_table, &key);
+  if (constant)
+    {
+      constant->ref_count++;
+    }
+  else
+    {
+      gint filled;
+
+      constant            = g_slice_new (GeglTileConstant);
+      constant->ref_count = 1;
+      constant->size      = size;
+      constant->px_size   = px_size;
+      constant->data      = gegl_malloc (size);
+
+      /* replicate the pixel, doubling the filled part each time */
+      memcpy (constant->data, pixel, MIN (px_size, size));
+      for (filled = px_size; filled < size; filled *= 2)
+        memcpy (constant->data + filled, constant->data, MIN (filled, size - filled));
+
+      g_hash_table_insert (constant_table, constant, constant);
+    }
+  g_static_mutex_unlock (&constant_mutex);
+
+  return constant;
+}
+
+static void
+gegl_tile_constant_unref (gpointer data,
+                          gpointer userdata)
+{
+  GeglTileConstant *constant = userdata;
+
+  g_static_mutex_lock (&constant_mutex);
+  if (--constant->ref_count == 0)
+    {
+      g_hash_table_remove (constant_table, constant);
+      gegl_free (constant->data);
+      g_slice_free (GeglTileConstant, constant);
+    }
+  g_static_mutex_unlock (&constant_mutex);
+}
+
 GeglTile *gegl_tile_ref (GeglTile *tile)
 {
   g_atomic_int_inc (&tile->ref_count);
@@ -63,6 +164,12 @@ void gegl_tile_unref (GeglTile *tile)
   if (!gegl_tile_is_stored (tile))
     gegl_tile_store (tile);
 
+  if (tile->cl_data)
+    {
+      gegl_cl_pool_release (tile->cl_data);
+      tile->cl_data = NULL;
+    }
+
   if (tile->data)
     {
       if (tile->next_shared == tile)
@@ -109,7 +216,12 @@ gegl_tile_new_bare (void)
 GeglTile *
 gegl_tile_dup (GeglTile *src)
 {
-  GeglTile *tile = gegl_tile_new_bare ();
+  GeglTile *tile;
+
+  /* only the data on the host is shared */
+  gegl_tile_cl_sync (src);
+
+  tile = gegl_tile_new_bare ();
 
   tile->tile_storage    = src->tile_storage;
   tile->data       = src->data;
@@ -117,6 +229,7 @@ gegl_tile_dup (GeglTile *src)
 
   tile->destroy_notify      = src->destroy_notify;
   tile->destroy_notify_data = src->destroy_notify_data;
+  tile->read_only           = src->read_only;
 
   tile->next_shared              = src->next_shared;
   src->next_shared               = tile;
@@ -145,6 +258,48 @@ gegl_tile_new (gint size)
   return tile;
 }
 
+GeglTile *
+gegl_tile_new_constant (gint          size,
+                        gint          px_size,
+                        const guchar *pixel)
+{
+  GeglTile         *tile     = gegl_tile_new_bare ();
+  GeglTileConstant *constant = gegl_tile_constant_get (size, px_size, pixel);
+
+  gegl_tile_set_data_read_only (tile, constant->data, size,
+                                gegl_tile_constant_unref, constant);
+  return tile;
+}
+
+gboolean
+gegl_tile_is_constant (GeglTile *tile)
+{
+  return tile->destroy_notify == gegl_tile_constant_unref;
+}
+
+/* replaces the data of an unshared tile with shared constant data if
+ * all its pixels are equal, a buffer is uniform when it is equal to
+ * itself shifted by one pixel.
+ */
+static void
+gegl_tile_make_constant (GeglTile *tile,
+                         gint      px_size)
+{
+  GeglTileConstant *constant;
+
+  if (tile->next_shared != tile ||
+      tile->read_only ||
+      tile->size <= px_size ||
+      tile->destroy_notify != default_free ||
+      memcmp (tile->data, tile->data + px_size, tile->size - px_size) != 0)
+    return;
+
+  constant = gegl_tile_constant_get (tile->size, px_size, tile->data);
+  gegl_free (tile->data);
+  gegl_tile_set_data_read_only (tile, constant->data, tile->size,
+                                gegl_tile_constant_unref, constant);
+}
+
 static gpointer
 gegl_memdup (gpointer src, gsize size)
 {
@@ -165,17 +320,50 @@ gegl_tile_unclone (GeglTile *tile)
       tile->data                     = gegl_memdup (tile->data, tile->size);
       tile->destroy_notify           = default_free;
       tile->destroy_notify_data      = NULL;
+      tile->read_only                = FALSE;
       tile->prev_shared->next_shared = tile->next_shared;
       tile->next_shared->prev_shared = tile->prev_shared;
       tile->prev_shared              = tile;
       tile->next_shared              = tile;
     }
+  else if (tile->read_only)
+    {
+      /* the tile data is borrowed, create a local copy and give the
+       * borrowed data back
+       */
+      guchar *data = gegl_memdup (tile->data, tile->size);
+
+      if (tile->destroy_notify)
+        tile->destroy_notify (tile->data, tile->destroy_notify_data);
+      tile->data                = data;
+      tile->destroy_notify      = default_free;
+      tile->destroy_notify_data = NULL;
+      tile->read_only           = FALSE;
+    }
 }
 #if 0
 static gint total_locks   = 0;
 static gint total_unlocks = 0;
 #endif
 
+/* reads the data back from the device, with the tile's mutex held */
+static void
+gegl_tile_cl_read (GeglTile *tile)
+{
+  cl_int errcode;
+
+  if (!tile->cl_dirty)
+    return;
+
+  errcode = gegl_clEnqueueReadBuffer (gegl_cl_get_command_queue (),
+                                      tile->cl_data, CL_TRUE, 0, tile->size,
+                                      tile->data, 0, NULL, NULL);
+  if (errcode != CL_SUCCESS)
+    g_warning ("[OpenCL] reading back tile %i,%i,%i: %s",
+               tile->x, tile->y, tile->z, gegl_cl_errstring (errcode));
+  tile->cl_dirty = FALSE;
+}
+
 void gegl_bt (void);
 
 void
@@ -183,6 +371,14 @@ gegl_tile_lock (GeglTile *tile)
 {
   g_mutex_lock (tile->mutex);
 
+  /* the data is changed on the host, which makes the device copy stale */
+  if (tile->cl_data)
+    {
+      gegl_tile_cl_read (tile);
+      gegl_cl_pool_release (tile->cl_data);
+      tile->cl_data = NULL;
+    }
+
   if (tile->lock != 0)
     {
       g_warning ("strange tile lock count: %i", tile->lock);
@@ -195,6 +391,11 @@ gegl_tile_lock (GeglTile *tile)
   tile->lock++;
   /*fprintf (stderr, "global tile locking: %i %i\n", locks, unlocks);*/
 
+  /* content written over constant data often stays constant, for
+   * instance fills of empty tiles, check again when unlocking
+   */
+  tile->check_constant = gegl_tile_is_constant (tile);
+
   gegl_tile_unclone (tile);
 }
 
@@ -210,7 +411,7 @@ _gegl_tile_void_pyramid (GeglTileSource *source,
   _gegl_tile_void_pyramid (source, x/2, y/2, z+1);
 }
 
-static void
+void
 gegl_tile_void_pyramid (GeglTile *tile)
 {
   if (tile->tile_storage &&
@@ -248,7 +449,21 @@ gegl_tile_unlock (GeglTile *tile)
       gegl_tile_void_pyramid (tile);
     }
   if (tile->lock==0)
-    tile->rev++;
+    {
+      gboolean was_stored = gegl_tile_is_stored (tile);
+
+      if (tile->check_constant && tile->tile_storage)
+        gegl_tile_make_constant (tile, tile->tile_storage->px_size);
+      tile->check_constant = FALSE;
+
+      tile->rev++;
+
+      /* let the cache know that this tile needs to be written back */
+      if (was_stored &&
+          tile->tile_storage &&
+          tile->tile_storage->cache)
+        gegl_tile_handler_cache_tile_dirtied (tile->tile_storage->cache, tile);
+    }
   g_mutex_unlock (tile->mutex);
 }
 
@@ -280,6 +495,7 @@ gboolean gegl_tile_store (GeglTile *tile)
     return TRUE;
   if (tile->tile_storage == NULL)
     return FALSE;
+  gegl_tile_cl_sync (tile);
   return gegl_tile_source_set_tile (GEGL_TILE_SOURCE (tile->tile_storage),
                                     tile->x,
                                     tile->y,
@@ -314,6 +530,17 @@ void gegl_tile_set_data_full (GeglTile         *tile,
   tile->destroy_notify_data = destroy_notify_data;
 }
 
+void gegl_tile_set_data_read_only (GeglTile         *tile,
+                                   gpointer          pixel_data,
+                                   gint              pixel_data_size,
+                                   GeglDestroyNotify destroy_notify,
+                                   gpointer          destroy_notify_data)
+{
+  gegl_tile_set_data_full (tile, pixel_data, pixel_data_size,
+                           destroy_notify, destroy_notify_data);
+  tile->read_only = TRUE;
+}
+
 
 void         gegl_tile_set_rev        (GeglTile *tile,
                                        guint     rev)
@@ -333,3 +560,83 @@ void gegl_tile_set_unlock_notify (GeglTile         *tile,
   tile->unlock_notify      = unlock_notify;
   tile->unlock_notify_data = unlock_notify_data;
 }
+
+cl_mem
+gegl_tile_cl_get_data (GeglTile *tile)
+{
+  cl_mem data;
+
+  g_mutex_lock (tile->mutex);
+  if (!tile->cl_data)
+    {
+      cl_int errcode;
+
+      tile->cl_data = gegl_cl_pool_alloc (CL_MEM_READ_WRITE, tile->size, &errcode);
+      if (errcode == CL_SUCCESS)
+        errcode = gegl_clEnqueueWriteBuffer (gegl_cl_get_command_queue (),
+                                             tile->cl_data, CL_TRUE, 0, tile->size,
+                                             tile->data, 0, NULL, NULL);
+      if (errcode != CL_SUCCESS && tile->cl_data)
+        gegl_cl_pool_release (tile->cl_data);
+      if (errcode != CL_SUCCESS)
+        tile->cl_data = NULL;
+    }
+
+  data = tile->cl_data;
+  if (data)
+    gegl_clRetainMemObject (data);
+  g_mutex_unlock (tile->mutex);
+
+  return data;
+}
+
+void
+gegl_tile_cl_set_data (GeglTile *tile,
+                       cl_mem    data)
+{
+  g_mutex_lock (tile->mutex);
+  tile->lock++;
+  tile->check_constant = FALSE;
+
+  /* the data on the host gets replaced as a whole when read back, shared
+   * and borrowed data is given up without copying it
+   */
+  if (tile->next_shared != tile || tile->read_only)
+    {
+      guchar *own = gegl_malloc (tile->size);
+
+      if (tile->next_shared != tile)
+        {
+          tile->prev_shared->next_shared = tile->next_shared;
+          tile->next_shared->prev_shared = tile->prev_shared;
+          tile->prev_shared              = tile;
+          tile->next_shared              = tile;
+        }
+      else if (tile->destroy_notify)
+        {
+          tile->destroy_notify (tile->data, tile->destroy_notify_data);
+        }
+      tile->data                = own;
+      tile->destroy_notify      = default_free;
+      tile->destroy_notify_data = NULL;
+      tile->read_only           = FALSE;
+    }
+
+  if (tile->cl_data)
+    gegl_cl_pool_release (tile->cl_data);
+  tile->cl_data  = data;
+  tile->cl_dirty = TRUE;
+
+  /* makes a new revision of the tile like other changes */
+  gegl_tile_unlock (tile);
+}
+
+void
+gegl_tile_cl_sync (GeglTile *tile)
+{
+  /* cl_dirty is set by other threads under the lock, it is only checked
+   * with the lock held, by gegl_tile_cl_read */
+  g_mutex_lock (tile->mutex);
+  gegl_tile_cl_read (tile);
+  g_mutex_unlock (tile->mutex);
+}
@@ -24,6 +24,14 @@
 
 GeglTile   * gegl_tile_new            (gint             size);
 GeglTile   * gegl_tile_new_bare       (void);
+
+/* a read only tile sharing its data with all other constant tiles of
+ * the same size and pixel value
+ */
+GeglTile   * gegl_tile_new_constant   (gint              size,
+                                       gint              px_size,
+                                       const guchar     *pixel);
+gboolean     gegl_tile_is_constant    (GeglTile         *tile);
 GeglTile   * gegl_tile_ref            (GeglTile         *tile);
 void         gegl_tile_unref          (GeglTile         *tile);
 
@@ -44,6 +52,11 @@ gboolean     gegl_tile_store          (GeglTile         *tile);
 void         gegl_tile_void           (GeglTile         *tile);
 GeglTile    *gegl_tile_dup            (GeglTile         *tile);
 
+/* void the tiles of the mipmap pyramid above a base level tile, needed
+ * when the content of a tile is replaced without locking it.
+ */
+void         gegl_tile_void_pyramid   (GeglTile         *tile);
+
 void         gegl_tile_set_rev        (GeglTile         *tile,
                                        guint             rev);
 guint        gegl_tile_get_rev        (GeglTile         *tile);
@@ -58,6 +71,16 @@ void         gegl_tile_set_data_full  (GeglTile         *tile,
                                        GeglDestroyNotify destroy_notify,
                                        gpointer          destroy_notify_data);
 
+/* like gegl_tile_set_data_full, but the data is not written to, the
+ * tile makes a private copy the first time it is locked
+ */
+void         gegl_tile_set_data_read_only
+                                      (GeglTile         *tile,
+                                       gpointer          pixel_data,
+                                       gint              pixel_data_size,
+                                       GeglDestroyNotify destroy_notify,
+                                       gpointer          destroy_notify_data);
+
 void         gegl_tile_set_unlock_notify
                                       (GeglTile         *tile,
                                        GeglTileCallback  unlock_notify,
@@ -28,20 +28,49 @@ G_DEFINE_TYPE (GeglConfig, gegl_config, G_TYPE_OBJECT)
 
 static GObjectClass * parent_class = NULL;
 
+static const gchar *tile_cache_policy_names[] = { "lru", "2q" };
+static const gchar *scheduler_policy_names[]  = { "none", "locality", "pinned" };
+
 enum
 {
   PROP_0,
   PROP_QUALITY,
   PROP_CACHE_SIZE,
+  PROP_CACHE_POLICY,
   PROP_CHUNK_SIZE,
   PROP_SWAP,
+  PROP_SWAP_COMPRESSION,
+  PROP_SWAP_QUEUE_SIZE,
   PROP_BABL_TOLERANCE,
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
   PROP_THREADS,
-  PROP_USE_OPENCL
+  PROP_THREAD_POLICY,
+  PROP_USE_OPENCL,
+  PROP_CL_POOL_SIZE
 };
 
+/* returns the index of name in names, warning about unknown names and
+ * using the first one instead
+ */
+static gint
+gegl_config_parse_policy (GParamSpec   *pspec,
+                          const gchar  *name,
+                          const gchar **names,
+                          gint          n_names)
+{
+  gint i;
+
+  if (name)
+    for (i = 0; i < n_names; i++)
+      if (g_str_equal (name, names[i]))
+        return i;
+
+  g_warning ("unknown %s \"%s\", using \"%s\"",
+             g_param_spec_get_name (pspec), name ? name : "", names[0]);
+  return 0;
+}
+
 static void
 gegl_config_get_property (GObject    *gobject,
                           guint       property_id,
@@ -52,10 +81,18 @@ gegl_config_get_property (GObject    *gobject,
 
   switch (property_id)
     {
+      case PROP_CL_POOL_SIZE:
+        g_value_set_int (value, config->cl_pool_size);
+        break;
+
       case PROP_CACHE_SIZE:
         g_value_set_int (value, config->cache_size);
         break;
 
+      case PROP_CACHE_POLICY:
+        g_value_set_string (value, config->cache_policy);
+        break;
+
       case PROP_CHUNK_SIZE:
         g_value_set_int (value, config->chunk_size);
         break;
@@ -80,10 +117,22 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_string (value, config->swap);
         break;
 
+      case PROP_SWAP_COMPRESSION:
+        g_value_set_boolean (value, config->swap_compression);
+        break;
+
+      case PROP_SWAP_QUEUE_SIZE:
+        g_value_set_int (value, config->swap_queue_size);
+        break;
+
       case PROP_THREADS:
         g_value_set_int (value, config->threads);
         break;
 
+      case PROP_THREAD_POLICY:
+        g_value_set_string (value, config->thread_policy);
+        break;
+
       case PROP_USE_OPENCL:
         g_value_set_boolean (value, config->use_opencl);
         break;
@@ -104,9 +153,22 @@ gegl_config_set_property (GObject      *gobject,
 
   switch (property_id)
     {
+      case PROP_CL_POOL_SIZE:
+        config->cl_pool_size = g_value_get_int (value);
+        break;
       case PROP_CACHE_SIZE:
         config->cache_size = g_value_get_int (value);
         break;
+      case PROP_CACHE_POLICY:
+        if (config->cache_policy)
+         g_free (config->cache_policy);
+        config->cache_policy = g_value_dup_string (value);
+        /* resolved here, the cache only ever reads the result */
+        g_atomic_int_set (&config->tile_cache_policy,
+                          gegl_config_parse_policy (pspec, config->cache_policy,
+                                                    tile_cache_policy_names,
+                                                    G_N_ELEMENTS (tile_cache_policy_names)));
+        break;
       case PROP_CHUNK_SIZE:
         config->chunk_size = g_value_get_int (value);
         break;
@@ -149,9 +211,24 @@ gegl_config_set_property (GObject      *gobject,
          g_free (config->swap);
         config->swap = g_value_dup_string (value);
         break;
+      case PROP_SWAP_COMPRESSION:
+        config->swap_compression = g_value_get_boolean (value);
+        break;
+      case PROP_SWAP_QUEUE_SIZE:
+        config->swap_queue_size = g_value_get_int (value);
+        break;
       case PROP_THREADS:
         config->threads = g_value_get_int (value);
         return;
+      case PROP_THREAD_POLICY:
+        if (config->thread_policy)
+         g_free (config->thread_policy);
+        config->thread_policy = g_value_dup_string (value);
+        g_atomic_int_set (&config->scheduler_policy,
+                          gegl_config_parse_policy (pspec, config->thread_policy,
+                                                    scheduler_policy_names,
+                                                    G_N_ELEMENTS (scheduler_policy_names)));
+        break;
       case PROP_USE_OPENCL:
         config->use_opencl = g_value_get_boolean (value);
 
@@ -173,6 +250,12 @@ gegl_config_finalize (GObject *gobject)
   if (config->swap)
     g_free (config->swap);
 
+  if (config->cache_policy)
+    g_free (config->cache_policy);
+
+  if (config->thread_policy)
+    g_free (config->thread_policy);
+
   G_OBJECT_CLASS (gegl_config_parent_class)->finalize (gobject);
 }
 
@@ -203,6 +286,10 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                      0, G_MAXINT, 512*1024*1024,
                                                      G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_CACHE_POLICY,
+                                   g_param_spec_string ("cache-policy", "Cache policy", "eviction policy of the tile cache, \"lru\" or the scan resistant \"2q\"", "lru",
+                                                     G_PARAM_READWRITE));
+
 
   g_object_class_install_property (gobject_class, PROP_CHUNK_SIZE,
                                    g_param_spec_int ("chunk-size", "Chunk size",
@@ -225,9 +312,23 @@ gegl_config_class_init (GeglConfigClass *klass)
                                    g_param_spec_string ("swap", "Swap", "where gegl stores it's swap files", NULL,
                                                      G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_SWAP_COMPRESSION,
+                                   g_param_spec_boolean ("swap-compression", "Swap compression", "compress tiles written to swap files",
+                                                     FALSE,
+                                                     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_SWAP_QUEUE_SIZE,
+                                   g_param_spec_int ("swap-queue-size", "Swap queue size", "bytes of tiles that may be waiting to be written to swap in the background, 0 writes synchronously",
+                                                     0, G_MAXINT, 32*1024*1024,
+                                                     G_PARAM_READWRITE));
+
   g_object_class_install_property (gobject_class, PROP_THREADS,
-                                   g_param_spec_int ("threads", "Number of concurrent evaluation threads", "default tile height for created buffers.",
-                                                     0, 16, 1,
+                                   g_param_spec_int ("threads", "Number of concurrent evaluation threads", "the number of concurrent processing threads to use",
+                                                     0, G_MAXINT, 1,
+                                                     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_THREAD_POLICY,
+                                   g_param_spec_string ("thread-policy", "Thread policy", "how work is divided among the threads, \"none\", \"locality\" keeping the tiles of a part of the image with the same thread, or \"pinned\" also pinning every thread to a cpu", "none",
                                                      G_PARAM_READWRITE));
 
   g_object_class_install_property (gobject_class, PROP_USE_OPENCL,
@@ -235,17 +336,29 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                      TRUE,
                                                      G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_CL_POOL_SIZE,
+                                   g_param_spec_int ("cl-pool-size", "OpenCL pool size", "bytes of device memory kept in idle OpenCL buffers for reuse, buffers in use are not limited by it",
+                                                     0, G_MAXINT, 128*1024*1024,
+                                                     G_PARAM_READWRITE));
+
 }
 
 static void
 gegl_config_init (GeglConfig *self)
 {
   self->swap        = NULL;
+  self->swap_compression = FALSE;
+  self->swap_queue_size  = 32 * 1024 * 1024;
   self->quality     = 1.0;
   self->cache_size  = 256 * 1024 * 1024;
+  self->cache_policy = g_strdup ("lru");
+  self->tile_cache_policy = GEGL_TILE_CACHE_LRU;
   self->chunk_size  = 512 * 512;
   self->tile_width  = 128;
   self->tile_height = 64;
   self->threads = 1;
+  self->thread_policy = g_strdup ("none");
+  self->scheduler_policy = GEGL_SCHEDULER_NONE;
   self->use_opencl = TRUE;
+  self->cl_pool_size = 128 * 1024 * 1024;
 }
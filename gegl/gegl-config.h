@@ -33,19 +33,48 @@ G_BEGIN_DECLS
 
 typedef struct _GeglConfigClass GeglConfigClass;
 
+/* eviction policies of the tile cache, selected by GeglConfig:cache-policy */
+typedef enum
+{
+  GEGL_TILE_CACHE_LRU,
+  GEGL_TILE_CACHE_2Q
+} GeglTileCachePolicy;
+
+/* how units are assigned to workers, selected by GeglConfig:thread-policy */
+typedef enum
+{
+  GEGL_SCHEDULER_NONE,     /* contiguous runs of units, unpinned threads */
+  GEGL_SCHEDULER_LOCALITY, /* every block of the tile grid has a home worker */
+  GEGL_SCHEDULER_PINNED    /* as locality, with every pool thread pinned to
+                              a cpu of its own */
+} GeglSchedulerPolicy;
+
 struct _GeglConfig
 {
   GObject  parent_instance;
 
   gchar   *swap;
+  gboolean swap_compression; /* compress tiles written to swap files */
+  gint     swap_queue_size;  /* bytes of tiles that may wait to be written to
+                                swap by the writer thread, 0 writes tiles
+                                synchronously */
   gint     cache_size;
+  gchar   *cache_policy; /* eviction policy of the tile cache, "lru" or "2q" */
+  gint     tile_cache_policy; /* the GeglTileCachePolicy cache_policy names,
+                                 read with g_atomic_int_get */
   gint     chunk_size; /* The size of elements being processed at once */
   gdouble  quality;
   gdouble  babl_tolerance;
   gint     tile_width;
   gint     tile_height;
   gint     threads;
+  gchar   *thread_policy; /* how work is divided among the threads, "none",
+                             "locality" or "pinned" */
+  gint     scheduler_policy; /* the GeglSchedulerPolicy thread_policy names,
+                                read with g_atomic_int_get */
   gboolean use_opencl;
+  gint     cl_pool_size; /* bytes of idle OpenCL buffers kept for reuse,
+                            the buffers in use aren't counted */
 };
 
 struct _GeglConfigClass
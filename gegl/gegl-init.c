@@ -202,11 +202,13 @@ gegl_init (gint    *argc,
 
 static gchar   *cmd_gegl_swap=NULL;
 static gchar   *cmd_gegl_cache_size=NULL;
+static gchar   *cmd_gegl_cache_policy=NULL;
 static gchar   *cmd_gegl_chunk_size=NULL;
 static gchar   *cmd_gegl_quality=NULL;
 static gchar   *cmd_gegl_tile_size=NULL;
 static gchar   *cmd_babl_tolerance =NULL;
 static gchar   *cmd_gegl_threads=NULL;
+static gchar   *cmd_gegl_thread_policy=NULL;
 
 static const GOptionEntry cmd_entries[]=
 {
@@ -225,6 +227,11 @@ static const GOptionEntry cmd_entries[]=
      G_OPTION_ARG_STRING, &cmd_gegl_cache_size,
      N_("How much memory to (approximately) use for caching imagery"), "<megabytes>"
     },
+    {
+     "gegl-cache-policy", 0, 0,
+     G_OPTION_ARG_STRING, &cmd_gegl_cache_policy,
+     N_("Eviction policy of the tile cache, lru or 2q"), "<policy>"
+    },
     {
      "gegl-tile-size", 0, 0,
      G_OPTION_ARG_STRING, &cmd_gegl_tile_size,
@@ -245,6 +252,11 @@ static const GOptionEntry cmd_entries[]=
      G_OPTION_ARG_STRING, &cmd_gegl_threads,
      N_("The number of concurrent processing threads to use."), "<threads>"
     },
+    {
+     "gegl-thread-policy", 0, 0,
+     G_OPTION_ARG_STRING, &cmd_gegl_thread_policy,
+     N_("How work is divided among the threads, none, locality or pinned"), "<policy>"
+    },
     { NULL }
 };
 
@@ -281,8 +293,15 @@ GeglConfig *gegl_config (void)
         config->quality = atof(g_getenv("GEGL_QUALITY"));
       if (g_getenv ("GEGL_CACHE_SIZE"))
         config->cache_size = atoi(g_getenv("GEGL_CACHE_SIZE"))* 1024*1024;
+      if (g_getenv ("GEGL_CACHE_POLICY"))
+        g_object_set (config, "cache-policy", g_getenv ("GEGL_CACHE_POLICY"), NULL);
       if (g_getenv ("GEGL_CHUNK_SIZE"))
         config->chunk_size = atoi(g_getenv("GEGL_CHUNK_SIZE"));
+      if (g_getenv ("GEGL_SWAP_COMPRESSION"))
+        config->swap_compression = atoi(g_getenv("GEGL_SWAP_COMPRESSION")) != 0;
+      if (g_getenv ("GEGL_SWAP_QUEUE_SIZE"))
+        config->swap_queue_size = CLAMP (atoi(g_getenv("GEGL_SWAP_QUEUE_SIZE")),
+                                         0, G_MAXINT / (1024*1024)) * 1024*1024;
       if (g_getenv ("GEGL_TILE_SIZE"))
         {
           const gchar *str = g_getenv ("GEGL_TILE_SIZE");
@@ -292,15 +311,13 @@ GeglConfig *gegl_config (void)
             config->tile_height = atoi(str+1);
         }
       if (g_getenv ("GEGL_THREADS"))
-        {
-          config->threads = atoi(g_getenv("GEGL_THREADS"));
-          if (config->threads > GEGL_MAX_THREADS)
-            {
-              g_warning ("Tried to use %i threads max is %i",
-                         config->threads, GEGL_MAX_THREADS);
-              config->threads = GEGL_MAX_THREADS;
-            }
-        }
+        config->threads = atoi(g_getenv("GEGL_THREADS"));
+      if (g_getenv ("GEGL_THREAD_POLICY"))
+        g_object_set (config, "thread-policy", g_getenv ("GEGL_THREAD_POLICY"), NULL);
+
+      if (g_getenv ("GEGL_CL_POOL_SIZE"))
+        config->cl_pool_size = CLAMP (atoi(g_getenv("GEGL_CL_POOL_SIZE")),
+                                      0, G_MAXINT / (1024*1024)) * 1024*1024;
 
       if (g_getenv ("GEGL_USE_OPENCL") == NULL || strcmp(g_getenv ("GEGL_USE_OPENCL"), "yes") == 0)
         config->use_opencl = TRUE;
@@ -316,6 +333,7 @@ GeglConfig *gegl_config (void)
 void gegl_tile_backend_ram_stats (void);
 void gegl_tile_backend_tiledir_stats (void);
 void gegl_tile_backend_file_stats (void);
+void gegl_tile_backend_file_cleanup (void);
 
 
 static void swap_clean (void)
@@ -364,9 +382,14 @@ gegl_exit (void)
 
   gegl_tile_storage_cache_cleanup ();
   gegl_tile_cache_destroy ();
+  gegl_tile_backend_file_cleanup ();
   gegl_operation_gtype_cleanup ();
   gegl_extension_handler_cleanup ();
 
+  /* after the tiles have given back their device buffers */
+  if (cl_status.is_opencl_available)
+    gegl_cl_pool_cleanup ();
+
   if (module_db != NULL)
     {
       g_object_unref (module_db);
@@ -385,6 +408,9 @@ gegl_exit (void)
       gegl_tile_backend_ram_stats ();
       gegl_tile_backend_file_stats ();
       gegl_tile_backend_tiledir_stats ();
+      gegl_tile_cache_stats ();
+      if (cl_status.is_opencl_available)
+        gegl_cl_pool_stats ();
     }
   global_time = gegl_ticks () - global_time;
   gegl_instrument ("gegl", "gegl", global_time);
@@ -485,6 +511,8 @@ gegl_post_parse_hook (GOptionContext *context,
     config->quality = atof (cmd_gegl_quality);
   if (cmd_gegl_cache_size)
     config->cache_size = atoi (cmd_gegl_cache_size)*1024*1024;
+  if (cmd_gegl_cache_policy)
+    g_object_set (config, "cache-policy", cmd_gegl_cache_policy, NULL);
   if (cmd_gegl_chunk_size)
     config->chunk_size = atoi (cmd_gegl_chunk_size);
   if (cmd_gegl_tile_size)
@@ -497,6 +525,8 @@ gegl_post_parse_hook (GOptionContext *context,
     }
   if (cmd_gegl_threads)
     config->threads = atoi (cmd_gegl_threads);
+  if (cmd_gegl_thread_policy)
+    g_object_set (config, "thread-policy", cmd_gegl_thread_policy, NULL);
   if (cmd_babl_tolerance)
     g_object_set (config, "babl-tolerance", atof(cmd_babl_tolerance), NULL);
 
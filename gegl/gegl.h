@@ -20,6 +20,7 @@
 #define __GEGL_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <babl/babl.h>
 
 #include <gegl-types.h>
@@ -809,6 +810,53 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
 gboolean       gegl_processor_work          (GeglProcessor *processor,
                                              gdouble       *progress);
 
+/**
+ * gegl_processor_prioritize:
+ * @processor: a #GeglProcessor
+ * @rectangle: the #GeglRectangle to render first
+ *
+ * Makes the processor render the part of @rectangle within its rectangle
+ * before the rest, for instance the part of an image that is visible on
+ * screen. Rectangles prioritized later are rendered first.
+ */
+void           gegl_processor_prioritize    (GeglProcessor       *processor,
+                                             const GeglRectangle *rectangle);
+
+/**
+ * gegl_processor_render_async:
+ * @processor: a #GeglProcessor
+ * @priority: the priority of the work in the main loop, for example
+ * G_PRIORITY_DEFAULT_IDLE.
+ * @cancellable: (allow-none): a #GCancellable or NULL.
+ * @callback: called when all of the work is done or it was cancelled.
+ * @user_data: data passed to @callback.
+ *
+ * Does the work of the processor step by step from the thread default
+ * main context, as if #gegl_processor_work was called repeatedly. The
+ * processor emits "computed" with every rectangle rendered, and work
+ * stops before the next step when @cancellable is cancelled, keeping
+ * what has been rendered so far. Only one render can be running on a
+ * processor at a time.
+ */
+void           gegl_processor_render_async  (GeglProcessor       *processor,
+                                             gint                 priority,
+                                             GCancellable        *cancellable,
+                                             GAsyncReadyCallback  callback,
+                                             gpointer             user_data);
+
+/**
+ * gegl_processor_render_finish:
+ * @processor: a #GeglProcessor
+ * @result: the #GAsyncResult passed to the callback.
+ * @error: return location for an error, or NULL.
+ *
+ * Returns TRUE if all work was done, or FALSE with @error set to
+ * G_IO_ERROR_CANCELLED if the render was cancelled.
+ */
+gboolean       gegl_processor_render_finish (GeglProcessor       *processor,
+                                             GAsyncResult        *result,
+                                             GError             **error);
+
 
 /**
  * gegl_processor_destroy:
@@ -44,6 +44,7 @@
 #include "process/gegl-prepare-visitor.h"
 #include "process/gegl-finish-visitor.h"
 #include "process/gegl-processor.h"
+#include "process/gegl-scheduler.h"
 
 enum
 {
@@ -51,9 +52,16 @@ enum
   PROP_OP_CLASS,
   PROP_OPERATION,
   PROP_NAME,
-  PROP_DONT_CACHE
+  PROP_DONT_CACHE,
+  PROP_CACHE_MODE,
+  PROP_CACHE_LIMIT
 };
 
+/* the pixels a node must have processed before its cost is trusted */
+#define COST_MIN_PIXELS (64 * 64)
+
+static const gchar *cache_mode_names[] = { "always", "never", "expensive" };
+
 enum
 {
   INVALIDATED,
@@ -71,7 +79,11 @@ struct _GeglNodePrivate
   gchar          *name;
   GeglProcessor  *processor;
   GHashTable     *contexts;
-  GeglEvalMgr    *eval_mgr[GEGL_MAX_THREADS];
+  GSList         *eval_mgrs; /* idle eval mgrs, protected by the node's mutex */
+
+  gint64          process_usecs;  /* processing time measured so far, and */
+  gint64          process_pixels; /* the pixels processed in it, both
+                                     protected by the node's mutex */
 };
 
 
@@ -154,6 +166,20 @@ gegl_node_class_init (GeglNodeClass *klass)
                                                         TRUE,
                                                         G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_CACHE_MODE,
+                                   g_param_spec_string ("cache-mode",
+                                                        "Cache mode",
+                                                        "Which results of this operation are cached, \"always\", \"never\" or \"expensive\" to only cache operations measured to be expensive to render. The node a GeglProcessor renders is always cached, as its cache holds the results of the processor. The property is inherited by children created from a node.",
+                                                        "always",
+                                                        G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_CACHE_LIMIT,
+                                   g_param_spec_int ("cache-limit",
+                                                     "Cache limit",
+                                                     "The most bytes of results kept in the cache of this operation, results that don't fit are rendered without being cached, 0 for no limit. It doesn't apply to the node a GeglProcessor renders. The property is inherited by children created from a node.",
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READWRITE));
+
 
   g_object_class_install_property (gobject_class, PROP_NAME,
                                    g_param_spec_string ("name",
@@ -232,15 +258,9 @@ gegl_node_dispose (GObject *gobject)
       self->cache = NULL;
     }
 
-  {
-    gint i;
-    for (i=0; i<GEGL_MAX_THREADS; i++)
-      if (self->priv->eval_mgr[i])
-        {
-          g_object_unref (self->priv->eval_mgr[i]);
-          self->priv->eval_mgr[i] = NULL;
-        }
-  }
+  g_slist_foreach (self->priv->eval_mgrs, (GFunc) g_object_unref, NULL);
+  g_slist_free (self->priv->eval_mgrs);
+  self->priv->eval_mgrs = NULL;
 
   if (self->priv->processor)
     {
@@ -302,6 +322,28 @@ gegl_node_local_set_property (GObject      *gobject,
         node->dont_cache = g_value_get_boolean (value);
         break;
 
+      case PROP_CACHE_MODE:
+        {
+          const gchar *name = g_value_get_string (value);
+          gint         i;
+
+          node->cache_mode = GEGL_CACHE_MODE_ALWAYS;
+          for (i = 0; name && i < G_N_ELEMENTS (cache_mode_names); i++)
+            if (g_str_equal (name, cache_mode_names[i]))
+              break;
+
+          if (name && i < G_N_ELEMENTS (cache_mode_names))
+            node->cache_mode = i;
+          else
+            g_warning ("unknown cache-mode \"%s\", using \"always\"",
+                       name ? name : "");
+        }
+        break;
+
+      case PROP_CACHE_LIMIT:
+        node->cache_limit = g_value_get_int (value);
+        break;
+
       case PROP_OP_CLASS:
         {
           va_list null; /* dummy to pass along, it's not used anyways since
@@ -343,6 +385,12 @@ gegl_node_local_get_property (GObject    *gobject,
       case PROP_DONT_CACHE:
         g_value_set_boolean (value, node->dont_cache);
         break;
+      case PROP_CACHE_MODE:
+        g_value_set_string (value, cache_mode_names[node->cache_mode]);
+        break;
+      case PROP_CACHE_LIMIT:
+        g_value_set_int (value, node->cache_limit);
+        break;
       case PROP_NAME:
         g_value_set_string (value, gegl_node_get_name (node));
         break;
@@ -526,6 +574,30 @@ gegl_node_connect_to (GeglNode    *source,
   return gegl_node_connect_from (sink, sink_pad_name, source, source_pad_name);
 }
 
+/* makes node and the nodes downstream of it get prepared and their
+ * bounding boxes computed again, for changes that aren't propagated as
+ * invalidations
+ */
+static void
+gegl_node_invalidate_setup (GeglNode *node)
+{
+  GSList *iter;
+
+  node->valid_prepare   = FALSE;
+  node->valid_have_rect = FALSE;
+
+  for (iter = node->priv->sink_connections; iter; iter = iter->next)
+    {
+      GeglNode *sink = gegl_connection_get_sink_node (iter->data);
+
+      /* the nodes downstream of an invalid node are invalid already,
+       * branches joining again are only walked once
+       */
+      if (sink->valid_prepare || sink->valid_have_rect)
+        gegl_node_invalidate_setup (sink);
+    }
+}
+
 void
 gegl_node_invalidated (GeglNode            *node,
                        const GeglRectangle *rect,
@@ -542,6 +614,7 @@ gegl_node_invalidated (GeglNode            *node,
         gegl_buffer_clear (GEGL_BUFFER (node->cache), rect);
       gegl_cache_invalidate (node->cache, rect);
     }
+  node->valid_prepare   = FALSE;
   node->valid_have_rect = FALSE;
 
   g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
@@ -704,6 +777,7 @@ gegl_node_disconnect (GeglNode    *sink,
       }
 
       gegl_pad_disconnect (sink_pad, source_pad, connection);
+      gegl_node_invalidate_setup (real_sink);
 
       real_sink->priv->source_connections = g_slist_remove (real_sink->priv->source_connections, connection);
       source->priv->sink_connections = g_slist_remove (source->priv->sink_connections, connection);
@@ -826,42 +900,70 @@ gegl_node_link_many (GeglNode *source,
   va_end (var_args);
 }
 
-static void gegl_node_ensure_eval_mgr (GeglNode    *self,
-                                       const gchar *pad,
-                                       gint         no)
+/* every evaluation running on the node takes an eval mgr of its own,
+ * the eval mgr is the id of the operation contexts, so evaluations of
+ * different rois by different threads don't share any contexts
+ */
+static GeglEvalMgr *
+gegl_node_take_eval_mgr (GeglNode    *self,
+                         const gchar *pad)
 {
-  if (!self->priv->eval_mgr[no])
-    self->priv->eval_mgr[no] = gegl_eval_mgr_new (self, pad);
+  GeglEvalMgr *eval_mgr = NULL;
+  GSList      *llink;
+
+  g_mutex_lock (self->mutex);
+  for (llink = self->priv->eval_mgrs; llink; llink = g_slist_next (llink))
+    {
+      GeglEvalMgr *idle = llink->data;
+
+      if (!strcmp (idle->pad_name, pad))
+        {
+          eval_mgr = idle;
+          self->priv->eval_mgrs = g_slist_delete_link (self->priv->eval_mgrs,
+                                                       llink);
+          break;
+        }
+    }
+  g_mutex_unlock (self->mutex);
+
+  if (!eval_mgr)
+    eval_mgr = gegl_eval_mgr_new (self, pad);
+
+  return eval_mgr;
+}
+
+static void
+gegl_node_release_eval_mgr (GeglNode    *self,
+                            GeglEvalMgr *eval_mgr)
+{
+  g_mutex_lock (self->mutex);
+  self->priv->eval_mgrs = g_slist_prepend (self->priv->eval_mgrs, eval_mgr);
+  g_mutex_unlock (self->mutex);
 }
 
 /* Will set the eval_mgr's roi to the supplied roi if defined, otherwise
  * it will use the node's bounding box. Then the gegl_eval_mgr_apply will
- * be called.
+ * be called. May be called by several threads at once.
  */
 static GeglBuffer *
 gegl_node_apply_roi (GeglNode            *self,
                      const gchar         *output_pad_name,
-                     const GeglRectangle *roi,
-                     gint                 tid)
+                     const GeglRectangle *roi)
 {
-  /* This is a potential spot to multiplex paralell processing,
-   * doing so, might cause a lot of tile overlap between
-   * processes if were not careful (wouldn't neccesarily be totally
-   * bad if that happens though.
-   */
-  GeglBuffer *buffer;
-
-  /*g_print ("%i %i %i %i %i\n", tid, roi->x, roi->y, roi->width, roi->height);*/
+  GeglEvalMgr *eval_mgr = gegl_node_take_eval_mgr (self, output_pad_name);
+  GeglBuffer  *buffer;
 
   if (roi)
     {
-      self->priv->eval_mgr[tid]->roi = *roi;
+      eval_mgr->roi = *roi;
     }
   else
     {
-      self->priv->eval_mgr[tid]->roi = gegl_node_get_bounding_box (self);
+      eval_mgr->roi = gegl_node_get_bounding_box (self);
     }
-  buffer = gegl_eval_mgr_apply (self->priv->eval_mgr[tid]);
+  buffer = gegl_eval_mgr_apply (eval_mgr);
+
+  gegl_node_release_eval_mgr (self, eval_mgr);
   return buffer;
 }
 
@@ -869,7 +971,6 @@ gegl_node_apply_roi (GeglNode            *self,
 typedef struct ThreadData
 {
   GeglNode      *node;
-  gint           tid;
   GeglRectangle  roi;
   const gchar   *pad;
 
@@ -877,37 +978,33 @@ typedef struct ThreadData
   gpointer             destination_buf;
   gint                 rowstride;
   GeglBlitFlags        flags;
-} ThreadData;
 
-static GThreadPool *pool = NULL;
-static GMutex *mutex = NULL;
-static GCond  *cond = NULL;
-static gint    remaining_tasks = 0;
+  GeglBuffer          *destination_buffer;
+} ThreadData;
 
-static void spawnrender (gpointer data,
-                         gpointer foo)
+/* renders one unit of a blit */
+static void
+blit_unit (const GeglRectangle *unit,
+           gint                 worker,
+           gpointer             data)
 {
   ThreadData *td = data;
-  GeglBuffer * buffer;
-  buffer = gegl_node_apply_roi (td->node, td->pad, &td->roi, td->tid);
+  GeglBuffer *buffer;
+
+  buffer = gegl_node_apply_roi (td->node, td->pad, unit);
 
   if ((buffer ) && td->destination_buf)
     {
-      gegl_buffer_get (buffer, 1.0, &td->roi, td->format, td->destination_buf, td->rowstride);
+      gchar *dst = (gchar *) td->destination_buf +
+                   (unit->y - td->roi.y) * td->rowstride +
+                   (unit->x - td->roi.x) * babl_format_get_bytes_per_pixel (td->format);
+
+      gegl_buffer_get (buffer, 1.0, unit, td->format, dst, td->rowstride);
     }
 
   /* and unrefing to ultimately clean it off from the graph */
   if (buffer)
     g_object_unref (buffer);
-
-  g_mutex_lock (mutex);
-  remaining_tasks --;
-  if (remaining_tasks == 0)
-    {
-      /* we were the last task, we're not busy rendering any more */
-      g_cond_signal (cond);
-    }
-  g_mutex_unlock (mutex);
 }
 
 
@@ -925,93 +1022,34 @@ gegl_node_blit (GeglNode            *self,
   g_return_if_fail (roi != NULL);
 
   threads = gegl_config ()->threads;
-  if (threads > GEGL_MAX_THREADS)
-    threads = 1;
-
-  if (pool == NULL)
-    {
-      pool = g_thread_pool_new (spawnrender, NULL, threads, TRUE, NULL);
-      mutex = g_mutex_new ();
-      cond = g_cond_new ();
-    }
 
   if (flags == GEGL_BLIT_DEFAULT)
 #if 1  /* multi threaded version */
     {
-      ThreadData data[GEGL_MAX_THREADS];
-      gint i;
-
-      /* Subdivide along the largest of width/height, this should be further
-       * extended similar to the subdivizion done in GeglProcessor, to get as
-       * square as possible subregions.
-       */
-      gboolean horizontal = roi->width > roi->height;
-
-      gint rowskip = 0;
+      ThreadData data;
 
       if (!format)
         format = babl_format ("RGBA float"); /* XXX: This probably duplicates
                                                 another hardcoded format, they
                                                 should be turned into a
                                                 constant. */
-      if (horizontal)
-        rowskip = (roi->width/threads) * babl_format_get_bytes_per_pixel (format);
 
       if (rowstride == GEGL_AUTO_ROWSTRIDE)
         rowstride = roi->width * babl_format_get_bytes_per_pixel (format);
 
-      data[0].node = self;
-      data[0].pad = "output";
-      data[0].format = format;
-      data[0].destination_buf = destination_buf;
-      data[0].rowstride = rowstride;
-      data[0].flags = flags;
-
-      for (i=0;i<threads;i++)
-        {
-          data[i] = data[0];
-          data[i].roi = *roi;
-          gegl_node_ensure_eval_mgr (self, "output", i);
-          if (horizontal)
-            {
-              data[i].roi.width = roi->width / threads;
-              data[i].roi.x = roi->x + roi->width/threads * i;
-            }
-          else
-            {
-              data[i].roi.height = roi->height / threads;
-              data[i].roi.y = roi->y + roi->height/threads * i;
-            }
-
-          data[i].tid = i;
-          if (horizontal)
-            data[i].destination_buf = ((gchar*)destination_buf + rowskip * i);
-          else
-            data[i].destination_buf = ((gchar*)destination_buf + rowstride * (roi->height/threads) * i);
-        }
-      if (horizontal)
-        data[threads-1].roi.width = roi->width - (roi->width / threads)*(threads-1);
-      else
-        data[threads-1].roi.height = roi->height - (roi->height / threads)*(threads-1);
-
-      remaining_tasks+=threads;
-
-      if (threads==1)
-        {
-          for (i=0; i<threads; i++)
-              spawnrender (&data[i], NULL);
-        }
-      else
-        {
-          for (i=0; i<threads-1; i++)
-            g_thread_pool_push (pool, &data[i], NULL);
-          spawnrender (&data[threads-1], NULL);
-
-          g_mutex_lock (mutex);
-          while (remaining_tasks!=0)
-            g_cond_wait (cond, mutex);
-          g_mutex_unlock (mutex);
-        }
+      data.node = self;
+      data.pad = "output";
+      data.roi = *roi;
+      data.format = format;
+      data.destination_buf = destination_buf;
+      data.rowstride = rowstride;
+      data.flags = flags;
+
+      /* tile aligned units, idle threads steal units from busy ones */
+      gegl_scheduler_run (roi,
+                          gegl_config ()->tile_width,
+                          gegl_config ()->tile_height,
+                          threads, blit_unit, &data);
     }
 #else /* thread free version, could be removed, left behind in case it 
          is needed for debugging
@@ -1019,8 +1057,7 @@ gegl_node_blit (GeglNode            *self,
     {
       GeglBuffer *buffer;
 
-      gegl_node_ensure_eval_mgr (self, "output", 0);
-      buffer = gegl_node_apply_roi (self, "output", roi, 0);
+      buffer = gegl_node_apply_roi (self, "output", roi);
       if (buffer && destination_buf)
         {
           if (destination_buf)
@@ -1059,6 +1096,55 @@ gegl_node_blit (GeglNode            *self,
     }
 }
 
+/* renders one unit of gegl_node_blit_buffer, copying the result into
+ * the destination tiles
+ */
+static void
+blit_buffer_unit (const GeglRectangle *unit,
+                  gint                 worker,
+                  gpointer             data)
+{
+  ThreadData *td = data;
+  GeglBuffer *buffer;
+
+  buffer = gegl_node_apply_roi (td->node, td->pad, unit);
+
+  if (buffer)
+    {
+      if (buffer != td->destination_buffer)
+        gegl_buffer_copy (buffer, unit, td->destination_buffer, unit);
+      g_object_unref (buffer);
+    }
+}
+
+void
+gegl_node_blit_buffer (GeglNode            *self,
+                       GeglBuffer          *buffer,
+                       const GeglRectangle *rects,
+                       gint                 n_rects)
+{
+  ThreadData data = { 0, };
+  gint       threads;
+
+  g_return_if_fail (GEGL_IS_NODE (self));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  threads = gegl_config ()->threads;
+
+  data.node = self;
+  data.pad = "output";
+  data.destination_buffer = buffer;
+
+  if (n_rects == 1)
+    gegl_scheduler_run (&rects[0],
+                        gegl_config ()->tile_width,
+                        gegl_config ()->tile_height,
+                        threads, blit_buffer_unit, &data);
+  else
+    gegl_scheduler_run_units (rects, n_rects, threads,
+                              blit_buffer_unit, &data);
+}
+
 static GSList *
 gegl_node_get_depends_on (GeglNode *self)
 {
@@ -1163,7 +1249,8 @@ gegl_node_invalidate_have_rect (GObject    *gobject,
                                 gpointer    foo,
                                 gpointer    user_data)
 {
-  GEGL_NODE (user_data)->valid_have_rect = FALSE;
+  /* also covers the properties that don't invalidate, like buffers */
+  gegl_node_invalidate_setup (GEGL_NODE (user_data));
   return TRUE;
 }
 
@@ -1276,6 +1363,7 @@ gegl_node_set_operation_object (GeglNode      *self,
       }
 
     gegl_operation_attach (operation, self);
+    gegl_node_invalidate_setup (self);
 
     /* FIXME: handle this in a more generic way, but it is needed to allow
      * the attach to work properly.
@@ -1764,7 +1852,7 @@ gegl_node_process (GeglNode *self)
 
   input   = gegl_node_get_producer (self, "input", NULL);
   defined = gegl_node_get_bounding_box (input);
-  buffer  = gegl_node_apply_roi (input, "output", &defined, 3);
+  buffer  = gegl_node_apply_roi (input, "output", &defined);
 
   g_assert (GEGL_IS_BUFFER (buffer));
   context = gegl_node_add_context (self, &defined);
@@ -2017,6 +2105,58 @@ gegl_node_get_cache (GeglNode *node)
   return node->cache;
 }
 
+gboolean
+gegl_node_use_cache (GeglNode            *node,
+                     const GeglRectangle *roi)
+{
+  g_return_val_if_fail (GEGL_IS_NODE (node), FALSE);
+  g_return_val_if_fail (roi != NULL, FALSE);
+
+  if (node->dont_cache ||
+      node->cache_mode == GEGL_CACHE_MODE_NEVER ||
+      GEGL_OPERATION_GET_CLASS (node->operation)->no_cache)
+    return FALSE;
+
+  /* cheap operations are rendered again rather than taking up cache */
+  if (node->cache_mode == GEGL_CACHE_MODE_EXPENSIVE &&
+      gegl_node_get_process_cost (node) < GEGL_CACHE_EXPENSIVE_COST)
+    return FALSE;
+
+  if (node->cache_limit > 0 &&
+      !gegl_cache_has_room (gegl_node_get_cache (node), roi, node->cache_limit))
+    return FALSE;
+
+  return TRUE;
+}
+
+void
+gegl_node_add_process_time (GeglNode            *node,
+                            const GeglRectangle *roi,
+                            glong                usecs)
+{
+  g_return_if_fail (GEGL_IS_NODE (node));
+
+  g_mutex_lock (node->mutex);
+  node->priv->process_usecs  += usecs;
+  node->priv->process_pixels += (gint64) roi->width * roi->height;
+  g_mutex_unlock (node->mutex);
+}
+
+gdouble
+gegl_node_get_process_cost (GeglNode *node)
+{
+  gdouble cost = -1.0;
+
+  g_return_val_if_fail (GEGL_IS_NODE (node), -1.0);
+
+  g_mutex_lock (node->mutex);
+  if (node->priv->process_pixels >= COST_MIN_PIXELS)
+    cost = (gdouble) node->priv->process_usecs / node->priv->process_pixels;
+  g_mutex_unlock (node->mutex);
+
+  return cost;
+}
+
 const gchar *
 gegl_node_get_name (GeglNode *self)
 {
@@ -2065,7 +2205,9 @@ gegl_node_add_child (GeglNode *self,
   self->is_graph      = TRUE;
   child->priv->parent = self;
 
-  child->dont_cache = self->dont_cache;
+  child->dont_cache   = self->dont_cache;
+  child->cache_mode = self->cache_mode;
+  child->cache_limit  = self->cache_limit;
 
   return child;
 }
@@ -2174,7 +2316,9 @@ gegl_node_create_child (GeglNode    *self,
   ret = gegl_node_new_child (self, "operation", operation, NULL);
   if (ret && self)
     {
-      ret->dont_cache = self->dont_cache;
+      ret->dont_cache   = self->dont_cache;
+      ret->cache_mode = self->cache_mode;
+      ret->cache_limit  = self->cache_limit;
     }
   return ret;
 }
@@ -26,6 +26,22 @@
 
 G_BEGIN_DECLS
 
+/* which results of a node are kept in its cache, set with the
+ * "cache-mode" property
+ */
+typedef enum
+{
+  GEGL_CACHE_MODE_ALWAYS,    /* every result that fits in the cache */
+  GEGL_CACHE_MODE_NEVER,     /* as with "dont-cache" */
+  GEGL_CACHE_MODE_EXPENSIVE  /* only once the node has been measured to
+                                be expensive to render */
+} GeglCacheMode;
+
+/* the processing time in microseconds per pixel above which a node with
+ * the expensive cache mode is cached
+ */
+#define GEGL_CACHE_EXPENSIVE_COST 0.02
+
 #define GEGL_NODE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_NODE, GeglNodeClass))
 #define GEGL_IS_NODE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_NODE))
 #define GEGL_NODE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_NODE, GeglNodeClass))
@@ -50,6 +66,11 @@ struct _GeglNode
    */
   gboolean        valid_have_rect;
 
+  /* If TRUE the operation has been prepared since its properties or
+   * inputs last changed, and doesn't need to be prepared again
+   */
+  gboolean        valid_prepare;
+
   /* All the pads on this node, depends on operation */
   GSList         *pads;
 
@@ -75,6 +96,13 @@ struct _GeglNode
   /* Whether result is cached or not, inherited by children */
   gboolean        dont_cache;
 
+  /* Which results are cached and the most bytes of valid results the
+   * cache holds, results that don't fit are not cached until parts of the
+   * cache are invalidated. 0 for no limit, inherited by children
+   */
+  GeglCacheMode   cache_mode;
+  gint            cache_limit;
+
   GMutex         *mutex;
 
   /*< private >*/
@@ -96,6 +124,13 @@ void          gegl_node_blit                (GeglNode            *node,
                                              gint                 rowstride,
                                              GeglBlitFlags        flags);
 
+/* renders rectangles of the output of node into the tiles of buffer,
+ * the rectangles are rendered concurrently and should not overlap */
+void          gegl_node_blit_buffer         (GeglNode            *node,
+                                             GeglBuffer          *buffer,
+                                             const GeglRectangle *rects,
+                                             gint                 n_rects);
+
 void          gegl_node_process             (GeglNode      *self);
 void          gegl_node_link                (GeglNode      *source,
                                              GeglNode      *sink);
@@ -213,6 +248,22 @@ gint          gegl_node_get_consumers       (GeglNode      *node,
                                              const gchar ***pads);
 
 GeglCache   * gegl_node_get_cache           (GeglNode      *node);
+
+/* whether the result of node for roi is to be rendered into its cache,
+ * following its cache policy and limit
+ */
+gboolean      gegl_node_use_cache           (GeglNode      *node,
+                                             const GeglRectangle *roi);
+
+/* accounts usecs of processing roi to the cost of node */
+void          gegl_node_add_process_time    (GeglNode      *node,
+                                             const GeglRectangle *roi,
+                                             glong          usecs);
+
+/* the measured processing time of node in microseconds per pixel, or a
+ * negative value when too little has been processed to tell
+ */
+gdouble       gegl_node_get_process_cost    (GeglNode      *node);
 void          gegl_node_invalidated         (GeglNode      *node,
                                              const GeglRectangle *rect,
                                              gboolean             clean_cache);
@@ -229,8 +280,6 @@ void          gegl_node_set_name            (GeglNode      *self,
 #define gegl_object_get_has_forked(object) \
       (g_object_get_data(G_OBJECT(object), "gegl has-forked")!=NULL)
 
-#define GEGL_MAX_THREADS 16
-
 G_END_DECLS
 
 #endif /* __GEGL_NODE_H__ */
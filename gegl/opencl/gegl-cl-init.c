@@ -24,6 +24,8 @@
  *
 ******************************************************************************/
 
+#include "config.h"
+
 #define __DYNAMIC_LOADING_CL_MAIN_C__
 #include "gegl-cl-init.h"
 #undef  __DYNAMIC_LOADING_CL_MAIN_C__
@@ -353,17 +355,26 @@ gegl_cl_init(GError **gError)
             return FALSE;
         }
 
-        /* Initialize OpenCL - Access to available device */
+        /* Initialize OpenCL - Access to available device, preferring
+         * gpus but falling back to cpu implementations like POCL */
         cl_int num_of_devices;
+        cl_device_type device_type = CL_DEVICE_TYPE_GPU;
         status = gegl_clGetDeviceIDs(
-            cl_status.platform_id, CL_DEVICE_TYPE_GPU,
+            cl_status.platform_id, device_type,
             0, NULL, &num_of_devices);
+        if (CL_SUCCESS != status || num_of_devices <= 0)
+        {
+            device_type = CL_DEVICE_TYPE_ALL;
+            status = gegl_clGetDeviceIDs(
+                cl_status.platform_id, device_type,
+                0, NULL, &num_of_devices);
+        }
         if (CL_SUCCESS == status && num_of_devices > 0)
         {
             cl_device_id *devices = (cl_device_id*)
                 malloc(num_of_devices * sizeof(cl_device_id));
             status = gegl_clGetDeviceIDs(
-                cl_status.platform_id, CL_DEVICE_TYPE_GPU,
+                cl_status.platform_id, device_type,
                 num_of_devices, devices, NULL);
             if (CL_SUCCESS != status)
             {
@@ -415,18 +426,176 @@ gegl_cl_init(GError **gError)
 
 #undef CL_LOAD_FUNCTION
 
+/* if this function returns NULL compiled programs are not cached, the
+ * GEGL_CL_CACHE environment variable sets the directory to use, or
+ * disables the cache when set to "none"
+ */
+static const gchar *
+gegl_cl_cache_dir (void)
+{
+  static gboolean  initialized = FALSE;
+  static gchar    *cache_dir   = NULL;
+
+  if (!initialized)
+    {
+      initialized = TRUE;
+
+      if (g_getenv ("GEGL_CL_CACHE"))
+        {
+          if (g_str_equal (g_getenv ("GEGL_CL_CACHE"), "none"))
+            cache_dir = NULL;
+          else
+            cache_dir = g_strdup (g_getenv ("GEGL_CL_CACHE"));
+        }
+      else
+        {
+          cache_dir = g_build_filename (g_get_user_cache_dir (),
+                                        GEGL_LIBRARY,
+                                        "opencl",
+                                        NULL);
+        }
+
+      if (cache_dir &&
+          ! g_file_test (cache_dir, G_FILE_TEST_IS_DIR) &&
+          g_mkdir_with_parents (cache_dir, 0700) != 0)
+        {
+          g_free (cache_dir);
+          cache_dir = NULL;
+        }
+    }
+
+  return cache_dir;
+}
+
+/* returns the file the binary of a program is cached in, named after a
+ * checksum of everything the compiled program depends on
+ */
+static gchar *
+gegl_cl_binary_path (const char *program_source)
+{
+  static const cl_device_info device_info[] = { CL_DEVICE_NAME,
+                                                CL_DEVICE_VERSION,
+                                                CL_DRIVER_VERSION };
+  GChecksum *checksum;
+  gchar     *name;
+  gchar     *path;
+  char       info[300];
+  gint       i;
+
+  if (!gegl_cl_cache_dir ())
+    return NULL;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  g_checksum_update (checksum, (const guchar *) program_source, -1);
+  g_checksum_update (checksum, (const guchar *) "\n", 1);
+  g_checksum_update (checksum, (const guchar *) cl_status.platform_name, -1);
+  g_checksum_update (checksum, (const guchar *) "\n", 1);
+  g_checksum_update (checksum, (const guchar *) cl_status.platform_version, -1);
+
+  for (i = 0; i < G_N_ELEMENTS (device_info); i++)
+    {
+      if (gegl_clGetDeviceInfo (gegl_cl_get_device_id (), device_info[i],
+                                sizeof (info), info, NULL) != CL_SUCCESS)
+        {
+          g_checksum_free (checksum);
+          return NULL;
+        }
+      g_checksum_update (checksum, (const guchar *) "\n", 1);
+      g_checksum_update (checksum, (const guchar *) info, -1);
+    }
+
+  name = g_strconcat (g_checksum_get_string (checksum), ".bin", NULL);
+  path = g_build_filename (gegl_cl_cache_dir (), name, NULL);
+
+  g_free (name);
+  g_checksum_free (checksum);
+
+  return path;
+}
+
+/* creates and builds a program from a cached binary, returns NULL if
+ * there is none or the implementation doesn't accept it anymore
+ */
+static cl_program
+gegl_cl_load_binary (const gchar *path)
+{
+  cl_device_id  device = gegl_cl_get_device_id ();
+  cl_program    program;
+  cl_int        binary_status;
+  cl_int        errcode;
+  gchar        *binary;
+  gsize         length;
+  size_t        size;
+
+  if (!path || !g_file_get_contents (path, &binary, &length, NULL))
+    return NULL;
+
+  size    = length;
+  program = gegl_clCreateProgramWithBinary (gegl_cl_get_context (), 1, &device,
+                                            &size, (const unsigned char **) &binary,
+                                            &binary_status, &errcode);
+
+  if (errcode == CL_SUCCESS && binary_status == CL_SUCCESS)
+    errcode = gegl_clBuildProgram (program, 0, NULL, NULL, NULL, NULL);
+  else if (errcode == CL_SUCCESS)
+    errcode = binary_status;
+
+  g_free (binary);
+
+  if (errcode != CL_SUCCESS)
+    {
+      if (program)
+        gegl_clReleaseProgram (program);
+      return NULL;
+    }
+
+  return program;
+}
+
+/* writes the binary of a built program to the cache, replacing the file
+ * atomically so that other processes never see a partial binary
+ */
+static void
+gegl_cl_save_binary (cl_program   program,
+                     const gchar *path)
+{
+  unsigned char *binary;
+  size_t         size;
+
+  if (!path ||
+      gegl_clGetProgramInfo (program, CL_PROGRAM_BINARY_SIZES,
+                             sizeof (size), &size, NULL) != CL_SUCCESS ||
+      size == 0)
+    return;
+
+  binary = g_malloc (size);
+
+  if (gegl_clGetProgramInfo (program, CL_PROGRAM_BINARIES,
+                             sizeof (binary), &binary, NULL) == CL_SUCCESS)
+    g_file_set_contents (path, (const gchar *) binary, size, NULL);
+
+  g_free (binary);
+}
+
 /* XXX: same program_source with different kernel_name[], context or device
  *      will retrieve the same key
  */
 gegl_cl_run_data *
 gegl_cl_compile_and_build (const char *program_source, const char *kernel_name[])
 {
+  static GStaticMutex mutex = G_STATIC_MUTEX_INIT;
   gint errcode;
   gegl_cl_run_data *cl_data = NULL;
 
+  /* operations build their kernels on first use, which can happen from
+   * several threads at once */
+  g_static_mutex_lock (&mutex);
+
   if ((cl_data = (gegl_cl_run_data *)g_hash_table_lookup(cl_program_hash, program_source)) == NULL)
     {
       size_t length = strlen(program_source);
+      gchar *path   = gegl_cl_binary_path (program_source);
 
       gint i;
       guint kernel_n = 0;
@@ -434,24 +603,36 @@ gegl_cl_compile_and_build (const char *program_source, const char *kernel_name[]
 
       cl_data = (gegl_cl_run_data *) g_malloc(sizeof(gegl_cl_run_data)+sizeof(cl_kernel)*kernel_n);
 
-      CL_SAFE_CALL( cl_data->program = gegl_clCreateProgramWithSource(gegl_cl_get_context(), 1, &program_source,
-                                                                      &length, &errcode) );
+      /* compiling can take long, a binary cached by an earlier process
+       * is used when there is one */
+      cl_data->program = gegl_cl_load_binary (path);
 
-      errcode = gegl_clBuildProgram(cl_data->program, 0, NULL, NULL, NULL, NULL);
-      if (errcode != CL_SUCCESS)
-        {
-          char buffer[2000];
-          CL_SAFE_CALL( errcode = gegl_clGetProgramBuildInfo(cl_data->program,
-                                                             gegl_cl_get_device_id(),
-                                                             CL_PROGRAM_BUILD_LOG,
-                                                             sizeof(buffer), buffer, NULL) );
-          g_warning("OpenCL Build Error:%s\n%s", gegl_cl_errstring(errcode), buffer);
-          return NULL;
-        }
-      else
+      if (!cl_data->program)
         {
-          g_printf("[OpenCL] Compiling successful\n");
+          CL_SAFE_CALL( cl_data->program = gegl_clCreateProgramWithSource(gegl_cl_get_context(), 1, &program_source,
+                                                                          &length, &errcode) );
+
+          errcode = gegl_clBuildProgram(cl_data->program, 0, NULL, NULL, NULL, NULL);
+          if (errcode != CL_SUCCESS)
+            {
+              char buffer[2000];
+              CL_SAFE_CALL( errcode = gegl_clGetProgramBuildInfo(cl_data->program,
+                                                                 gegl_cl_get_device_id(),
+                                                                 CL_PROGRAM_BUILD_LOG,
+                                                                 sizeof(buffer), buffer, NULL) );
+              g_warning("OpenCL Build Error:%s\n%s", gegl_cl_errstring(errcode), buffer);
+              g_free (path);
+              g_static_mutex_unlock (&mutex);
+              return NULL;
+            }
+          else
+            {
+              g_printf("[OpenCL] Compiling successful\n");
+            }
+
+          gegl_cl_save_binary (cl_data->program, path);
         }
+      g_free (path);
 
       for (i=0; i<kernel_n; i++)
         CL_SAFE_CALL( cl_data->kernel[i] =
@@ -460,5 +641,7 @@ gegl_cl_compile_and_build (const char *program_source, const char *kernel_name[]
       g_hash_table_insert(cl_program_hash, g_strdup (program_source), (void*)cl_data);
     }
 
+  g_static_mutex_unlock (&mutex);
+
   return cl_data;
-}
\ No newline at end of file
+}
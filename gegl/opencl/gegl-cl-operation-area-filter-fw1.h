@@ -26,15 +26,13 @@
 
     cl_int errcode;
 
-    src_mem = gegl_clCreateBuffer(gegl_cl_get_context(),
-        CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
+    src_mem = gegl_cl_pool_alloc(CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
         MAX(MAX(size_src,size_dst),MAX(size_in,size_out)),
-        NULL, &errcode);
+        &errcode);
     if (CL_SUCCESS != errcode) CL_ERROR;
-    dst_mem = gegl_clCreateBuffer(gegl_cl_get_context(),
-        CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
+    dst_mem = gegl_cl_pool_alloc(CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
         MAX(MAX(size_src,size_dst),MAX(size_in,size_out)),
-        NULL, &errcode);
+        &errcode);
     if (CL_SUCCESS != errcode) CL_ERROR;
 
     if (CL_COLOR_NOT_SUPPORTED == need_babl_in ||
@@ -42,5 +42,5 @@
         if (CL_SUCCESS != errcode) CL_ERROR;
     }
 
-    gegl_clReleaseMemObject(src_mem);
-    gegl_clReleaseMemObject(dst_mem);
\ No newline at end of file
+    gegl_cl_pool_release(src_mem);
+    gegl_cl_pool_release(dst_mem);
\ No newline at end of file
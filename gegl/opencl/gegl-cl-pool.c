@@ -0,0 +1,194 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl-cl-init.h"
+#include "gegl-cl-pool.h"
+#include "gegl-config.h"
+
+/* the smallest bucket, smaller buffers aren't worth keeping apart */
+#define MIN_BUCKET_SIZE 4096
+
+#define UNPOOLED_FLAGS (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR)
+
+typedef struct
+{
+  size_t        size;
+  cl_mem_flags  flags;
+  GSList       *mems;  /* idle buffers, most recently released first */
+} GeglClPoolBucket;
+
+static GStaticMutex  pool_mutex   = G_STATIC_MUTEX_INIT;
+static GSList       *pool_buckets = NULL;
+static gsize         pool_total   = 0;
+static gint          pool_hits    = 0;
+static gint          pool_misses  = 0;
+
+static size_t
+gegl_cl_pool_bucket_size (size_t size)
+{
+  size_t bucket_size = MIN_BUCKET_SIZE;
+
+  while (bucket_size < size)
+    bucket_size <<= 1;
+
+  return bucket_size;
+}
+
+static GeglClPoolBucket *
+gegl_cl_pool_bucket (size_t       size,
+                     cl_mem_flags flags)
+{
+  GSList *iter;
+
+  for (iter = pool_buckets; iter; iter = g_slist_next (iter))
+    {
+      GeglClPoolBucket *bucket = iter->data;
+
+      if (bucket->size == size && bucket->flags == flags)
+        return bucket;
+    }
+
+  return NULL;
+}
+
+cl_mem
+gegl_cl_pool_alloc (cl_mem_flags  flags,
+                    size_t        size,
+                    cl_int       *errcode)
+{
+  GeglClPoolBucket *bucket;
+  cl_mem            mem = NULL;
+
+  if (flags & UNPOOLED_FLAGS)
+    return gegl_clCreateBuffer (gegl_cl_get_context (), flags, size,
+                                NULL, errcode);
+
+  size = gegl_cl_pool_bucket_size (size);
+
+  g_static_mutex_lock (&pool_mutex);
+  bucket = gegl_cl_pool_bucket (size, flags);
+  if (bucket && bucket->mems)
+    {
+      mem          = bucket->mems->data;
+      bucket->mems = g_slist_delete_link (bucket->mems, bucket->mems);
+      pool_total  -= size;
+      pool_hits++;
+    }
+  else
+    {
+      pool_misses++;
+    }
+  g_static_mutex_unlock (&pool_mutex);
+
+  if (mem)
+    {
+      if (errcode)
+        *errcode = CL_SUCCESS;
+      return mem;
+    }
+
+  return gegl_clCreateBuffer (gegl_cl_get_context (), flags, size,
+                              NULL, errcode);
+}
+
+void
+gegl_cl_pool_release (cl_mem mem)
+{
+  GeglClPoolBucket *bucket;
+  cl_uint           refs  = 0;
+  size_t            size  = 0;
+  cl_mem_flags      flags = 0;
+
+  if (gegl_clGetMemObjectInfo (mem, CL_MEM_REFERENCE_COUNT, sizeof (refs), &refs, NULL) != CL_SUCCESS ||
+      gegl_clGetMemObjectInfo (mem, CL_MEM_SIZE, sizeof (size), &size, NULL) != CL_SUCCESS ||
+      gegl_clGetMemObjectInfo (mem, CL_MEM_FLAGS, sizeof (flags), &flags, NULL) != CL_SUCCESS ||
+      refs != 1 ||
+      (flags & UNPOOLED_FLAGS) ||
+      size != gegl_cl_pool_bucket_size (size))
+    {
+      gegl_clReleaseMemObject (mem);
+      return;
+    }
+
+  g_static_mutex_lock (&pool_mutex);
+  if (pool_total + size > (gsize) gegl_config ()->cl_pool_size)
+    {
+      g_static_mutex_unlock (&pool_mutex);
+      gegl_clReleaseMemObject (mem);
+      return;
+    }
+
+  bucket = gegl_cl_pool_bucket (size, flags);
+  if (!bucket)
+    {
+      bucket        = g_slice_new0 (GeglClPoolBucket);
+      bucket->size  = size;
+      bucket->flags = flags;
+      pool_buckets  = g_slist_prepend (pool_buckets, bucket);
+    }
+  bucket->mems = g_slist_prepend (bucket->mems, mem);
+  pool_total  += size;
+  g_static_mutex_unlock (&pool_mutex);
+}
+
+void
+gegl_cl_pool_cleanup (void)
+{
+  g_static_mutex_lock (&pool_mutex);
+  while (pool_buckets)
+    {
+      GeglClPoolBucket *bucket = pool_buckets->data;
+
+      while (bucket->mems)
+        {
+          gegl_clReleaseMemObject (bucket->mems->data);
+          bucket->mems = g_slist_delete_link (bucket->mems, bucket->mems);
+        }
+      g_slice_free (GeglClPoolBucket, bucket);
+      pool_buckets = g_slist_delete_link (pool_buckets, pool_buckets);
+    }
+  pool_total = 0;
+  g_static_mutex_unlock (&pool_mutex);
+}
+
+void
+gegl_cl_pool_get_stats (gint  *hits,
+                        gint  *misses,
+                        gsize *total)
+{
+  g_static_mutex_lock (&pool_mutex);
+  if (hits)
+    *hits = pool_hits;
+  if (misses)
+    *misses = pool_misses;
+  if (total)
+    *total = pool_total;
+  g_static_mutex_unlock (&pool_mutex);
+}
+
+void
+gegl_cl_pool_stats (void)
+{
+  g_static_mutex_lock (&pool_mutex);
+  g_warning ("OpenCL buffer pool: %.1f%% hit:%i miss:%i idle:%" G_GSIZE_FORMAT " bytes",
+             pool_hits * 100.0 / MAX (pool_hits + pool_misses, 1),
+             pool_hits, pool_misses, pool_total);
+  g_static_mutex_unlock (&pool_mutex);
+}
@@ -0,0 +1,57 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_CL_POOL_H__
+#define __GEGL_CL_POOL_H__
+
+#include "gegl-cl-init.h"
+
+G_BEGIN_DECLS
+
+/* Returns a buffer of at least size bytes, taken from the buffers given
+ * back with gegl_cl_pool_release when there is one of the same size
+ * bucket and flags. Buffers are created with their size rounded up to
+ * the next power of two, flags using host memory given by the caller
+ * aren't pooled and give a buffer of exactly size bytes.
+ *
+ * Reusing a buffer while kernels enqueued with it earlier still have to
+ * run is safe, as GEGL uses a single in-order command queue.
+ */
+cl_mem gegl_cl_pool_alloc   (cl_mem_flags  flags,
+                             size_t        size,
+                             cl_int       *errcode);
+
+/* Drops a reference to mem like clReleaseMemObject, keeping the buffer
+ * for gegl_cl_pool_alloc when it was the last one, as long as the idle
+ * buffers stay below GeglConfig:cl-pool-size bytes.
+ */
+void   gegl_cl_pool_release (cl_mem        mem);
+
+/* releases the idle buffers */
+void   gegl_cl_pool_cleanup (void);
+
+/* the allocations served from the pool and the ones that created a new
+ * buffer, and the bytes of the idle buffers
+ */
+void   gegl_cl_pool_get_stats (gint   *hits,
+                               gint   *misses,
+                               gsize  *total);
+
+void   gegl_cl_pool_stats     (void);
+
+G_END_DECLS
+
+#endif /* __GEGL_CL_POOL_H__ */
@@ -3,5 +3,6 @@
 
 #include "gegl-cl-init.h"
 #include "gegl-cl-color.h"
+#include "gegl-cl-pool.h"
 
 #endif
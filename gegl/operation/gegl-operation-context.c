@@ -234,6 +234,7 @@ void gegl_operation_context_destroy (GeglOperationContext *self)
       self->property = g_slist_remove (self->property, property);
       property_destroy (property);
     }
+  g_slist_free (self->fused);
   g_slice_free (GeglOperationContext, self);
 }
 
@@ -366,8 +367,7 @@ gegl_operation_context_get_target (GeglOperationContext *context,
     {
       output = g_object_ref (emptybuf());
     }
-  else if (node->dont_cache == FALSE &&
-      ! GEGL_OPERATION_CLASS (G_OBJECT_GET_CLASS (operation))->no_cache)
+  else if (gegl_node_use_cache (node, result))
     {
       GeglBuffer    *cache;
       cache = GEGL_BUFFER (gegl_node_get_cache (node));
@@ -55,6 +55,11 @@ struct _GeglOperationContext
                                   incorporated into the refcount of
                                   GeglOperationContext?
                                 */
+
+  GSList        *fused;        /* point filters the eval visitor left for the
+                                  operation to apply to its input before
+                                  itself, in order, see
+                                  gegl_operation_point_filter_can_fuse */
 };
 
 GeglBuffer     *gegl_operation_context_get_target      (GeglOperationContext *self,
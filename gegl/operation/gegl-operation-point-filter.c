@@ -31,6 +31,7 @@
 
 #include "gegl-buffer-private.h"
 #include "gegl-tile-storage.h"
+#include "gegl-config.h"
 
 #include "opencl/gegl-cl.h"
 
@@ -65,8 +66,8 @@ gegl_operation_point_filter_class_init (GeglOperationPointFilterClass *klass)
 
   klass->process = NULL;
   klass->cl_process = NULL;
-//  klass->cl_kernel_source     = NULL;
-//  klass->cl_kernel_parameters = NULL;
+  klass->cl_fuse_source     = NULL;
+  klass->cl_fuse_parameters = NULL;
 }
 
 static void
@@ -74,6 +75,367 @@ gegl_operation_point_filter_init (GeglOperationPointFilter *self)
 {
 }
 
+/* Generates and builds the kernel applying the point filters in fused
+ * followed by operation, storing their parameters in a new buffer in
+ * parameters. The source is the signature of the chain, the program of
+ * every chain is only compiled once by gegl_cl_compile_and_build.
+ */
+static gegl_cl_run_data *
+gegl_operation_point_filter_cl_fuse (GSList        *fused,
+                                     GeglOperation *operation,
+                                     cl_mem        *parameters)
+{
+  const char       *kernel_name[] = {"kernel_fused", NULL};
+  GSList           *operations    = g_slist_append (g_slist_copy (fused), operation);
+  GSList           *iter;
+  GString          *source;
+  gfloat           *values;
+  gint              n_values      = 0;
+  gegl_cl_run_data *cl_data;
+  cl_int            errcode       = CL_SUCCESS;
+
+  values = g_new (gfloat, g_slist_length (operations) * GEGL_CL_FUSE_MAX_PARAMETERS);
+  source = g_string_new ("__kernel void kernel_fused (__global const float4 *in,        \n"
+                         "                            __global       float4 *out,       \n"
+                         "                            __constant     float  *params)    \n"
+                         "{                                                             \n"
+                         "  int    gid = get_global_id(0);                              \n"
+                         "  float4 v   = in[gid];                                       \n");
+
+  for (iter = operations; iter; iter = g_slist_next (iter))
+    {
+      GeglOperationPointFilterClass *klass = GEGL_OPERATION_POINT_FILTER_GET_CLASS (iter->data);
+
+      g_string_append_printf (source,
+                              "  {                                                           \n"
+                              "    __constant float *p = params + %i;                       \n"
+                              "    %s\n"
+                              "  }                                                           \n",
+                              n_values, klass->cl_fuse_source);
+
+      if (klass->cl_fuse_parameters)
+        n_values += klass->cl_fuse_parameters (iter->data, values + n_values);
+    }
+
+  g_string_append (source, "  out[gid] = v;                                               \n"
+                           "}                                                             \n");
+
+  cl_data = gegl_cl_compile_and_build (source->str, kernel_name);
+
+  if (cl_data)
+    {
+      *parameters = gegl_clCreateBuffer (gegl_cl_get_context (),
+                                         CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                         MAX (n_values, 1) * sizeof (cl_float),
+                                         values, &errcode);
+      if (errcode != CL_SUCCESS)
+        cl_data = NULL;
+    }
+
+  g_string_free (source, TRUE);
+  g_slist_free (operations);
+  g_free (values);
+
+  return cl_data;
+}
+
+static cl_int
+gegl_operation_point_filter_cl_run_fused (gegl_cl_run_data *cl_data,
+                                          cl_mem            parameters,
+                                          cl_mem            in_data,
+                                          cl_mem            out_data,
+                                          const size_t      global_worksize[1])
+{
+  cl_int errcode;
+
+  errcode = gegl_clSetKernelArg (cl_data->kernel[0], 0, sizeof (cl_mem), (void*)&in_data);
+  if (errcode == CL_SUCCESS)
+    errcode = gegl_clSetKernelArg (cl_data->kernel[0], 1, sizeof (cl_mem), (void*)&out_data);
+  if (errcode == CL_SUCCESS)
+    errcode = gegl_clSetKernelArg (cl_data->kernel[0], 2, sizeof (cl_mem), (void*)&parameters);
+  if (errcode == CL_SUCCESS)
+    errcode = gegl_clEnqueueNDRangeKernel (gegl_cl_get_command_queue (),
+                                           cl_data->kernel[0], 1,
+                                           NULL, global_worksize, NULL,
+                                           0, NULL, NULL);
+
+  return errcode;
+}
+
+/* runs the kernel of operation, or the fused kernel cl_data when given.
+ * The kernels are shared by every thread running the operation, setting
+ * their arguments and enqueueing them happens under one lock.
+ */
+static cl_int
+gegl_operation_point_filter_cl_run (GeglOperation       *operation,
+                                    gegl_cl_run_data    *cl_data,
+                                    cl_mem               parameters,
+                                    cl_mem               in_data,
+                                    cl_mem               out_data,
+                                    const size_t         global_worksize[1],
+                                    const GeglRectangle *roi)
+{
+  static GStaticMutex mutex = G_STATIC_MUTEX_INIT;
+  cl_int              errcode;
+
+  g_static_mutex_lock (&mutex);
+
+  if (cl_data)
+    errcode = gegl_operation_point_filter_cl_run_fused (cl_data, parameters,
+                                                        in_data, out_data,
+                                                        global_worksize);
+  else
+    errcode = GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation)->cl_process (
+                operation, in_data, out_data, global_worksize, roi);
+
+  g_static_mutex_unlock (&mutex);
+
+  return errcode;
+}
+
+/* Processes whole tiles on the OpenCL device, leaving the results there
+ * for the next operation. Only the tiles the cpu later reads are copied
+ * back, so a chain of point filters copies the data to the device and
+ * back once. The point filters in fused are applied first, by the same
+ * kernel. Returns FALSE if the buffers and result don't line up with
+ * the tile grid, or need color conversions.
+ */
+static gboolean
+gegl_operation_point_filter_cl_process_tiles (GeglOperation       *operation,
+                                              GSList              *fused,
+                                              GeglBuffer          *input,
+                                              GeglBuffer          *output,
+                                              const GeglRectangle *result)
+{
+  const Babl       *in_format   = gegl_operation_get_format (operation, "input");
+  const Babl       *out_format  = gegl_operation_get_format (operation, "output");
+  gint              tile_width  = input->tile_storage->tile_width;
+  gint              tile_height = input->tile_storage->tile_height;
+  gegl_cl_run_data *cl_data     = NULL;
+  cl_mem            parameters  = NULL;
+  gboolean          success     = TRUE;
+  gint              x, y;
+
+  if (input->format  != in_format  ||
+      output->format != out_format ||
+      output->tile_storage->tile_width  != tile_width  ||
+      output->tile_storage->tile_height != tile_height ||
+      input->shift_x != output->shift_x ||
+      input->shift_y != output->shift_y ||
+      gegl_tile_offset (result->x + input->shift_x, tile_width)  != 0 ||
+      gegl_tile_offset (result->y + input->shift_y, tile_height) != 0 ||
+      result->width  % tile_width  != 0 ||
+      result->height % tile_height != 0 ||
+      !gegl_rectangle_contains (&input->abyss, result))
+    return FALSE;
+
+  if (fused)
+    {
+      cl_data = gegl_operation_point_filter_cl_fuse (fused, operation, &parameters);
+      if (!cl_data)
+        return FALSE;
+    }
+
+  for (y = result->y; success && y < result->y + result->height; y += tile_height)
+    for (x = result->x; success && x < result->x + result->width; x += tile_width)
+      {
+        gint           tile_x = gegl_tile_indice (x + input->shift_x, tile_width);
+        gint           tile_y = gegl_tile_indice (y + input->shift_y, tile_height);
+        GeglRectangle  roi    = {x, y, tile_width, tile_height};
+        const size_t   global_worksize[1] = {tile_width * tile_height};
+        GeglTile      *in_tile;
+        GeglTile      *out_tile;
+        cl_mem         in_data;
+        cl_mem         out_data = NULL;
+        cl_int         errcode  = CL_SUCCESS;
+
+        in_tile  = gegl_buffer_cl_get_tile (input, tile_x, tile_y, 0);
+        out_tile = gegl_buffer_cl_get_tile (output, tile_x, tile_y, 0);
+        in_data  = in_tile ? gegl_tile_cl_get_data (in_tile) : NULL;
+
+        if (in_data && out_tile)
+          out_data = gegl_cl_pool_alloc (CL_MEM_READ_WRITE, out_tile->size, &errcode);
+        if (out_data && errcode == CL_SUCCESS)
+          errcode = gegl_operation_point_filter_cl_run (operation, cl_data, parameters,
+                                                        in_data, out_data,
+                                                        global_worksize, &roi);
+
+        /* the kernel keeps the input alive until it has run */
+        if (in_data)
+          gegl_clReleaseMemObject (in_data);
+
+        if (out_data && errcode == CL_SUCCESS)
+          gegl_tile_cl_set_data (out_tile, out_data);
+        else if (out_data)
+          gegl_cl_pool_release (out_data);
+
+        if (in_tile)
+          gegl_tile_unref (in_tile);
+        if (out_tile)
+          gegl_tile_unref (out_tile);
+
+        /* the tiles done so far are written again by the caller */
+        if (!out_data || errcode != CL_SUCCESS)
+          success = FALSE;
+      }
+
+  if (parameters)
+    gegl_clReleaseMemObject (parameters);
+
+  return success;
+}
+
+/* number of chunks on the device at once */
+#define CL_PIPELINE_DEPTH 2
+
+typedef struct
+{
+  GeglRectangle  roi;
+  guchar        *host;     /* the transfers of the chunk read and write here */
+  cl_mem         in_data;
+  cl_mem         out_data;
+  cl_event       done;     /* reading back out_data */
+} GeglClChunk;
+
+/* waits for the chunk to be read back and stores it in output, the
+ * chunk holds pixels of format */
+static cl_int
+gegl_operation_point_filter_cl_finish_chunk (GeglBuffer  *output,
+                                             const Babl  *format,
+                                             GeglClChunk *chunk)
+{
+  cl_int errcode;
+
+  if (!chunk->done)
+    return CL_SUCCESS;
+
+  errcode = gegl_clWaitForEvents (1, &chunk->done);
+  gegl_clReleaseEvent (chunk->done);
+  chunk->done = NULL;
+
+  if (errcode == CL_SUCCESS)
+    gegl_buffer_set (output, &chunk->roi, format, chunk->host,
+                     GEGL_AUTO_ROWSTRIDE);
+  return errcode;
+}
+
+/* Processes result in bands of GeglConfig:chunk-size pixels, keeping
+ * CL_PIPELINE_DEPTH bands in flight with non-blocking transfers, so that
+ * un-tiling the next band and tiling the previous one on the cpu overlap
+ * with the device working on the current one. The single in-order
+ * command queue orders the upload, kernel and download of every band,
+ * the read back events tell when a band's memory can be reused. The
+ * kernels work on pixels of the input format of the operation, like in
+ * gegl_operation_point_filter_cl_process_full, the color conversions
+ * from and to the formats of the buffers are done by babl while
+ * un-tiling and tiling.
+ */
+static gboolean
+gegl_operation_point_filter_cl_process_pipelined (GeglOperation       *operation,
+                                                  GSList              *fused,
+                                                  GeglBuffer          *input,
+                                                  GeglBuffer          *output,
+                                                  const GeglRectangle *result)
+{
+  const Babl       *in_format   = gegl_operation_get_format (operation, "input");
+  const size_t      bpp_in      = babl_format_get_bytes_per_pixel (in_format);
+  gint              band_width  = MIN ((gint) cl_status.max_width, result->width);
+  gint              band_height = CLAMP (gegl_config ()->chunk_size / band_width,
+                                         1, (gint) cl_status.max_height);
+  size_t            band_size   = (size_t) band_width * band_height * bpp_in;
+  GeglClChunk       chunks[CL_PIPELINE_DEPTH];
+  gegl_cl_run_data *cl_data     = NULL;
+  cl_mem            parameters  = NULL;
+  cl_command_queue  queue       = gegl_cl_get_command_queue ();
+  cl_int            errcode     = CL_SUCCESS;
+  gint              n           = 0;
+  gint              x, y, i;
+
+  if (fused)
+    {
+      cl_data = gegl_operation_point_filter_cl_fuse (fused, operation, &parameters);
+      if (!cl_data)
+        return FALSE;
+    }
+
+  memset (chunks, 0, sizeof (chunks));
+
+  for (y = 0; errcode == CL_SUCCESS && y < result->height; y += band_height)
+    for (x = 0; errcode == CL_SUCCESS && x < result->width; x += band_width)
+      {
+        GeglClChunk   *chunk = &chunks[n++ % CL_PIPELINE_DEPTH];
+        GeglRectangle  roi   = {result->x + x, result->y + y,
+                                MIN (band_width,  result->width  - x),
+                                MIN (band_height, result->height - y)};
+        const size_t   global_worksize[1] = {roi.width * roi.height};
+
+        /* the chunk's memory is free again once its last band is back */
+        errcode = gegl_operation_point_filter_cl_finish_chunk (output, in_format, chunk);
+        if (errcode != CL_SUCCESS)
+          break;
+
+        if (!chunk->host)
+          chunk->host = gegl_malloc (band_size);
+        if (!chunk->in_data)
+          chunk->in_data = gegl_cl_pool_alloc (CL_MEM_READ_WRITE, band_size, &errcode);
+        if (!chunk->out_data && errcode == CL_SUCCESS)
+          chunk->out_data = gegl_cl_pool_alloc (CL_MEM_READ_WRITE, band_size, &errcode);
+        if (errcode != CL_SUCCESS)
+          break;
+
+        chunk->roi = roi;
+        gegl_buffer_get (input, 1.0, &roi, in_format, chunk->host,
+                         GEGL_AUTO_ROWSTRIDE);
+
+        errcode = gegl_clEnqueueWriteBuffer (queue, chunk->in_data, CL_FALSE, 0,
+                                             global_worksize[0] * bpp_in,
+                                             chunk->host, 0, NULL, NULL);
+        if (errcode == CL_SUCCESS)
+          errcode = gegl_operation_point_filter_cl_run (operation, cl_data, parameters,
+                                                        chunk->in_data, chunk->out_data,
+                                                        global_worksize, &roi);
+        if (errcode == CL_SUCCESS)
+          errcode = gegl_clEnqueueReadBuffer (queue, chunk->out_data, CL_FALSE, 0,
+                                              global_worksize[0] * bpp_in,
+                                              chunk->host, 0, NULL, &chunk->done);
+        if (errcode == CL_SUCCESS)
+          errcode = gegl_clFlush (queue);
+      }
+
+  /* the bands still in flight, oldest first */
+  for (i = 0; i < CL_PIPELINE_DEPTH; i++)
+    {
+      GeglClChunk *chunk = &chunks[(n + i) % CL_PIPELINE_DEPTH];
+
+      if (errcode == CL_SUCCESS)
+        errcode = gegl_operation_point_filter_cl_finish_chunk (output, in_format, chunk);
+    }
+
+  /* after an error transfers can still be using the host memory */
+  if (errcode != CL_SUCCESS)
+    {
+      g_warning ("[OpenCL] Error: %s", gegl_cl_errstring (errcode));
+      gegl_clFinish (queue);
+    }
+
+  for (i = 0; i < CL_PIPELINE_DEPTH; i++)
+    {
+      if (chunks[i].done)
+        gegl_clReleaseEvent (chunks[i].done);
+      if (chunks[i].in_data)
+        gegl_cl_pool_release (chunks[i].in_data);
+      if (chunks[i].out_data)
+        gegl_cl_pool_release (chunks[i].out_data);
+      if (chunks[i].host)
+        gegl_free (chunks[i].host);
+    }
+
+  if (parameters)
+    gegl_clReleaseMemObject (parameters);
+
+  return errcode == CL_SUCCESS;
+}
+
 struct buf_tex
 {
   GeglBuffer *buf;
@@ -143,9 +505,10 @@ gegl_operation_point_filter_cl_process_full (GeglOperation       *operation,
 
   input_tex.region  = (GeglRectangle *) gegl_malloc(interval * sizeof(GeglRectangle));
   output_tex.region = (GeglRectangle *) gegl_malloc(interval * sizeof(GeglRectangle));
-  input_tex.tex     = (cl_mem *)        gegl_malloc(interval * sizeof(cl_mem));
-  output_tex.tex    = (cl_mem *)        gegl_malloc(interval * sizeof(cl_mem));
-  aux=                (cl_mem *)        gegl_malloc(interval * sizeof(cl_mem));
+  /* zeroed, only the buffers that were allocated are released */
+  input_tex.tex     = g_new0 (cl_mem, interval);
+  output_tex.tex    = g_new0 (cl_mem, interval);
+  aux               = g_new0 (cl_mem, interval);
 
   if (input_tex.region == NULL || output_tex.region == NULL || input_tex.tex == NULL || output_tex.tex == NULL)
     CL_ERROR;
@@ -193,10 +556,8 @@ gegl_operation_point_filter_cl_process_full (GeglOperation       *operation,
 		if(need_babl_in==CL_COLOR_CONVERT || need_in_out_convert==CL_COLOR_CONVERT || need_babl_out==CL_COLOR_CONVERT)
 			alloc_real_size = MAX(alloc_real_size,region[0]*region[1]*bpp_rgbaf);
 
-		input_tex.tex[j] = gegl_clCreateBuffer(gegl_cl_get_context(),
-			CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
-			alloc_real_size,
-			NULL, &errcode);
+		input_tex.tex[j] = gegl_cl_pool_alloc(CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
+			alloc_real_size, &errcode);
 		if (CL_SUCCESS != errcode) CL_ERROR;
 
 		if(input_format!=babl_format("RGBA float") && in_format!=babl_format("RGBA float"))
@@ -204,16 +565,13 @@ gegl_operation_point_filter_cl_process_full (GeglOperation       *operation,
 
 		if(need_babl_in==CL_COLOR_CONVERT && transfer_twice == FALSE){
 
-			output_tex.tex[j] = gegl_clCreateBuffer(gegl_cl_get_context(),
-				CL_MEM_READ_WRITE,alloc_real_size,
-				NULL, &errcode);
+			output_tex.tex[j] = gegl_cl_pool_alloc(CL_MEM_READ_WRITE,
+				alloc_real_size, &errcode);
 			if (CL_SUCCESS != errcode) CL_ERROR;
 		}
 		else{
-			output_tex.tex[j] = gegl_clCreateBuffer(gegl_cl_get_context(),
-				CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
-				alloc_real_size,
-				NULL, &errcode);
+			output_tex.tex[j] = gegl_cl_pool_alloc(CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE,
+				alloc_real_size, &errcode);
 			if (CL_SUCCESS != errcode) CL_ERROR;
 		}
 		
@@ -245,9 +603,8 @@ gegl_operation_point_filter_cl_process_full (GeglOperation       *operation,
 
 			aux[j]=input_tex.tex[j];
 
-			input_tex.tex[j]= gegl_clCreateBuffer (gegl_cl_get_context(),
-				CL_MEM_READ_WRITE, alloc_real_size,
-				NULL, &errcode);
+			input_tex.tex[j]= gegl_cl_pool_alloc (CL_MEM_READ_WRITE,
+				alloc_real_size, &errcode);
 			if (errcode != CL_SUCCESS) CL_ERROR;		
 
 			gegl_cl_color_conv(&aux[j],&input_tex.tex[j],0,region[0]*region[1],
@@ -262,7 +619,7 @@ gegl_operation_point_filter_cl_process_full (GeglOperation       *operation,
 			for(j=0;j<interval;j++){
 				const size_t region[2]= {input_tex.region[j].width, input_tex.region[j].height};
 				const size_t global_worksize[1] = {region[0] * region[1]};
-				errcode = point_filter_class->cl_process(operation, input_tex.tex[j], output_tex.tex[j], global_worksize, &input_tex.region[j]);
+				errcode = gegl_operation_point_filter_cl_run (operation, NULL, NULL, input_tex.tex[j], output_tex.tex[j], global_worksize, &input_tex.region[j]);
 				if (errcode != CL_SUCCESS) CL_ERROR;
 			}
 			/* Wait Processing */
@@ -319,20 +676,20 @@ gegl_operation_point_filter_cl_process_full (GeglOperation       *operation,
 			if (errcode != CL_SUCCESS) CL_ERROR;
 			for (j=0; j<interval; j++)
 			{			
-				if(aux[j])                     gegl_clReleaseMemObject (aux[j]);
-				if(input_tex.tex[j])           gegl_clReleaseMemObject (input_tex.tex[j]);
-				if(output_tex.tex[j])          gegl_clReleaseMemObject (output_tex.tex[j]);
-				
+				if(aux[j])                     gegl_cl_pool_release (aux[j]);
+				if(input_tex.tex[j])           gegl_cl_pool_release (input_tex.tex[j]);
+				if(output_tex.tex[j])          gegl_cl_pool_release (output_tex.tex[j]);
+				aux[j] = input_tex.tex[j] = output_tex.tex[j] = NULL;
 			}
 			j=0;
 		}       
         i++;
       }
-  if (input_tex.tex)     gegl_free(input_tex.tex);
-  if (output_tex.tex)    gegl_free(output_tex.tex);
+  g_free (input_tex.tex);
+  g_free (output_tex.tex);
   if (input_tex.region)  gegl_free(input_tex.region);
   if (output_tex.region) gegl_free(output_tex.region);
-  if(aux)                gegl_free(aux);
+  g_free (aux);
   if(in_data)            gegl_free(in_data);
   if(out_data)           gegl_free(out_data);
   return TRUE;
@@ -342,15 +699,15 @@ error:
 
   for (j=0; j < interval; j++)
   {
-	if (aux[j])  gegl_clReleaseMemObject (aux[j]);
-	if (input_tex.tex[j])  gegl_clReleaseMemObject (input_tex.tex[j]);
-	if (output_tex.tex[j]) gegl_clReleaseMemObject (output_tex.tex[j]);
+	if (aux[j])  gegl_cl_pool_release (aux[j]);
+	if (input_tex.tex[j])  gegl_cl_pool_release (input_tex.tex[j]);
+	if (output_tex.tex[j]) gegl_cl_pool_release (output_tex.tex[j]);
   }
-  if (input_tex.tex)     gegl_free(input_tex.tex);
-  if (output_tex.tex)    gegl_free(output_tex.tex);
+  g_free (input_tex.tex);
+  g_free (output_tex.tex);
   if (input_tex.region)  gegl_free(input_tex.region);
   if (output_tex.region) gegl_free(output_tex.region);
-  if(aux)                gegl_free(aux);
+  g_free (aux);
   if(in_data)            gegl_free(in_data);
   if(out_data)           gegl_free(out_data);
   return FALSE;
@@ -361,6 +718,7 @@ error:
 
 static gboolean
 gegl_operation_point_filter_process (GeglOperation       *operation,
+                                     GSList              *fused,
                                      GeglBuffer          *input,
                                      GeglBuffer          *output,
                                      const GeglRectangle *result)
@@ -373,9 +731,16 @@ gegl_operation_point_filter_process (GeglOperation       *operation,
 
   if ((result->width > 0) && (result->height > 0))
     {
-      if (cl_status.is_opencl_available && point_filter_class->cl_process)
+      if (gegl_config ()->use_opencl && cl_status.is_opencl_available &&
+          point_filter_class->cl_process)
         {
-          if (gegl_operation_point_filter_cl_process_full (operation, input, output, result))
+          if (gegl_operation_point_filter_cl_process_tiles (operation, fused, input, output, result))
+            return TRUE;
+          if (gegl_operation_point_filter_cl_process_pipelined (operation, fused, input, output, result))
+            return TRUE;
+          /* last resort, it blocks on every transfer */
+          if (!fused &&
+              gegl_operation_point_filter_cl_process_full (operation, input, output, result))
             return TRUE;
         }
 
@@ -386,12 +751,45 @@ gegl_operation_point_filter_process (GeglOperation       *operation,
          * readwrite indice would be sufficient
          */
           while (gegl_buffer_iterator_next (i))
-            point_filter_class->process (operation, i->data[read], i->data[0], i->length, &i->roi[0]);
+            {
+              gpointer  in_buf = i->data[read];
+              GSList   *iter;
+
+              /* the fused filters work in place on the output */
+              for (iter = fused; iter; iter = g_slist_next (iter))
+                {
+                  GEGL_OPERATION_POINT_FILTER_GET_CLASS (iter->data)->process (
+                    iter->data, in_buf, i->data[0], i->length, &i->roi[0]);
+                  in_buf = i->data[0];
+                }
+
+              point_filter_class->process (operation, in_buf, i->data[0], i->length, &i->roi[0]);
+            }
       }
     }
   return TRUE;
 }
 
+gboolean
+gegl_operation_point_filter_can_fuse (GeglOperation *operation)
+{
+  GeglOperationPointFilterClass *point_filter_class;
+  const Babl                    *format = babl_format ("RGBA float");
+
+  if (!gegl_config ()->use_opencl ||
+      !cl_status.is_opencl_available ||
+      !GEGL_IS_OPERATION_POINT_FILTER (operation) ||
+      GEGL_OPERATION_GET_CLASS (operation)->process != gegl_operation_point_filter_op_process)
+    return FALSE;
+
+  point_filter_class = GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation);
+
+  return point_filter_class->cl_process &&
+         point_filter_class->cl_fuse_source &&
+         gegl_operation_get_format (operation, "input")  == format &&
+         gegl_operation_get_format (operation, "output") == format;
+}
+
 gboolean gegl_can_do_inplace_processing (GeglOperation       *operation,
                                          GeglBuffer          *input,
                                          const GeglRectangle *result);
@@ -421,6 +819,7 @@ static gboolean gegl_operation_point_filter_op_process
 {
   GeglBuffer               *input;
   GeglBuffer               *output;
+  GSList                   *fused;
   gboolean                  success = FALSE;
 
   input = gegl_operation_context_get_source (context, "input");
@@ -435,11 +834,15 @@ static gboolean gegl_operation_point_filter_op_process
       output = gegl_operation_context_get_target (context, "output");
     }
 
-  success = gegl_operation_point_filter_process (operation, input, output, roi);
+  fused          = context->fused;
+  context->fused = NULL;
+
+  success = gegl_operation_point_filter_process (operation, fused, input, output, roi);
   if (output == GEGL_BUFFER (operation->node->cache))
     gegl_cache_computed (operation->node->cache, roi);
 
   if (input != NULL)
     g_object_unref (input);
+  g_slist_free (fused);
   return success;
 }
@@ -67,10 +67,30 @@ struct _GeglOperationPointFilterClass
                                                         in in buffer, see the
                                                         checkerboard op for
                                                         semantics */
+
+  /* OpenCL C statements applying the filter to the float4 "v" in place,
+   * reading their parameters from the float array "p". Consecutive point
+   * filters that all provide these are run as one kernel, without their
+   * intermediate results ever leaving the registers. Filters providing
+   * them have to work in "RGBA float", and their process must work with
+   * in_buf being out_buf.
+   */
+  const gchar *cl_fuse_source;
+  gint     (* cl_fuse_parameters) (GeglOperation *self,
+                                   gfloat        *parameters); /* stores the
+                                                        parameters, at most
+                                                        GEGL_CL_FUSE_MAX_PARAMETERS,
+                                                        returns their number */
 };
 
+#define GEGL_CL_FUSE_MAX_PARAMETERS 16
+
 GType gegl_operation_point_filter_get_type (void) G_GNUC_CONST;
 
+/* for the eval visitor, whether operation can be fused with the point
+ * filters before and after it */
+gboolean gegl_operation_point_filter_can_fuse (GeglOperation *operation);
+
 G_END_DECLS
 
 #endif
@@ -170,3 +170,43 @@ gboolean gegl_operation_sink_needs_full (GeglOperation *operation)
   klass  = GEGL_OPERATION_SINK_CLASS (G_OBJECT_GET_CLASS (operation));
   return klass->needs_full;
 }
+
+gboolean
+gegl_operation_sink_stream_begin (GeglOperation       *operation,
+                                  const GeglRectangle *roi)
+{
+  GeglOperationSinkClass *klass;
+
+  if (!GEGL_IS_OPERATION_SINK (operation))
+    return FALSE;
+
+  klass = GEGL_OPERATION_SINK_GET_CLASS (operation);
+  if (!klass->stream_begin)
+    return FALSE;
+
+  return klass->stream_begin (operation, roi);
+}
+
+gboolean
+gegl_operation_sink_stream_band (GeglOperation       *operation,
+                                 GeglBuffer          *input,
+                                 const GeglRectangle *band)
+{
+  GeglOperationSinkClass *klass;
+
+  klass = GEGL_OPERATION_SINK_GET_CLASS (operation);
+  g_assert (klass->stream_band);
+
+  return klass->stream_band (operation, input, band);
+}
+
+void
+gegl_operation_sink_stream_end (GeglOperation *operation,
+                                gboolean       success)
+{
+  GeglOperationSinkClass *klass;
+
+  klass = GEGL_OPERATION_SINK_GET_CLASS (operation);
+  if (klass->stream_end)
+    klass->stream_end (operation, success);
+}
@@ -54,11 +54,37 @@ struct _GeglOperationSinkClass
   gboolean (* process) (GeglOperation       *self,
                         GeglBuffer          *input,
                         const GeglRectangle *roi);
+
+  /* Sinks needing the full input that write it out from the top down,
+   * like the row oriented file savers, can have it streamed to them in
+   * horizontal bands instead, keeping no more than a band of the input
+   * in memory. stream_begin is called with the rectangle to be written
+   * and returns FALSE if it can't be streamed, then process is used as
+   * usual. stream_band is called with every band in order and
+   * stream_end after the last band with success set, or with success
+   * unset after stream_band failed or when the stream is abandoned, in
+   * which case the output written so far is to be discarded.
+   */
+  gboolean (* stream_begin) (GeglOperation       *self,
+                             const GeglRectangle *roi);
+  gboolean (* stream_band)  (GeglOperation       *self,
+                             GeglBuffer          *input,
+                             const GeglRectangle *band);
+  void     (* stream_end)   (GeglOperation       *self,
+                             gboolean             success);
 };
 
-GType    gegl_operation_sink_get_type   (void) G_GNUC_CONST;
+GType    gegl_operation_sink_get_type     (void) G_GNUC_CONST;
+
+gboolean gegl_operation_sink_needs_full   (GeglOperation       *operation);
 
-gboolean gegl_operation_sink_needs_full (GeglOperation *operation);
+gboolean gegl_operation_sink_stream_begin (GeglOperation       *operation,
+                                           const GeglRectangle *roi);
+gboolean gegl_operation_sink_stream_band  (GeglOperation       *operation,
+                                           GeglBuffer          *input,
+                                           const GeglRectangle *band);
+void     gegl_operation_sink_stream_end   (GeglOperation       *operation,
+                                           gboolean             success);
 
 G_END_DECLS
 
@@ -29,6 +29,7 @@
 #include "gegl-need-visitor.h"
 #include "gegl-have-visitor.h"
 #include "gegl-instrument.h"
+#include "gegl-config.h"
 #include "graph/gegl-node.h"
 #include "gegl-prepare-visitor.h"
 #include "gegl-finish-visitor.h"
@@ -133,6 +134,7 @@ gegl_eval_mgr_apply (GeglEvalMgr *self)
   GeglPad     *pad;
   glong        time       = gegl_ticks ();
   gpointer     context_id = self;
+  gint         threads    = gegl_config ()->threads;
 
   g_assert (GEGL_IS_EVAL_MGR (self));
 
@@ -150,26 +152,31 @@ gegl_eval_mgr_apply (GeglEvalMgr *self)
 
   g_object_ref (root);
 
-  /* do the necessary set-up work (all using depth first traversal) */
-  switch (self->state)
+  /* do the necessary set-up work (all using depth first traversal),
+   * other eval mgrs of the graph might be doing the same meanwhile, they
+   * all write the same formats and bounding boxes to the nodes, anything
+   * depending on the roi is kept in the contexts of this eval mgr.
+   *
+   * Only the nodes that changed since the last evaluation, and the nodes
+   * downstream of them, are prepared and get their bounding box computed
+   * again, the other nodes only get a context.
+   */
+  gegl_visitor_reset (self->prepare_visitor);
+  gegl_visitor_dfs_traverse (self->prepare_visitor, GEGL_VISITABLE (root));
+
+  if (self->state != NEED_CONTEXT_SETUP_TRAVERSAL)
     {
-      case UNINITIALIZED:
-        /* Set up the node's context and "needed rectangle"*/
-        gegl_visitor_reset (self->prepare_visitor);
-        gegl_visitor_dfs_traverse (self->prepare_visitor, GEGL_VISITABLE (root));
-        /* No idea why there is a second call */
-        gegl_visitor_reset (self->prepare_visitor);
-        gegl_visitor_dfs_traverse (self->prepare_visitor, GEGL_VISITABLE (root));
-      case NEED_REDO_PREPARE_AND_HAVE_RECT_TRAVERSAL:
-        /* sets up the node's rect (bounding box) */
-        gegl_visitor_reset (self->have_visitor);
-        gegl_visitor_dfs_traverse (self->have_visitor, GEGL_VISITABLE (root));
-      case NEED_CONTEXT_SETUP_TRAVERSAL:
-
-        gegl_visitor_reset (self->prepare_visitor);
-        gegl_visitor_dfs_traverse (self->prepare_visitor, GEGL_VISITABLE (root));
-        self->state = NEED_CONTEXT_SETUP_TRAVERSAL;
-     }
+      /* preparing graphs can change their children, which get prepared
+       * by a second traversal
+       */
+      gegl_visitor_reset (self->prepare_visitor);
+      gegl_visitor_dfs_traverse (self->prepare_visitor, GEGL_VISITABLE (root));
+    }
+
+  /* sets up the node's rect (bounding box) */
+  gegl_visitor_reset (self->have_visitor);
+  gegl_visitor_dfs_traverse (self->have_visitor, GEGL_VISITABLE (root));
+  self->state = NEED_CONTEXT_SETUP_TRAVERSAL;
 
   /* set up the root node */
   if (self->roi.width == -1 &&
@@ -202,11 +209,14 @@ gegl_eval_mgr_apply (GeglEvalMgr *self)
     }
 #endif
 
-  /* now let's do the real work */
+  /* now let's do the real work, independent branches of the graph are
+   * evaluated concurrently unless we're a unit of a threaded render
+   */
   gegl_visitor_reset (self->eval_visitor);
   if (pad)
     {
-      gegl_visitor_dfs_traverse (self->eval_visitor, GEGL_VISITABLE (pad));
+      gegl_eval_visitor_traverse (GEGL_EVAL_VISITOR (self->eval_visitor),
+                                  pad, threads);
     }
   else
     { /* pull on the input of our sink if no pad of the given pad-name
@@ -216,7 +226,8 @@ gegl_eval_mgr_apply (GeglEvalMgr *self)
          in its processing.
        */
       GeglPad *pad = gegl_node_get_pad (root, "input");
-      gegl_visitor_dfs_traverse (self->eval_visitor, GEGL_VISITABLE (pad));
+      gegl_eval_visitor_traverse (GEGL_EVAL_VISITOR (self->eval_visitor),
+                                  pad, threads);
     }
 
   if (pad)
@@ -29,13 +29,13 @@ typedef enum
 {
   UNINITIALIZED,
 
-  /* means we need to redo an extra prepare and have_rect
-   * traversal
+  /* means the graph changed, and the nodes that changed need an extra
+   * prepare traversal
    */
   NEED_REDO_PREPARE_AND_HAVE_RECT_TRAVERSAL,
 
   /* means we need a prepare traversal to set up the contexts on the
-   * nodes
+   * nodes, only the nodes that changed since are prepared again
    */
   NEED_CONTEXT_SETUP_TRAVERSAL
 } GeglEvalMgrStates;
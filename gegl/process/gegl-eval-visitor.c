@@ -26,13 +26,16 @@
 #include "gegl-types-internal.h"
 #include "gegl-eval-visitor.h"
 #include "graph/gegl-node.h"
+#include "graph/gegl-connection.h"
 #include "operation/gegl-operation.h"
 #include "operation/gegl-operation-context.h"
+#include "operation/gegl-operation-point-filter.h"
 #include "graph/gegl-pad.h"
 #include "graph/gegl-visitable.h"
 #include "gegl-instrument.h"
 #include "operation/gegl-operation-sink.h"
 #include "buffer/gegl-region.h"
+#include "gegl-scheduler.h"
 
 
 static void gegl_eval_visitor_class_init (GeglEvalVisitorClass *klass);
@@ -43,6 +46,27 @@ static void gegl_eval_visitor_visit_pad  (GeglVisitor *self,
 G_DEFINE_TYPE (GeglEvalVisitor, gegl_eval_visitor, GEGL_TYPE_VISITOR)
 
 
+/* a pad waiting to be visited by gegl_eval_visitor_traverse */
+typedef struct _GeglEvalTask GeglEvalTask;
+
+struct _GeglEvalTask
+{
+  GeglPad *pad;
+  gint     n_sources;  /* pads this one depends on not visited yet */
+  GSList  *dependents; /* tasks depending on this one */
+};
+
+typedef struct _GeglEvalRun
+{
+  GeglVisitor *visitor;
+  GMutex      *mutex;
+  GCond       *cond;
+  GSList      *ready;   /* tasks with all their sources visited */
+  gint         n_tasks;
+  gint         n_done;
+} GeglEvalRun;
+
+
 static void
 gegl_eval_visitor_class_init (GeglEvalVisitorClass *klass)
 {
@@ -57,113 +81,356 @@ gegl_eval_visitor_init (GeglEvalVisitor *self)
 }
 
 
-/* this is the visitor that does the real computations for GEGL */
+/* Instead of processing a point filter whose only consumer is another
+ * point filter it can be fused with, passes its input on unchanged and
+ * leaves applying it to the consumer, that runs the whole chain as one
+ * OpenCL kernel. Returns FALSE if the node has to be processed.
+ */
+static gboolean
+eval_fuse_output_pad (GeglVisitor          *self,
+                      GeglPad              *pad,
+                      GeglOperationContext *context)
+{
+  GeglNode             *node = gegl_pad_get_node (pad);
+  GeglConnection       *connection;
+  GeglNode             *sink;
+  GeglOperationContext *sink_context;
+  GeglBuffer           *input;
+
+  if (gegl_pad_get_num_connections (pad) != 1 ||
+      !gegl_operation_point_filter_can_fuse (node->operation))
+    return FALSE;
+
+  connection = gegl_pad_get_connections (pad)->data;
+  sink       = gegl_connection_get_sink_node (connection);
+
+  if (strcmp (gegl_pad_get_name (gegl_connection_get_sink_pad (connection)), "input") ||
+      !gegl_operation_point_filter_can_fuse (sink->operation))
+    return FALSE;
+
+  /* the consumer has to process exactly what this node would have */
+  sink_context = gegl_node_get_context (sink, self->context_id);
+  if (!sink_context || sink_context->cached ||
+      !gegl_rectangle_equal (&sink_context->result_rect, &context->result_rect))
+    return FALSE;
+
+  input = gegl_operation_context_get_source (context, "input");
+  if (!input)
+    return FALSE;
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS, "Fusing \"%s\" into \"%s\"",
+             gegl_node_get_debug_name (node), gegl_node_get_debug_name (sink));
+
+  gegl_operation_context_take_object (context, gegl_pad_get_name (pad),
+                                      G_OBJECT (input));
+  sink_context->fused = g_slist_append (context->fused, node->operation);
+  context->fused      = NULL;
+
+  return TRUE;
+}
+
+/* processes the node of an output pad */
 static void
-gegl_eval_visitor_visit_pad (GeglVisitor *self,
-                             GeglPad     *pad)
+eval_output_pad (GeglVisitor *self,
+                 GeglPad     *pad)
 {
-  GeglNode        *node       = gegl_pad_get_node (pad);
-  gpointer         context_id = self->context_id;
+  GeglNode             *node       = gegl_pad_get_node (pad);
+  gpointer              context_id = self->context_id;
   GeglOperationContext *context    = gegl_node_get_context (node, context_id);
-  GeglOperation   *operation  = node->operation;
-
-  GEGL_VISITOR_CLASS (gegl_eval_visitor_parent_class)->visit_pad (self, pad);
+  GeglOperation        *operation  = node->operation;
 
-  if (gegl_pad_is_output (pad))
+  if (context->cached)
     {
-      /* processing only really happens for output pads */
-      if (context->cached)
-        {
-          GEGL_NOTE (GEGL_DEBUG_PROCESS, "Using cache for pad '%s' on \"%s\"", gegl_pad_get_name (pad), gegl_node_get_debug_name (node));
-          gegl_operation_context_set_object (context,
-                                             gegl_pad_get_name (pad),
-                                             G_OBJECT (node->cache));
-        }
-      else
-        {
-          glong time      = gegl_ticks ();
+      GEGL_NOTE (GEGL_DEBUG_PROCESS, "Using cache for pad '%s' on \"%s\"", gegl_pad_get_name (pad), gegl_node_get_debug_name (node));
+      gegl_operation_context_set_object (context,
+                                         gegl_pad_get_name (pad),
+                                         G_OBJECT (node->cache));
+    }
+  else if (!eval_fuse_output_pad (self, pad, context))
+    {
+      glong time      = gegl_ticks ();
 
-          /* Make the operation do it's actual processing */
-          GEGL_NOTE (GEGL_DEBUG_PROCESS, "For \"%s\" processing pad '%s' result_rect = %d, %d %d×%d",
-                     gegl_pad_get_name (pad), gegl_node_get_debug_name (node),
-                     context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
-          gegl_operation_process (operation, context, gegl_pad_get_name (pad),
-                                  &context->result_rect);
-          time      = gegl_ticks () - time;
+      /* Make the operation do it's actual processing */
+      GEGL_NOTE (GEGL_DEBUG_PROCESS, "For \"%s\" processing pad '%s' result_rect = %d, %d %d×%d",
+                 gegl_pad_get_name (pad), gegl_node_get_debug_name (node),
+                 context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
+      gegl_operation_process (operation, context, gegl_pad_get_name (pad),
+                              &context->result_rect);
+      time      = gegl_ticks () - time;
 
-          gegl_instrument ("process", gegl_node_get_operation (node), time);
+      gegl_instrument ("process", gegl_node_get_operation (node), time);
+      gegl_node_add_process_time (node, &context->result_rect, time);
 
-          if (gegl_pad_get_num_connections (pad) > 1)
+      if (gegl_pad_get_num_connections (pad) > 1)
+        {
+          /* Mark buffers that have been consumed by different parts of the
+           * graph so that in-place processing can be avoided on them.
+           */
+          GValue *value;
+          GeglBuffer *buffer;
+          value = gegl_operation_context_get_value (context, gegl_pad_get_name (pad));
+          if (value)
             {
-              /* Mark buffers that have been consumed by different parts of the
-               * graph so that in-place processing can be avoided on them.
-               */
-              GValue *value;
-              GeglBuffer *buffer;
-              value = gegl_operation_context_get_value (context, gegl_pad_get_name (pad));
-              if (value)
-                {
-                  buffer = g_value_get_object (value);
-                  if (buffer)
-                    gegl_object_set_has_forked (buffer);
-                }
+              buffer = g_value_get_object (value);
+              if (buffer)
+                gegl_object_set_has_forked (buffer);
             }
         }
     }
+}
+
+/* passes the data of the output pad an input pad is connected to on to
+ * the context of the input pad
+ */
+static void
+pass_input_pad (GeglVisitor *self,
+                GeglPad     *pad)
+{
+  GeglNode             *node       = gegl_pad_get_node (pad);
+  gpointer              context_id = self->context_id;
+  GeglOperationContext *context    = gegl_node_get_context (node, context_id);
+  GeglPad              *source_pad = gegl_pad_get_connected_to (pad);
+
+  /* the work needed to be done on input pads is to set the
+   * data from the corresponding output pad it is connected to
+   */
+  if (source_pad)
+    {
+      GValue           value          = { 0 };
+      GParamSpec      *prop_spec      = gegl_pad_get_param_spec (pad);
+      GeglNode        *source_node    = gegl_pad_get_node (source_pad);
+      GeglOperationContext *source_context = gegl_node_get_context (source_node, context_id);
+
+      g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (prop_spec));
+
+      gegl_operation_context_get_property (source_context,
+                                      gegl_pad_get_name (source_pad),
+                                      &value);
+
+      if (!g_value_get_object (&value) &&
+          !g_object_get_data (G_OBJECT (source_node), "graph"))
+        g_warning ("eval-visitor encountered a NULL buffer passed from: %s.%s-[%p]",
+                   gegl_node_get_debug_name (source_node),
+                   gegl_pad_get_name (source_pad),
+                   g_value_get_object (&value));
+
+      gegl_operation_context_set_property (context,
+                                      gegl_pad_get_name (pad),
+                                      &value);
+      /* reference counting for this source dropped to zero, freeing up */
+      if (-- gegl_node_get_context (
+                 gegl_pad_get_node (source_pad), context_id)->refs == 0 &&
+          g_value_get_object (&value))
+        {
+          gegl_operation_context_remove_property (
+             gegl_node_get_context (
+                gegl_pad_get_node (source_pad), context_id),
+                gegl_pad_get_name (source_pad));
+        }
+
+      g_value_unset (&value);
+    }
+}
+
+/* processes the node of a connected input pad, if it is a sink */
+static void
+process_input_pad (GeglVisitor *self,
+                   GeglPad     *pad)
+{
+  GeglNode             *node      = gegl_pad_get_node (pad);
+  GeglOperationContext *context   = gegl_node_get_context (node, self->context_id);
+  GeglOperation        *operation = node->operation;
+
+  /* processing for sink operations that accepts partial consumption
+   * and thus probably are being processed by the processor from the
+   * this very operation.
+   */
+  if (gegl_pad_get_connected_to (pad) &&
+      GEGL_IS_OPERATION_SINK (operation) &&
+      !gegl_operation_sink_needs_full (operation))
+    {
+      GEGL_NOTE (GEGL_DEBUG_PROCESS, "Processing pad '%s' on \"%s\"", gegl_pad_get_name (pad), gegl_node_get_debug_name (node));
+      gegl_operation_process (operation, context, "output",
+        &context->result_rect);
+    }
+}
+
+static void
+eval_input_pad (GeglVisitor *self,
+                GeglPad     *pad)
+{
+  pass_input_pad (self, pad);
+  process_input_pad (self, pad);
+}
+
+/* this is the visitor that does the real computations for GEGL */
+static void
+gegl_eval_visitor_visit_pad (GeglVisitor *self,
+                             GeglPad     *pad)
+{
+  GEGL_VISITOR_CLASS (gegl_eval_visitor_parent_class)->visit_pad (self, pad);
+
+  if (gegl_pad_is_output (pad))
+    eval_output_pad (self, pad);
   else if (gegl_pad_is_input (pad))
+    eval_input_pad (self, pad);
+}
+
+static void
+eval_task_free (GeglEvalTask *task)
+{
+  g_slist_free (task->dependents);
+  g_slice_free (GeglEvalTask, task);
+}
+
+/* adds the task for pad and, depth first, the tasks of everything it
+ * depends on, width counts the branches joined by the nodes on the way
+ */
+static GeglEvalTask *
+add_task (GHashTable *tasks,
+          GeglPad    *pad,
+          gint       *width)
+{
+  GeglEvalTask *task = g_hash_table_lookup (tasks, pad);
+  GSList       *depends_on;
+  GSList       *llink;
+  gint          connected = 0;
+
+  if (task)
+    return task;
+
+  task      = g_slice_new0 (GeglEvalTask);
+  task->pad = pad;
+  g_hash_table_insert (tasks, pad, task);
+
+  depends_on = gegl_visitable_depends_on (GEGL_VISITABLE (pad));
+  for (llink = depends_on; llink; llink = g_slist_next (llink))
     {
-      GeglPad *source_pad = gegl_pad_get_connected_to (pad);
+      GeglPad      *source      = llink->data;
+      GeglEvalTask *source_task = add_task (tasks, source, width);
+
+      source_task->dependents = g_slist_prepend (source_task->dependents, task);
+      task->n_sources++;
 
-      /* the work needed to be done on input pads is to set the
-       * data from the corresponding output pad it is connected to
-       */
-      if (source_pad)
+      if (gegl_pad_is_input (source) && gegl_pad_get_connected_to (source))
+        connected++;
+    }
+  g_slist_free (depends_on);
+
+  if (connected > 1)
+    *width += connected - 1;
+
+  return task;
+}
+
+static void
+eval_worker (gint     worker,
+             gpointer user_data)
+{
+  GeglEvalRun *run = user_data;
+
+  g_mutex_lock (run->mutex);
+  while (run->n_done < run->n_tasks)
+    {
+      GeglEvalTask *task;
+      GSList       *llink;
+
+      if (!run->ready)
         {
-          GValue           value          = { 0 };
-          GParamSpec      *prop_spec      = gegl_pad_get_param_spec (pad);
-          GeglNode        *source_node    = gegl_pad_get_node (source_pad);
-          GeglOperationContext *source_context = gegl_node_get_context (source_node, context_id);
-
-          g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (prop_spec));
-
-          gegl_operation_context_get_property (source_context,
-                                          gegl_pad_get_name (source_pad),
-                                          &value);
-
-          if (!g_value_get_object (&value) &&
-              !g_object_get_data (G_OBJECT (source_node), "graph"))
-            g_warning ("eval-visitor encountered a NULL buffer passed from: %s.%s-[%p]",
-                       gegl_node_get_debug_name (source_node),
-                       gegl_pad_get_name (source_pad),
-                       g_value_get_object (&value));
-
-          gegl_operation_context_set_property (context,
-                                          gegl_pad_get_name (pad),
-                                          &value);
-          /* reference counting for this source dropped to zero, freeing up */
-          if (-- gegl_node_get_context (
-                     gegl_pad_get_node (source_pad), context_id)->refs == 0 &&
-              g_value_get_object (&value))
-            {
-              gegl_operation_context_remove_property (
-                 gegl_node_get_context (
-                    gegl_pad_get_node (source_pad), context_id),
-                    gegl_pad_get_name (source_pad));
-            }
+          g_cond_wait (run->cond, run->mutex);
+          continue;
+        }
 
-          g_value_unset (&value);
+      task       = run->ready->data;
+      run->ready = g_slist_delete_link (run->ready, run->ready);
 
-	  /* processing for sink operations that accepts partial consumption
-             and thus probably are being processed by the processor from the
-             this very operation.
+      GEGL_VISITOR_CLASS (gegl_eval_visitor_parent_class)->visit_pad (run->visitor,
+                                                                     task->pad);
+      if (gegl_pad_is_output (task->pad))
+        {
+          /* the nodes themselves are processed concurrently */
+          g_mutex_unlock (run->mutex);
+          eval_output_pad (run->visitor, task->pad);
+          g_mutex_lock (run->mutex);
+        }
+      else if (gegl_pad_is_input (task->pad))
+        {
+          /* input pads change the reference counts of their source's
+           * context, they are cheap and passed on with the lock held,
+           * sinks are processed concurrently like other nodes
            */
-          if (GEGL_IS_OPERATION_SINK (operation) &&
-              !gegl_operation_sink_needs_full (operation))
-            {
-              GEGL_NOTE (GEGL_DEBUG_PROCESS, "Processing pad '%s' on \"%s\"", gegl_pad_get_name (pad), gegl_node_get_debug_name (node));
-              gegl_operation_process (operation, context, "output",
-                &context->result_rect);
-            }
+          pass_input_pad (run->visitor, task->pad);
+          g_mutex_unlock (run->mutex);
+          process_input_pad (run->visitor, task->pad);
+          g_mutex_lock (run->mutex);
+        }
+
+      run->n_done++;
+      for (llink = task->dependents; llink; llink = g_slist_next (llink))
+        {
+          GeglEvalTask *dependent = llink->data;
+
+          if (--dependent->n_sources == 0)
+            run->ready = g_slist_prepend (run->ready, dependent);
         }
+      g_cond_broadcast (run->cond);
+    }
+  g_mutex_unlock (run->mutex);
+}
+
+/**
+ * gegl_eval_visitor_traverse:
+ * @self: a #GeglEvalVisitor
+ * @pad: the pad to evaluate
+ * @n_workers: the number of threads to use
+ *
+ * Evaluates the graph @pad depends on like a depth first traversal
+ * would, but processes nodes whose inputs are all available concurrently
+ * on up to @n_workers threads, so that independent branches joined
+ * further down are computed at the same time. Graphs without such
+ * branches are traversed depth first on the calling thread.
+ **/
+void
+gegl_eval_visitor_traverse (GeglEvalVisitor *self,
+                            GeglPad         *pad,
+                            gint             n_workers)
+{
+  GeglVisitor    *visitor = GEGL_VISITOR (self);
+  GHashTable     *tasks;
+  GHashTableIter  iter;
+  GeglEvalTask   *task;
+  GeglEvalRun     run;
+  gint            width   = 1;
+
+  g_return_if_fail (GEGL_IS_EVAL_VISITOR (self));
+  g_return_if_fail (GEGL_IS_PAD (pad));
+
+  tasks = g_hash_table_new_full (NULL, NULL, NULL,
+                                 (GDestroyNotify) eval_task_free);
+  add_task (tasks, pad, &width);
+
+  if (MIN (n_workers, width) <= 1)
+    {
+      g_hash_table_destroy (tasks);
+      gegl_visitor_dfs_traverse (visitor, GEGL_VISITABLE (pad));
+      return;
     }
+
+  run.visitor = visitor;
+  run.mutex   = g_mutex_new ();
+  run.cond    = g_cond_new ();
+  run.ready   = NULL;
+  run.n_tasks = g_hash_table_size (tasks);
+  run.n_done  = 0;
+
+  g_hash_table_iter_init (&iter, tasks);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &task))
+    if (task->n_sources == 0)
+      run.ready = g_slist_prepend (run.ready, task);
+
+  gegl_scheduler_run_workers (MIN (n_workers, width), eval_worker, &run);
+
+  g_mutex_free (run.mutex);
+  g_cond_free (run.cond);
+  g_hash_table_destroy (tasks);
 }
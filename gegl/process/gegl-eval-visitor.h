@@ -47,6 +47,10 @@ struct _GeglEvalVisitorClass
 
 GType   gegl_eval_visitor_get_type (void) G_GNUC_CONST;
 
+void    gegl_eval_visitor_traverse (GeglEvalVisitor *self,
+                                    GeglPad         *pad,
+                                    gint             n_workers);
+
 
 G_END_DECLS
 
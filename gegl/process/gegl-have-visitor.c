@@ -52,7 +52,7 @@ gegl_have_visitor_init (GeglHaveVisitor *self)
 {
 }
 
-/* sets up the node's bounding box */
+/* sets up the node's bounding box, unless it is still valid */
 static void
 gegl_have_visitor_visit_node (GeglVisitor *self,
                               GeglNode    *node)
@@ -65,7 +65,13 @@ gegl_have_visitor_visit_node (GeglVisitor *self,
     return;
   operation = node->operation;
   g_mutex_lock (node->mutex);
+  if (node->valid_have_rect)
+    {
+      g_mutex_unlock (node->mutex);
+      return;
+    }
   node->have_rect = gegl_operation_get_bounding_box (operation);
+  node->valid_have_rect = TRUE;
 
   GEGL_NOTE (GEGL_DEBUG_PROCESS,
              "For \"%s\" have_rect = %d,%d %d×%d",
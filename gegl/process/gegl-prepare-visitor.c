@@ -51,8 +51,9 @@ gegl_prepare_visitor_init (GeglPrepareVisitor *self)
 {
 }
 
-/* adds a context to the node, calls the operation's prepare method and
- * sets the node's "needed rectangle" to an empty one
+/* adds a context to the node, calls the operation's prepare method if
+ * the node changed since it was last prepared and sets the node's
+ * "needed rectangle" to an empty one
  */
 static void
 gegl_prepare_visitor_visit_node (GeglVisitor *self,
@@ -84,14 +85,27 @@ gegl_prepare_visitor_visit_node (GeglVisitor *self,
             /* issuing a prepare on the graph, FIXME: we might need to do
              * a cycle of prepares as deep as the nesting of graphs,.
              * (or find a better way to do this) */
-            gegl_operation_prepare (GEGL_NODE (graph)->operation);
+            if (!GEGL_NODE (graph)->valid_prepare ||
+                !node->valid_prepare)
+              {
+                gegl_operation_prepare (GEGL_NODE (graph)->operation);
+                GEGL_NODE (graph)->valid_prepare = TRUE;
+              }
             g_mutex_unlock (GEGL_NODE (graph)->mutex);
           }
       }
   }
 
+  /* nodes that didn't change keep the formats they were prepared with,
+   * invalidations clear valid_prepare of the changed nodes and of the
+   * nodes downstream of them
+   */
   g_mutex_lock (node->mutex);
-  gegl_operation_prepare (operation);
+  if (!node->valid_prepare)
+    {
+      gegl_operation_prepare (operation);
+      node->valid_prepare = TRUE;
+    }
   g_mutex_unlock (node->mutex);
   {
     /* initialise the "needed rectangle" to an empty one */
@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include "gegl.h"
 #include "gegl-debug.h"
@@ -28,6 +29,7 @@
 #include "operation/gegl-operation-sink.h"
 
 #include "gegl-config.h"
+#include "gegl-instrument.h"
 #include "gegl-processor.h"
 #include "gegl-types-internal.h"
 #include "gegl-utils.h"
@@ -46,6 +48,12 @@ enum
   PROP_RECTANGLE
 };
 
+enum
+{
+  COMPUTED,
+  LAST_SIGNAL
+};
+
 
 static void      gegl_processor_class_init   (GeglProcessorClass    *klass);
 static void      gegl_processor_init         (GeglProcessor         *self);
@@ -64,7 +72,19 @@ static GObject * gegl_processor_constructor  (GType                  type,
                                               guint                  n_params,
                                               GObjectConstructParam *params);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
-static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static gint      gegl_processor_get_band_size(gint                   start,
+                                              gint                   size,
+                                              gint                   tile_size,
+                                              gint                   band_size) G_GNUC_CONST;
+
+/* fragments rendered per thread in one step of gegl_processor_work */
+#define FRAGMENTS_PER_THREAD 4
+
+/* the time in microseconds a fragment should take to render, the area
+ * of fragments is adapted to it, within one tile and four times the
+ * chunk size
+ */
+#define FRAGMENT_TIME        20000
 
 
 struct _GeglProcessor
@@ -79,6 +99,15 @@ struct _GeglProcessor
   GeglRegion      *queued_region;
   GSList          *dirty_rectangles;
   gint             chunk_size;
+  gint             fragment_area;    /* adapted to the cost of rendering */
+
+  gboolean         try_stream;       /* offer the sink to be streamed to */
+  gboolean         streaming;        /* the sink is written in bands */
+  gboolean         streamed;         /* all bands have been written */
+  gint             stream_y;         /* top of the next band to write */
+
+  GSList          *priority_rectangles; /* rendered first, latest first */
+  gboolean         rendering;        /* a gegl_processor_render_async is running */
 
   gdouble          progress;
 };
@@ -86,6 +115,8 @@ struct _GeglProcessor
 
 G_DEFINE_TYPE (GeglProcessor, gegl_processor, G_TYPE_OBJECT)
 
+static guint gegl_processor_signals[LAST_SIGNAL] = { 0 };
+
 
 static void
 gegl_processor_class_init (GeglProcessorClass *klass)
@@ -125,6 +156,16 @@ gegl_processor_class_init (GeglProcessorClass *klass)
                                                      1, 1024 * 1024, gegl_config()->chunk_size,
                                                      G_PARAM_READWRITE |
                                                      G_PARAM_CONSTRUCT_ONLY));
+
+  gegl_processor_signals[COMPUTED] =
+    g_signal_new ("computed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__BOXED,
+                  G_TYPE_NONE, 1,
+                  GEGL_TYPE_RECTANGLE);
 }
 
 static void
@@ -136,6 +177,11 @@ gegl_processor_init (GeglProcessor *processor)
   processor->queued_region    = NULL;
   processor->dirty_rectangles = NULL;
   processor->chunk_size       = 128 * 128;
+  processor->try_stream       = FALSE;
+  processor->streaming        = FALSE;
+  processor->streamed         = FALSE;
+  processor->priority_rectangles = NULL;
+  processor->rendering        = FALSE;
 }
 
 /* Initialises the fields processor->input, processor->valid_region
@@ -153,6 +199,7 @@ gegl_processor_constructor (GType                  type,
   processor = GEGL_PROCESSOR (object);
 
   processor->queued_region = gegl_region_new ();
+  processor->fragment_area = processor->chunk_size;
 
   return object;
 }
@@ -161,6 +208,10 @@ static void
 gegl_processor_finalize (GObject *self_object)
 {
   GeglProcessor *processor = GEGL_PROCESSOR (self_object);
+  GSList        *iter;
+
+  if (processor->streaming)
+    gegl_operation_sink_stream_end (processor->node->operation, FALSE);
 
   if (processor->context)
     {
@@ -188,6 +239,12 @@ gegl_processor_finalize (GObject *self_object)
       gegl_region_destroy (processor->valid_region);
     }
 
+  for (iter = processor->priority_rectangles; iter; iter = g_slist_next (iter))
+    {
+      g_slice_free (GeglRectangle, iter->data);
+    }
+  g_slist_free (processor->priority_rectangles);
+
   G_OBJECT_CLASS (gegl_processor_parent_class)->finalize (self_object);
 }
 
@@ -361,6 +418,15 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       GeglCache *cache;
       GValue     value = { 0, };
 
+      /* a new rectangle is a new stream */
+      if (processor->streaming)
+        {
+          gegl_operation_sink_stream_end (processor->node->operation, FALSE);
+          processor->streaming = FALSE;
+        }
+      processor->try_stream = TRUE;
+      processor->streamed   = FALSE;
+
       cache = gegl_node_get_cache (processor->input);
 
       if (!gegl_node_get_context (processor->node, cache))
@@ -381,138 +447,195 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
   g_object_notify (G_OBJECT (processor), "rectangle");
 }
 
-/* Will generate band_sizes that are adapted to the size of the tiles */
 static gint
-gegl_processor_get_band_size (gint size)
+floor_div (gint dividend,
+           gint divisor)
 {
-  gint band_size;
+  if (dividend >= 0)
+    return dividend / divisor;
+  return -((-dividend + divisor - 1) / divisor);
+}
 
-  band_size = size / 2;
+/* Cuts a band of about band_size off a side of size pixels starting at
+ * start, ending the band on a tile boundary so that both the band and
+ * the rest start and end on tiles where possible. */
+static gint
+gegl_processor_get_band_size (gint start,
+                              gint size,
+                              gint tile_size,
+                              gint band_size)
+{
+  gint end;
 
-  /* try to make the rects generated match better with potential 2^n sized
-   * tiles, XXX: should be improved to make the next slice fit as well. */
-  if (band_size <= 256)
-    {
-      band_size = MIN(band_size, 128); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
-    }
-  else if (band_size <= 512)
-    {
-      band_size = MIN(band_size, 256); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
-    }
+  /* the last tile boundary within the band, or else the first one */
+  end = floor_div (start + MAX (band_size, 1), tile_size) * tile_size;
+  if (end <= start)
+    end = (floor_div (start, tile_size) + 1) * tile_size;
 
-  if (band_size < 1)
-    band_size = 1;
+  /* no tile boundary to cut at */
+  if (end >= start + size)
+    return MAX (size / 2, 1);
 
-  return band_size;
+  return end - start;
 }
 
-/* If the processor's dirty rectangle is too big then it will be cut, added
- * to the processor's list of dirty rectangles and TRUE will be returned.
- * If the rectangle is small enough it will be processed, using a buffer or
- * not as appropriate, and will return TRUE if there is more work */
-static gboolean
-render_rectangle (GeglProcessor *processor)
+/* Takes the next fragment to render from the processor's dirty rectangles,
+ * cutting dirty rectangles bigger than the chunk size into smaller pieces
+ * first. Returns NULL when there are no dirty rectangles left. */
+static GeglRectangle *
+gegl_processor_next_fragment (GeglProcessor *processor,
+                              gint           tile_width,
+                              gint           tile_height)
 {
-  gboolean   buffered;
-  const gint max_area = processor->chunk_size;
-  GeglCache *cache    = NULL;
-  gint       pxsize;
+  const gint max_area = processor->fragment_area;
 
-  /* Retreive the cache if the processor's node is not buffered if it's
-   * operation is a sink and it doesn't use the full area  */
-  buffered = !(GEGL_IS_OPERATION_SINK(processor->node->operation) &&
-               !gegl_operation_sink_needs_full (processor->node->operation));
-  if (buffered)
-    {
-      cache = gegl_node_get_cache (processor->input);
-      g_object_get (cache, "px-size", &pxsize, NULL);
-    }
-
-  if (processor->dirty_rectangles)
+  while (processor->dirty_rectangles)
     {
       GeglRectangle *dr = processor->dirty_rectangles->data;
 
       /* If a dirty rectangle is bigger than the max area, then cut it
        * to smaller pieces */
-      if (dr->height * dr->width > max_area && 1)
+      if (dr->height * dr->width > max_area)
         {
-          gint band_size;
+          gint           band_size;
+          GeglRectangle *fragment;
 
-          {
-            GeglRectangle *fragment;
-
-            fragment = g_slice_dup (GeglRectangle, dr);
+          fragment = g_slice_dup (GeglRectangle, dr);
 
-            /* When splitting a rectangle, we'll do it on the biggest side */
-            if (dr->width > dr->height)
-              {
-                band_size = gegl_processor_get_band_size ( dr->width );
+          /* When splitting a rectangle, we'll do it on the biggest side,
+           * on the tile grid, into bands of about the maximum area */
+          if (dr->width > dr->height)
+            {
+              band_size = gegl_processor_get_band_size (dr->x, dr->width, tile_width,
+                                                        max_area / dr->height);
 
-                fragment->width = band_size;
-                dr->width      -= band_size;
-                dr->x          += band_size;
-              }
-            else
-              {
-                band_size = gegl_processor_get_band_size (dr->height);
+              fragment->width = band_size;
+              dr->width      -= band_size;
+              dr->x          += band_size;
+            }
+          else
+            {
+              band_size = gegl_processor_get_band_size (dr->y, dr->height, tile_height,
+                                                        max_area / dr->width);
 
-                fragment->height = band_size;
-                dr->height      -= band_size;
-                dr->y           += band_size;
-              }
-            processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
-          }
-          return TRUE;
+              fragment->height = band_size;
+              dr->height      -= band_size;
+              dr->y           += band_size;
+            }
+          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
+          continue;
         }
+
       /* remove the rectangle that will be processed from the list of dirty ones */
       processor->dirty_rectangles = g_slist_remove (processor->dirty_rectangles, dr);
 
       if (!dr->width || !dr->height)
         {
           g_slice_free (GeglRectangle, dr);
-
-          return TRUE;
+          continue;
         }
 
-      if (buffered)
+      return dr;
+    }
+
+  return NULL;
+}
+
+/* Renders the next fragments of the processor's dirty rectangles, using
+ * the cache or not as appropriate, and will return TRUE if there is more
+ * work. Fragments rendered into the cache are rendered concurrently, a
+ * few per thread so that idle threads can take over work from busy ones,
+ * while keeping every call short enough for progress and cancellation. */
+static gboolean
+render_rectangle (GeglProcessor *processor)
+{
+  gboolean   buffered;
+  GeglCache *cache    = NULL;
+
+  /* Retreive the cache if the processor's node is not buffered if it's
+   * operation is a sink and it doesn't use the full area. The cache is
+   * where the processor delivers its results, so its node is cached
+   * whatever its cache-mode and cache-limit, those only decide for the
+   * nodes evaluated on the way  */
+  buffered = !(GEGL_IS_OPERATION_SINK(processor->node->operation) &&
+               !gegl_operation_sink_needs_full (processor->node->operation));
+
+  if (buffered)
+    {
+      GeglRectangle *fragments;
+      GeglRectangle *dr;
+      gint           threads = gegl_config ()->threads;
+      gint           max_fragments;
+      gint           n_fragments = 0;
+      gint           tile_width;
+      gint           tile_height;
+      gint           i;
+
+      cache = gegl_node_get_cache (processor->input);
+      g_object_get (cache, "tile-width", &tile_width,
+                           "tile-height", &tile_height, NULL);
+
+      max_fragments = threads > 1 ? threads * FRAGMENTS_PER_THREAD : 1;
+      fragments = g_new (GeglRectangle, max_fragments);
+
+      while (n_fragments < max_fragments &&
+             (dr = gegl_processor_next_fragment (processor, tile_width, tile_height)))
         {
           /* only do work if the rectangle is not completely inside the valid
            * region of the cache */
           if (gegl_region_rect_in (cache->valid_region, dr) !=
               GEGL_OVERLAP_RECTANGLE_IN)
             {
-              /* create a buffer and initialise it */
-              guchar *buf;
-
               gegl_region_union_with_rect (cache->valid_region, dr);
-              buf = g_malloc (dr->width * dr->height * pxsize);
-              g_assert (buf);
-
-              /* do the image calculations using the buffer */
-              gegl_node_blit (cache->node, 1.0, dr, cache->format, buf,
-                              GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
-
-
-              /* copy the buffer data into the cache */
-              gegl_buffer_set (GEGL_BUFFER (cache), dr, cache->format, buf,
-                               GEGL_AUTO_ROWSTRIDE);
-
-              /* tells the cache that the rectangle (dr) has been computed */
-              gegl_cache_computed (cache, dr);
-
-              /* release the buffer */
-              g_free (buf);
+              fragments[n_fragments++] = *dr;
             }
           g_slice_free (GeglRectangle, dr);
         }
-      else
+
+      if (n_fragments)
         {
-           gegl_node_blit (processor->node, 1.0, dr, NULL, NULL,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
-           gegl_region_union_with_rect (processor->valid_region, dr);
-           g_slice_free (GeglRectangle, dr);
+          glong time = gegl_ticks ();
+          glong fragment_time;
+
+          /* do the image calculations directly into the tiles of the cache */
+          gegl_node_blit_buffer (cache->node, GEGL_BUFFER (cache),
+                                 fragments, n_fragments);
+
+          /* grow fragments that are cheap to render, to bound the cost of
+           * evaluating the graph for every fragment, and shrink expensive
+           * ones to keep the steps of the processor short */
+          fragment_time = (gegl_ticks () - time) * MIN (threads, n_fragments) / n_fragments;
+          if (fragment_time < FRAGMENT_TIME / 2 &&
+              processor->fragment_area < processor->chunk_size * 4)
+            processor->fragment_area *= 2;
+          else if (fragment_time > FRAGMENT_TIME * 2 &&
+                   processor->fragment_area > tile_width * tile_height)
+            processor->fragment_area /= 2;
+
+          /* tells the cache that the fragments have been computed */
+          for (i = 0; i < n_fragments; i++)
+            {
+              gegl_cache_computed (cache, &fragments[i]);
+              g_signal_emit (processor, gegl_processor_signals[COMPUTED], 0,
+                             &fragments[i], NULL);
+            }
+        }
+      g_free (fragments);
+    }
+  else
+    {
+      GeglRectangle *dr = gegl_processor_next_fragment (processor,
+                                                        gegl_config ()->tile_width,
+                                                        gegl_config ()->tile_height);
+
+      if (dr)
+        {
+          gegl_node_blit (processor->node, 1.0, dr, NULL, NULL,
+                          GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+          gegl_region_union_with_rect (processor->valid_region, dr);
+          g_signal_emit (processor, gegl_processor_signals[COMPUTED], 0,
+                         dr, NULL);
+          g_slice_free (GeglRectangle, dr);
         }
     }
 
@@ -581,6 +704,14 @@ gegl_processor_progress (GeglProcessor *processor)
 
   g_return_val_if_fail (processor->input != NULL, 1);
 
+  if (processor->streaming || processor->streamed)
+    {
+      if (processor->rectangle.height <= 0)
+        return 0.999;
+      return (gdouble) (processor->stream_y - processor->rectangle.y) /
+             processor->rectangle.height;
+    }
+
   if (processor->valid_region)
     {
       valid_region = processor->valid_region;
@@ -732,6 +863,103 @@ gegl_processor_render (GeglProcessor *processor,
   return !gegl_processor_is_rendered (processor);
 }
 
+/* Works on the latest prioritized rectangle that isn't rendered yet,
+ * forgetting the ones that are. Returns FALSE when all of them are
+ * rendered. */
+static gboolean
+gegl_processor_render_priority (GeglProcessor *processor,
+                                gdouble       *progress)
+{
+  while (processor->priority_rectangles)
+    {
+      GeglRectangle *priority = processor->priority_rectangles->data;
+      GeglRectangle  roi;
+
+      if (gegl_rectangle_intersect (&roi, priority, &processor->rectangle) &&
+          gegl_processor_render (processor, &roi, NULL))
+        {
+          if (progress)
+            *progress = gegl_processor_progress (processor);
+          return TRUE;
+        }
+
+      processor->priority_rectangles = g_slist_remove (processor->priority_rectangles,
+                                                       priority);
+      g_slice_free (GeglRectangle, priority);
+    }
+
+  return FALSE;
+}
+
+/* Renders the next band of a streaming sink into a buffer of its own and
+ * hands it to the sink, freeing it again once it has been written. The
+ * bands are a few chunks per thread tall, ending on the tile grid, and
+ * every band is rendered concurrently like the fragments of the cache.
+ * Returns TRUE while there are bands left. */
+static gboolean
+gegl_processor_stream (GeglProcessor *processor,
+                       gdouble       *progress)
+{
+  GeglOperation *sink    = processor->node->operation;
+  GeglRectangle *roi     = &processor->rectangle;
+  GeglRectangle  band;
+  gboolean       success = TRUE;
+
+  band.x      = roi->x;
+  band.y      = processor->stream_y;
+  band.width  = roi->width;
+  band.height = roi->y + roi->height - band.y;
+
+  if (band.width > 0 && band.height > 0)
+    {
+      GeglCache  *cache   = gegl_node_get_cache (processor->input);
+      gint        threads = MAX (gegl_config ()->threads, 1);
+      gint        rows    = processor->chunk_size * threads / band.width;
+      const Babl *format;
+      GeglBuffer *buffer;
+      gint        tile_height;
+
+      g_object_get (cache, "format", &format,
+                           "tile-height", &tile_height, NULL);
+
+      if (rows < band.height)
+        band.height = gegl_processor_get_band_size (band.y, band.height,
+                                                    tile_height, rows);
+
+      buffer = gegl_buffer_new (&band, format);
+      gegl_node_blit_buffer (processor->input, buffer, &band, 1);
+      success = gegl_operation_sink_stream_band (sink, buffer, &band);
+      g_object_unref (buffer);
+
+      if (success)
+        {
+          g_signal_emit (processor, gegl_processor_signals[COMPUTED], 0,
+                         &band, NULL);
+          processor->stream_y += band.height;
+        }
+    }
+
+  if (success && processor->stream_y < roi->y + roi->height)
+    {
+      if (progress)
+        *progress = gegl_processor_progress (processor);
+      return TRUE;
+    }
+
+  /* a failed stream is not retried, the saver has discarded its output */
+  if (!success)
+    g_warning ("%s: failed to write the band at y=%i",
+               gegl_node_get_debug_name (processor->node), band.y);
+
+  gegl_operation_sink_stream_end (sink, success);
+  processor->streaming = FALSE;
+  processor->streamed  = TRUE;
+
+  if (progress)
+    *progress = gegl_processor_progress (processor);
+  return FALSE;
+}
+
 /* Will call gegl_processor_render and when there is no more work to be done,
  * it will write the result to the destination */
 gboolean
@@ -756,9 +984,41 @@ gegl_processor_work (GeglProcessor *processor,
         if (GEGL_OPERATION_GET_CLASS(node->operation)->opencl_support)
           {
             processor->chunk_size = 1024*1024;
+            processor->fragment_area = MAX (processor->fragment_area,
+                                            processor->chunk_size);
           }
       }
 
+  /* sinks that can be written in bands are streamed to instead of
+   * rendering all of their input into the cache first */
+  if (processor->try_stream)
+    {
+      processor->try_stream = FALSE;
+
+      if (processor->context &&
+          gegl_operation_sink_stream_begin (processor->node->operation,
+                                            &processor->rectangle))
+        {
+          gegl_node_remove_context (processor->node, cache);
+          processor->context   = NULL;
+          processor->streaming = TRUE;
+          processor->stream_y  = processor->rectangle.y;
+        }
+    }
+
+  if (processor->streaming)
+    return gegl_processor_stream (processor, progress);
+
+  if (processor->streamed)
+    {
+      if (progress)
+        *progress = gegl_processor_progress (processor);
+      return FALSE;
+    }
+
+  if (gegl_processor_render_priority (processor, progress))
+    return TRUE;
+
   more_work = gegl_processor_render (processor, &processor->rectangle, progress);
   if (more_work)
     {
@@ -787,6 +1047,120 @@ gegl_processor_work (GeglProcessor *processor,
   return FALSE;
 }
 
+void
+gegl_processor_prioritize (GeglProcessor       *processor,
+                           const GeglRectangle *rectangle)
+{
+  GSList *iter;
+
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+  g_return_if_fail (rectangle != NULL);
+
+  processor->priority_rectangles = g_slist_prepend (processor->priority_rectangles,
+                                                    g_slice_dup (GeglRectangle, rectangle));
+
+  /* the queued fragments aren't part of the valid region yet, and are
+   * queued again when their turn comes */
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    {
+      g_slice_free (GeglRectangle, iter->data);
+    }
+  g_slist_free (processor->dirty_rectangles);
+  processor->dirty_rectangles = NULL;
+}
+
+typedef struct
+{
+  GeglProcessor      *processor;
+  GCancellable       *cancellable;
+  GSimpleAsyncResult *result;
+} GeglProcessorRender;
+
+static void
+gegl_processor_render_free (gpointer data)
+{
+  GeglProcessorRender *render = data;
+
+  render->processor->rendering = FALSE;
+
+  g_object_unref (render->result);
+  if (render->cancellable)
+    g_object_unref (render->cancellable);
+  g_object_unref (render->processor);
+  g_slice_free (GeglProcessorRender, render);
+}
+
+/* does one step of work per main loop iteration, the steps are kept
+ * short so that cancelling and changes to the graph take effect soon */
+static gboolean
+gegl_processor_render_step (gpointer data)
+{
+  GeglProcessorRender *render = data;
+  GError              *error  = NULL;
+
+  if (g_cancellable_set_error_if_cancelled (render->cancellable, &error))
+    {
+      g_simple_async_result_take_error (render->result, error);
+      g_simple_async_result_complete (render->result);
+      return FALSE;
+    }
+
+  if (gegl_processor_work (render->processor, NULL))
+    return TRUE;
+
+  g_simple_async_result_set_op_res_gboolean (render->result, TRUE);
+  g_simple_async_result_complete (render->result);
+  return FALSE;
+}
+
+void
+gegl_processor_render_async (GeglProcessor       *processor,
+                             gint                 priority,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+  GeglProcessorRender *render;
+  GSource             *source;
+
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+  g_return_if_fail (! processor->rendering);
+
+  render = g_slice_new (GeglProcessorRender);
+  render->processor   = g_object_ref (processor);
+  render->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+  render->result      = g_simple_async_result_new (G_OBJECT (processor),
+                                                   callback, user_data,
+                                                   gegl_processor_render_async);
+  processor->rendering = TRUE;
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, priority);
+  g_source_set_callback (source, gegl_processor_render_step, render,
+                         gegl_processor_render_free);
+  g_source_attach (source, g_main_context_get_thread_default ());
+  g_source_unref (source);
+}
+
+gboolean
+gegl_processor_render_finish (GeglProcessor  *processor,
+                              GAsyncResult   *result,
+                              GError        **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (processor),
+                                                        gegl_processor_render_async),
+                        FALSE);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return FALSE;
+
+  return g_simple_async_result_get_op_res_gboolean (simple);
+}
+
 void
 gegl_processor_destroy (GeglProcessor *processor)
 {
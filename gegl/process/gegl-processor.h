@@ -19,6 +19,8 @@
 #ifndef __GEGL_PROCESSOR_H__
 #define __GEGL_PROCESSOR_H__
 
+#include <gio/gio.h>
+
 #include "gegl-types-internal.h"
 
 G_BEGIN_DECLS
@@ -45,6 +47,16 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
                                              const GeglRectangle *rectangle);
 gboolean       gegl_processor_work          (GeglProcessor       *processor,
                                              gdouble             *progress);
+void           gegl_processor_prioritize    (GeglProcessor       *processor,
+                                             const GeglRectangle *rectangle);
+void           gegl_processor_render_async  (GeglProcessor       *processor,
+                                             gint                 priority,
+                                             GCancellable        *cancellable,
+                                             GAsyncReadyCallback  callback,
+                                             gpointer             user_data);
+gboolean       gegl_processor_render_finish (GeglProcessor       *processor,
+                                             GAsyncResult        *result,
+                                             GError             **error);
 void           gegl_processor_destroy       (GeglProcessor       *processor);
 
 G_END_DECLS
@@ -0,0 +1,585 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SCHED_SETAFFINITY
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#endif
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-scheduler.h"
+
+/* units are grown until there are no more than this many per worker,
+ * every unit is a separate evaluation of the graph
+ */
+#define UNITS_PER_WORKER 16
+
+/* with the locality policies, the tile grid is divided among the workers
+ * in blocks of this many tiles on each side
+ */
+#define LOCALITY_BLOCK   4
+
+/* the units still to be rendered by a worker are the range head..tail,
+ * the owner takes units from the head and thieves from the tail
+ */
+typedef struct _GeglSchedulerDeque
+{
+  GMutex *mutex;
+  gint    head;
+  gint    tail;
+} GeglSchedulerDeque;
+
+typedef struct _GeglSchedulerRun
+{
+  const GeglRectangle     *units;
+  gint                     n_units;
+  gint                     n_workers;
+  GeglSchedulerDeque      *deques;
+  gint                    *order;       /* units in the order of the deques,
+                                           NULL if they are in order */
+  GeglSchedulerPolicy      policy;
+
+  GeglSchedulerFunc        func;
+  GeglSchedulerWorkerFunc  worker_func; /* runs instead of units if set */
+  gpointer                 user_data;
+
+  GMutex                  *mutex;
+  GCond                   *cond;
+  gint                     running;     /* pool workers not done yet */
+} GeglSchedulerRun;
+
+typedef struct _GeglSchedulerTask
+{
+  GeglSchedulerRun *run;
+  gint              worker;
+} GeglSchedulerTask;
+
+/* the workers of runs other than the calling one, pool thread i always
+ * runs worker i + 1
+ */
+typedef struct _GeglSchedulerThread
+{
+  GAsyncQueue *tasks;
+  gint         index;
+  gboolean     pinned;
+} GeglSchedulerThread;
+
+static GPtrArray    *pool       = NULL; /* grows to the most workers used */
+static GStaticMutex  pool_mutex = G_STATIC_MUTEX_INIT;
+
+#ifdef HAVE_SCHED_SETAFFINITY
+static cpu_set_t     pool_cpus;         /* the cpus the process may run on */
+static gint          n_pool_cpus = 0;
+#endif
+
+/* worker + 1 of the unit being rendered by this thread, 0 if none */
+static GStaticPrivate current_worker = G_STATIC_PRIVATE_INIT;
+
+static gint
+floor_div (gint dividend,
+           gint divisor)
+{
+  if (dividend >= 0)
+    return dividend / divisor;
+  return -((-dividend + divisor - 1) / divisor);
+}
+
+/* returns the policy selected by GeglConfig:thread-policy */
+static GeglSchedulerPolicy
+scheduler_policy (void)
+{
+  return g_atomic_int_get (&gegl_config ()->scheduler_policy);
+}
+
+/* the worker owning the block of the tile grid the top left corner of
+ * unit lies in. The same parts of the grid are rendered by the same
+ * worker every time, keeping the data of their tiles on the cpu and
+ * memory node of the pool thread that created them.
+ */
+static gint
+home_worker (const GeglRectangle *unit,
+             gint                 n_workers)
+{
+  gint  block_width  = MAX (gegl_config ()->tile_width, 1) * LOCALITY_BLOCK;
+  gint  block_height = MAX (gegl_config ()->tile_height, 1) * LOCALITY_BLOCK;
+  guint hash;
+
+  hash = (guint) floor_div (unit->x, block_width) * 73856093u ^
+         (guint) floor_div (unit->y, block_height) * 19349663u;
+
+  return hash % n_workers;
+}
+
+static gint
+count_units (const GeglRectangle *roi,
+             gint                 unit_width,
+             gint                 unit_height)
+{
+  gint columns = floor_div (roi->x + roi->width - 1, unit_width) -
+                 floor_div (roi->x, unit_width) + 1;
+  gint rows    = floor_div (roi->y + roi->height - 1, unit_height) -
+                 floor_div (roi->y, unit_height) + 1;
+
+  return columns * rows;
+}
+
+/* splits roi on a grid of unit_width x unit_height, in rows from the top */
+static GeglRectangle *
+split_units (const GeglRectangle *roi,
+             gint                 unit_width,
+             gint                 unit_height,
+             gint                *n_units)
+{
+  GeglRectangle *units = g_new (GeglRectangle, count_units (roi, unit_width, unit_height));
+  gint           n     = 0;
+  gint           y     = roi->y;
+
+  while (y < roi->y + roi->height)
+    {
+      gint next_y = (floor_div (y, unit_height) + 1) * unit_height;
+      gint x      = roi->x;
+
+      next_y = MIN (next_y, roi->y + roi->height);
+
+      while (x < roi->x + roi->width)
+        {
+          gint next_x = (floor_div (x, unit_width) + 1) * unit_width;
+
+          next_x = MIN (next_x, roi->x + roi->width);
+
+          units[n].x      = x;
+          units[n].y      = y;
+          units[n].width  = next_x - x;
+          units[n].height = next_y - y;
+          n++;
+
+          x = next_x;
+        }
+      y = next_y;
+    }
+
+  *n_units = n;
+  return units;
+}
+
+static gboolean
+pop_unit (GeglSchedulerRun *run,
+          gint              worker,
+          gint             *unit)
+{
+  GeglSchedulerDeque *deque = &run->deques[worker];
+  gboolean            found = FALSE;
+
+  g_mutex_lock (deque->mutex);
+  if (deque->head < deque->tail)
+    {
+      *unit = deque->head++;
+      found = TRUE;
+    }
+  g_mutex_unlock (deque->mutex);
+
+  return found;
+}
+
+/* moves the later half of the units left to the busiest worker to the
+ * empty deque of worker, returns FALSE when no units are left at all
+ */
+static gboolean
+steal_units (GeglSchedulerRun *run,
+             gint              worker)
+{
+  while (TRUE)
+    {
+      GeglSchedulerDeque *victim   = NULL;
+      gint                most     = 0;
+      gint                head     = 0;
+      gint                tail     = 0;
+      gint                i;
+
+      /* the sizes are only read as a hint, they are checked again
+       * with the lock of the victim held
+       */
+      for (i = 0; i < run->n_workers; i++)
+        {
+          GeglSchedulerDeque *deque = &run->deques[i];
+          gint                left  = deque->tail - deque->head;
+
+          if (i != worker && left > most)
+            {
+              victim = deque;
+              most   = left;
+            }
+        }
+
+      if (!victim)
+        return FALSE;
+
+      g_mutex_lock (victim->mutex);
+      if (victim->head < victim->tail)
+        {
+          tail         = victim->tail;
+          head         = tail - (victim->tail - victim->head + 1) / 2;
+          victim->tail = head;
+        }
+      g_mutex_unlock (victim->mutex);
+
+      if (head < tail)
+        {
+          GeglSchedulerDeque *deque = &run->deques[worker];
+
+          g_mutex_lock (deque->mutex);
+          deque->head = head;
+          deque->tail = tail;
+          g_mutex_unlock (deque->mutex);
+          return TRUE;
+        }
+      /* the victim ran out of units meanwhile, look again */
+    }
+}
+
+static void
+work (GeglSchedulerRun *run,
+      gint              worker)
+{
+  gpointer previous = g_static_private_get (&current_worker);
+  gint     unit;
+
+  g_static_private_set (&current_worker, GINT_TO_POINTER (worker + 1), NULL);
+
+  if (run->worker_func)
+    run->worker_func (worker, run->user_data);
+  else
+    while (pop_unit (run, worker, &unit) ||
+           (steal_units (run, worker) && pop_unit (run, worker, &unit)))
+      {
+        run->func (&run->units[run->order ? run->order[unit] : unit],
+                   worker, run->user_data);
+      }
+
+  g_static_private_set (&current_worker, previous, NULL);
+}
+
+/* pins the calling pool thread to a cpu of its own, or lets it run on
+ * all cpus of the process again. The cpus are handed out from the second
+ * one on, the first one is left to the threads calling into the pool.
+ */
+static void
+pool_thread_pin (GeglSchedulerThread *thread,
+                 gboolean             pinned)
+{
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t cpus;
+
+  if (thread->pinned == pinned || n_pool_cpus <= 1)
+    return;
+
+  if (pinned)
+    {
+      gint nth = (thread->index + 1) % n_pool_cpus;
+      gint cpu;
+
+      CPU_ZERO (&cpus);
+      for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET (cpu, &pool_cpus) && nth-- == 0)
+          {
+            CPU_SET (cpu, &cpus);
+            break;
+          }
+    }
+  else
+    {
+      cpus = pool_cpus;
+    }
+
+  if (sched_setaffinity (0, sizeof (cpus), &cpus) == 0)
+    thread->pinned = pinned;
+#endif
+}
+
+static gpointer
+pool_thread (gpointer data)
+{
+  GeglSchedulerThread *thread = data;
+
+  while (TRUE)
+    {
+      GeglSchedulerTask *task = g_async_queue_pop (thread->tasks);
+      GeglSchedulerRun  *run  = task->run;
+
+      pool_thread_pin (thread, run->policy == GEGL_SCHEDULER_PINNED);
+
+      work (run, task->worker);
+
+      g_mutex_lock (run->mutex);
+      if (--run->running == 0)
+        g_cond_signal (run->cond);
+      g_mutex_unlock (run->mutex);
+    }
+
+  return NULL;
+}
+
+/* hands workers 1 to n_workers - 1 of run to the pool, creating the pool
+ * threads missing. Returns the number of workers started, which is
+ * smaller if threads couldn't be created, the units of the workers not
+ * started are stolen by the others.
+ */
+static gint
+start_workers (GeglSchedulerRun  *run,
+               GeglSchedulerTask *tasks)
+{
+  gint i;
+
+  g_static_mutex_lock (&pool_mutex);
+
+  if (!pool)
+    {
+      pool = g_ptr_array_new ();
+#ifdef HAVE_SCHED_SETAFFINITY
+      if (sched_getaffinity (0, sizeof (pool_cpus), &pool_cpus) == 0)
+        n_pool_cpus = CPU_COUNT (&pool_cpus);
+#endif
+    }
+
+  while ((gint) pool->len < run->n_workers - 1)
+    {
+      GeglSchedulerThread *thread = g_new0 (GeglSchedulerThread, 1);
+
+      thread->tasks = g_async_queue_new ();
+      thread->index = pool->len;
+
+      if (!g_thread_create (pool_thread, thread, FALSE, NULL))
+        {
+          g_async_queue_unref (thread->tasks);
+          g_free (thread);
+          break;
+        }
+      g_ptr_array_add (pool, thread);
+    }
+
+  for (i = 1; i < run->n_workers && i <= (gint) pool->len; i++)
+    {
+      GeglSchedulerThread *thread = g_ptr_array_index (pool, i - 1);
+
+      g_async_queue_push (thread->tasks, &tasks[i]);
+    }
+
+  g_static_mutex_unlock (&pool_mutex);
+
+  return i;
+}
+
+/* renders units on the calling thread, keeping the worker of an
+ * enclosing run when nested. At the top level the pool stays free for
+ * runs nested in the units.
+ */
+static void
+run_serial (const GeglRectangle *units,
+            gint                 n_units,
+            GeglSchedulerFunc    func,
+            gpointer             user_data)
+{
+  gint nested = GPOINTER_TO_INT (g_static_private_get (&current_worker));
+  gint worker = nested ? nested - 1 : 0;
+  gint i;
+
+  for (i = 0; i < n_units; i++)
+    func (&units[i], worker, user_data);
+}
+
+/* runs the workers of run on the pool, the calling thread is worker 0 */
+static void
+run_parallel (GeglSchedulerRun *run)
+{
+  GeglSchedulerTask *tasks = g_new (GeglSchedulerTask, run->n_workers);
+  gint               i;
+
+  run->mutex   = g_mutex_new ();
+  run->cond    = g_cond_new ();
+
+  for (i = 0; i < run->n_workers; i++)
+    {
+      tasks[i].run    = run;
+      tasks[i].worker = i;
+    }
+
+  /* held while starting the workers, those done early wait for the count */
+  g_mutex_lock (run->mutex);
+  run->running = start_workers (run, tasks) - 1;
+  g_mutex_unlock (run->mutex);
+
+  work (run, 0);
+
+  g_mutex_lock (run->mutex);
+  while (run->running != 0)
+    g_cond_wait (run->cond, run->mutex);
+  g_mutex_unlock (run->mutex);
+
+  g_mutex_free (run->mutex);
+  g_cond_free (run->cond);
+  g_free (tasks);
+}
+
+void
+gegl_scheduler_run_units (const GeglRectangle *units,
+                          gint                 n_units,
+                          gint                 n_workers,
+                          GeglSchedulerFunc    func,
+                          gpointer             user_data)
+{
+  GeglSchedulerRun run;
+  gint             i;
+
+  if (n_units <= 0)
+    return;
+
+  if (g_static_private_get (&current_worker) ||
+      MIN (n_workers, n_units) <= 1)
+    {
+      run_serial (units, n_units, func, user_data);
+      return;
+    }
+
+  run.units       = units;
+  run.n_units     = n_units;
+  run.n_workers   = MIN (n_workers, n_units);
+  run.order       = NULL;
+  run.policy      = scheduler_policy ();
+  run.func        = func;
+  run.worker_func = NULL;
+  run.user_data   = user_data;
+  run.deques      = g_new (GeglSchedulerDeque, run.n_workers);
+
+  for (i = 0; i < run.n_workers; i++)
+    run.deques[i].mutex = g_mutex_new ();
+
+  if (run.policy == GEGL_SCHEDULER_NONE)
+    {
+      /* every worker starts with a contiguous run of units, keeping
+       * neighbouring tiles on the same thread
+       */
+      for (i = 0; i < run.n_workers; i++)
+        {
+          run.deques[i].head = run.n_units * i / run.n_workers;
+          run.deques[i].tail = run.n_units * (i + 1) / run.n_workers;
+        }
+    }
+  else
+    {
+      /* every worker starts with the units of its own blocks */
+      gint *home  = g_new (gint, n_units);
+      gint *start = g_new0 (gint, run.n_workers + 1);
+
+      for (i = 0; i < n_units; i++)
+        {
+          home[i] = home_worker (&units[i], run.n_workers);
+          start[home[i] + 1]++;
+        }
+      for (i = 0; i < run.n_workers; i++)
+        {
+          start[i + 1]      += start[i];
+          run.deques[i].head = start[i];
+          run.deques[i].tail = start[i + 1];
+        }
+
+      run.order = g_new (gint, n_units);
+      for (i = 0; i < n_units; i++)
+        run.order[start[home[i]]++] = i;
+
+      g_free (home);
+      g_free (start);
+    }
+
+  run_parallel (&run);
+
+  for (i = 0; i < run.n_workers; i++)
+    g_mutex_free (run.deques[i].mutex);
+  g_free (run.deques);
+  g_free (run.order);
+}
+
+void
+gegl_scheduler_run_workers (gint                    n_workers,
+                            GeglSchedulerWorkerFunc func,
+                            gpointer                user_data)
+{
+  GeglSchedulerRun run;
+  gint             nested = GPOINTER_TO_INT (g_static_private_get (&current_worker));
+
+  if (nested || n_workers <= 1)
+    {
+      func (nested ? nested - 1 : 0, user_data);
+      return;
+    }
+
+  run.units       = NULL;
+  run.n_units     = 0;
+  run.n_workers   = n_workers;
+  run.deques      = NULL;
+  run.order       = NULL;
+  run.policy      = scheduler_policy ();
+  run.func        = NULL;
+  run.worker_func = func;
+  run.user_data   = user_data;
+
+  run_parallel (&run);
+}
+
+void
+gegl_scheduler_run (const GeglRectangle *roi,
+                    gint                 tile_width,
+                    gint                 tile_height,
+                    gint                 n_workers,
+                    GeglSchedulerFunc    func,
+                    gpointer             user_data)
+{
+  GeglRectangle *units;
+  gint           n_units;
+  gint           unit_width  = MAX (tile_width, 1);
+  gint           unit_height = MAX (tile_height, 1);
+
+  if (roi->width <= 0 || roi->height <= 0)
+    return;
+
+  if (g_static_private_get (&current_worker) || n_workers <= 1)
+    {
+      run_serial (roi, 1, func, user_data);
+      return;
+    }
+
+  while (count_units (roi, unit_width, unit_height) > UNITS_PER_WORKER * n_workers)
+    {
+      if (unit_width / MAX (tile_width, 1) <= unit_height / MAX (tile_height, 1))
+        unit_width *= 2;
+      else
+        unit_height *= 2;
+    }
+
+  units = split_units (roi, unit_width, unit_height, &n_units);
+  if (n_units == 1)
+    run_serial (roi, 1, func, user_data);
+  else
+    gegl_scheduler_run_units (units, n_units, n_workers, func, user_data);
+  g_free (units);
+}
@@ -0,0 +1,87 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_SCHEDULER_H__
+#define __GEGL_SCHEDULER_H__
+
+#include "gegl-types-internal.h"
+#include "buffer/gegl-buffer-types.h"
+
+G_BEGIN_DECLS
+
+/* renders one work unit, worker is in the range 0 to n_workers - 1 and
+ * no two units are rendered with the same worker at the same time.
+ */
+typedef void (*GeglSchedulerFunc) (const GeglRectangle *unit,
+                                   gint                 worker,
+                                   gpointer             user_data);
+
+/* body of one worker of gegl_scheduler_run_workers */
+typedef void (*GeglSchedulerWorkerFunc) (gint                 worker,
+                                         gpointer             user_data);
+
+/* Splits roi into work units aligned to the tile grid, and renders
+ * them with n_workers threads, the calling thread being one of them.
+ * Every worker starts with its own units and steals half of the
+ * remaining units of the busiest worker when it runs out, so that
+ * expensive parts of roi don't leave the other threads idle. Returns
+ * when all units have been rendered.
+ *
+ * The other workers are run by a pool of threads that grows to the
+ * largest number of workers used, worker i always being run by the same
+ * thread. GeglConfig:thread-policy selects how units are given to the
+ * workers: "none" gives every worker a contiguous run of units,
+ * "locality" gives every worker the units in its own blocks of the tile
+ * grid so that the same worker renders the same tiles every time, and
+ * "pinned" additionally pins every pool thread to a cpu of its own.
+ *
+ * With a single worker, or when called from within a unit, roi is
+ * rendered as one unit on the calling thread, with the worker of the
+ * enclosing unit. Only runs nested in units rendered by other threads
+ * are kept serial, the units of a serial run at the top level can still
+ * use the other threads.
+ */
+void gegl_scheduler_run (const GeglRectangle *roi,
+                         gint                 tile_width,
+                         gint                 tile_height,
+                         gint                 n_workers,
+                         GeglSchedulerFunc    func,
+                         gpointer             user_data);
+
+/* like gegl_scheduler_run, for units given by the caller, that are
+ * rendered as they are
+ */
+void gegl_scheduler_run_units (const GeglRectangle *units,
+                               gint                 n_units,
+                               gint                 n_workers,
+                               GeglSchedulerFunc    func,
+                               gpointer             user_data);
+
+/* Runs func once on each of n_workers threads, the calling thread being
+ * worker 0, and returns when all of them have returned. The workers
+ * hand out the work among themselves through user_data, for work that
+ * can't be cut into rectangles up front.
+ *
+ * When called from within a unit, func only runs on the calling
+ * thread, with the worker of the enclosing unit.
+ */
+void gegl_scheduler_run_workers (gint                    n_workers,
+                                 GeglSchedulerWorkerFunc func,
+                                 gpointer                user_data);
+
+G_END_DECLS
+
+#endif /* __GEGL_SCHEDULER_H__ */
@@ -201,6 +201,22 @@ cl_process (GeglOperation       *op,
   return errcode;
 }
 
+/* the kernel_bc body, for fusing with the point filters around it */
+static const char* fuse_source =
+"v.xyz = (v.xyz - 0.5f) * p[1] + p[0] + 0.5f;";
+
+static gint
+cl_fuse_parameters (GeglOperation *op,
+                    gfloat        *parameters)
+{
+  GeglChantO *o = GEGL_CHANT_PROPERTIES (op);
+
+  parameters[0] = o->brightness;
+  parameters[1] = o->contrast;
+
+  return 2;
+}
+
 
 /*
  * The class init function sets up information needed for this operations class
@@ -224,6 +240,8 @@ gegl_chant_class_init (GeglChantClass *klass)
   operation_class->prepare = prepare;
 
   point_filter_class->cl_process           = cl_process;
+  point_filter_class->cl_fuse_source       = fuse_source;
+  point_filter_class->cl_fuse_parameters   = cl_fuse_parameters;
 
   /* specify the name this operation is found under in the GUI/when
    * programming/in XML
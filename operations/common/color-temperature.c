@@ -270,6 +270,29 @@ cl_process (GeglOperation       *op,
   return errcode;
 }
 
+/* the kernel_bc body, for fusing with the point filters around it */
+static const char* fuse_source =
+"v.xyz *= (float3) (p[0], p[1], p[2]);";
+
+static gint
+cl_fuse_parameters (GeglOperation *op,
+                    gfloat        *parameters)
+{
+  GeglChantO   *o      = GEGL_CHANT_PROPERTIES (op);
+  const gfloat *coeffs = o->chant_data;
+
+  if (! coeffs)
+    {
+      coeffs = o->chant_data = preprocess (o);
+    }
+
+  parameters[0] = coeffs[0];
+  parameters[1] = coeffs[1];
+  parameters[2] = coeffs[2];
+
+  return 3;
+}
+
 
 
 static void
@@ -290,7 +313,8 @@ gegl_chant_class_init (GeglChantClass *klass)
 
   point_filter_class->process = process;
   point_filter_class->cl_process           = cl_process;
-//  point_filter_class->cl_kernel_source     = kernel_source;
+  point_filter_class->cl_fuse_source       = fuse_source;
+  point_filter_class->cl_fuse_parameters   = cl_fuse_parameters;
   operation_class->opencl_support = TRUE;
 
   operation_class->name        = "gegl:color-temperature";
@@ -156,6 +156,10 @@ cl_process (GeglOperation       *op,
   return errcode;
 }
 
+/* the kernel_invert body, for fusing with the point filters around it */
+static const char* fuse_source =
+"v.xyz = 1.0f - v.xyz;";
+
 static void
 gegl_chant_class_init (GeglChantClass *klass)
 {
@@ -168,7 +172,7 @@ gegl_chant_class_init (GeglChantClass *klass)
    operation_class->prepare = prepare;
   point_filter_class->process = process;
   point_filter_class->cl_process           = cl_process;
-//  point_filter_class->cl_kernel_source     = kernel_source;
+  point_filter_class->cl_fuse_source       = fuse_source;
 
   operation_class->name        = "gegl:invert";
 
@@ -202,6 +202,27 @@ cl_process (GeglOperation       *op,
   return errcode;
 }
 
+/* the kernel_bc body, for fusing with the point filters around it */
+static const char* fuse_source =
+"v.xyz = (v.xyz - p[0]) * p[2] + p[1];";
+
+static gint
+cl_fuse_parameters (GeglOperation *op,
+                    gfloat        *parameters)
+{
+  GeglChantO *o        = GEGL_CHANT_PROPERTIES (op);
+  gfloat      in_range = o->in_high - o->in_low;
+
+  if (in_range == 0.0)
+    in_range = 0.00000001;
+
+  parameters[0] = o->in_low;
+  parameters[1] = o->out_low;
+  parameters[2] = (o->out_high - o->out_low) / in_range;
+
+  return 3;
+}
+
 
 static void
 gegl_chant_class_init (GeglChantClass *klass)
@@ -217,7 +238,8 @@ gegl_chant_class_init (GeglChantClass *klass)
   operation_class->prepare = prepare;
 
   point_filter_class->cl_process           = cl_process;
-//  point_filter_class->cl_kernel_source     = kernel_source;
+  point_filter_class->cl_fuse_source       = fuse_source;
+  point_filter_class->cl_fuse_parameters   = cl_fuse_parameters;
   operation_class->opencl_support = TRUE;
 
   operation_class->name        = "gegl:levels";
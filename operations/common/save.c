@@ -157,6 +157,36 @@ gegl_save_process (GeglOperation        *operation,
                                  roi);
 }
 
+/* the saver is streamed to when it supports it */
+static gboolean
+gegl_save_stream_begin (GeglOperation       *operation,
+                        const GeglRectangle *roi)
+{
+  GeglChant *self = GEGL_CHANT (operation);
+  gegl_save_set_saver (operation);
+
+  return gegl_operation_sink_stream_begin (self->save->operation, roi);
+}
+
+static gboolean
+gegl_save_stream_band (GeglOperation       *operation,
+                       GeglBuffer          *input,
+                       const GeglRectangle *band)
+{
+  GeglChant *self = GEGL_CHANT (operation);
+
+  return gegl_operation_sink_stream_band (self->save->operation, input, band);
+}
+
+static void
+gegl_save_stream_end (GeglOperation *operation,
+                      gboolean       success)
+{
+  GeglChant *self = GEGL_CHANT (operation);
+
+  gegl_operation_sink_stream_end (self->save->operation, success);
+}
+
 static void
 gegl_save_dispose (GObject *object)
 {
@@ -184,7 +214,10 @@ gegl_chant_class_init (GeglChantClass *klass)
   operation_class->process = gegl_operation_process;
   operation_class->process = gegl_save_process;
 
-  sink_class->needs_full = TRUE;
+  sink_class->needs_full   = TRUE;
+  sink_class->stream_begin = gegl_save_stream_begin;
+  sink_class->stream_band  = gegl_save_stream_band;
+  sink_class->stream_end   = gegl_save_stream_end;
 
   operation_class->name        = "gegl:save";
   operation_class->categories  = "meta:output";
@@ -229,6 +229,20 @@ cl_process (GeglOperation       *op,
   return errcode;
 }
 
+/* the kernel_bc body, for fusing with the point filters around it */
+static const char* fuse_source =
+"float cmax = max (v.x, max (v.y, v.z));                        \n"
+"float cmin = min (v.x, min (v.y, v.z));                        \n"
+"float inv  = 1.0f - cmax;                                      \n"
+"if (cmax == 0.0f || cmax - cmin == 0.0f)                       \n"
+"  v.xyz = inv;                                                 \n"
+"else if (cmax == v.x)                                          \n"
+"  v.xyz = (float3) (inv, inv * v.y / cmax, inv * v.z / cmax);  \n"
+"else if (cmax == v.y)                                          \n"
+"  v.xyz = (float3) (inv * v.x / cmax, inv, inv * v.z / cmax);  \n"
+"else                                                           \n"
+"  v.xyz = (float3) (inv * v.x / cmax, inv * v.y / cmax, inv);  \n";
+
 
 static void
 gegl_chant_class_init (GeglChantClass *klass)
@@ -243,6 +257,7 @@ gegl_chant_class_init (GeglChantClass *klass)
 
   point_filter_class->process = process;
   point_filter_class->cl_process           = cl_process;
+  point_filter_class->cl_fuse_source       = fuse_source;
 //  point_filter_class->cl_kernel_source     = kernel_source;
   operation_class->opencl_support = TRUE;
 
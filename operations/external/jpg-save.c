@@ -41,27 +41,34 @@ gegl_chant_boolean (grayscale, _("Grayscale"), FALSE,
 #define GEGL_CHANT_C_FILE       "jpg-save.c"
 
 #include "gegl-chant.h"
+#include <glib/gstdio.h>
 #include <stdio.h>
 #include <jpeglib.h>
 
-static gint
-gegl_buffer_export_jpg (GeglBuffer  *gegl_buffer,
-                        const gchar *path,
-                        gint         quality,
-                        gint         smoothing,
-                        gboolean     optimize,
-                        gboolean     progressive,
-                        gboolean     grayscale,
-                        gint         src_x,
-                        gint         src_y,
-                        gint         width,
-                        gint         height)
+/* a jpeg file being written from the top down, scanlines are written in
+ * as many calls as wanted
+ */
+typedef struct
 {
-  FILE *fp;
-  struct jpeg_compress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-  JSAMPROW row_pointer[1];
-  Babl *format;
+  FILE                        *fp;
+  struct jpeg_compress_struct  cinfo;
+  struct jpeg_error_mgr        jerr;
+  JSAMPROW                     row_pointer[1];
+  const Babl                  *format;
+} JpgWriter;
+
+static JpgWriter *
+jpg_writer_open (const gchar *path,
+                 gint         quality,
+                 gint         smoothing,
+                 gboolean     optimize,
+                 gboolean     progressive,
+                 gboolean     grayscale,
+                 gint         width,
+                 gint         height)
+{
+  FILE      *fp;
+  JpgWriter *writer;
 
   if (!strcmp (path, "-"))
     {
@@ -73,85 +80,136 @@ gegl_buffer_export_jpg (GeglBuffer  *gegl_buffer,
     }
   if (!fp)
     {
-      return -1;
+      return NULL;
     }
 
-  cinfo.err = jpeg_std_error (&jerr);
-  jpeg_create_compress (&cinfo);
+  writer     = g_new0 (JpgWriter, 1);
+  writer->fp = fp;
+
+  writer->cinfo.err = jpeg_std_error (&writer->jerr);
+  jpeg_create_compress (&writer->cinfo);
 
-  jpeg_stdio_dest (&cinfo, fp);
+  jpeg_stdio_dest (&writer->cinfo, fp);
 
-  cinfo.image_width = width;
-  cinfo.image_height = height;
+  writer->cinfo.image_width = width;
+  writer->cinfo.image_height = height;
 
   if (!grayscale)
     {
-      cinfo.input_components = 3;
-      cinfo.in_color_space = JCS_RGB;
+      writer->cinfo.input_components = 3;
+      writer->cinfo.in_color_space = JCS_RGB;
     }
   else
     {
-      cinfo.input_components = 1;
-      cinfo.in_color_space = JCS_GRAYSCALE;
+      writer->cinfo.input_components = 1;
+      writer->cinfo.in_color_space = JCS_GRAYSCALE;
     }
 
-  jpeg_set_defaults (&cinfo);
-  jpeg_set_quality (&cinfo, quality, TRUE);
-  cinfo.smoothing_factor = smoothing;
-  cinfo.optimize_coding = optimize;
+  jpeg_set_defaults (&writer->cinfo);
+  jpeg_set_quality (&writer->cinfo, quality, TRUE);
+  writer->cinfo.smoothing_factor = smoothing;
+  writer->cinfo.optimize_coding = optimize;
   if (progressive)
-    jpeg_simple_progression (&cinfo);
+    jpeg_simple_progression (&writer->cinfo);
 
   /* Use 1x1,1x1,1x1 MCUs and no subsampling */
-  cinfo.comp_info[0].h_samp_factor = 1;
-  cinfo.comp_info[0].v_samp_factor = 1;
+  writer->cinfo.comp_info[0].h_samp_factor = 1;
+  writer->cinfo.comp_info[0].v_samp_factor = 1;
 
   if (!grayscale)
     {
-      cinfo.comp_info[1].h_samp_factor = 1;
-      cinfo.comp_info[1].v_samp_factor = 1;
-      cinfo.comp_info[2].h_samp_factor = 1;
-      cinfo.comp_info[2].v_samp_factor = 1;
+      writer->cinfo.comp_info[1].h_samp_factor = 1;
+      writer->cinfo.comp_info[1].v_samp_factor = 1;
+      writer->cinfo.comp_info[2].h_samp_factor = 1;
+      writer->cinfo.comp_info[2].v_samp_factor = 1;
     }
 
   /* No restart markers */
-  cinfo.restart_interval = 0;
-  cinfo.restart_in_rows = 0;
+  writer->cinfo.restart_interval = 0;
+  writer->cinfo.restart_in_rows = 0;
 
-  jpeg_start_compress (&cinfo, TRUE);
+  jpeg_start_compress (&writer->cinfo, TRUE);
 
   if (!grayscale)
     {
-      format = babl_format ("R'G'B' u8");
-      row_pointer[0] = g_malloc (width * 3);
+      writer->format = babl_format ("R'G'B' u8");
+      writer->row_pointer[0] = g_malloc (width * 3);
     }
   else
     {
-      format = babl_format ("Y' u8");
-      row_pointer[0] = g_malloc (width);
+      writer->format = babl_format ("Y' u8");
+      writer->row_pointer[0] = g_malloc (width);
     }
 
-  while (cinfo.next_scanline < cinfo.image_height) {
-    GeglRectangle rect;
+  return writer;
+}
 
-    rect.x = src_x;
-    rect.y = src_y + cinfo.next_scanline;
-    rect.width = width;
-    rect.height = 1;
+/* writes the rows of rect from gegl_buffer, libjpeg keeps progressive and
+ * optimized images in memory until the file is finished, only other
+ * images are written out as they come
+ */
+static void
+jpg_writer_write (JpgWriter           *writer,
+                  GeglBuffer          *gegl_buffer,
+                  const GeglRectangle *rect)
+{
+  gint i;
+
+  for (i = 0; i < rect->height &&
+              writer->cinfo.next_scanline < writer->cinfo.image_height; i++)
+    {
+      GeglRectangle row;
 
-    gegl_buffer_get (gegl_buffer, 1.0, &rect, format,
-                     row_pointer[0], GEGL_AUTO_ROWSTRIDE);
+      row.x = rect->x;
+      row.y = rect->y + i;
+      row.width = rect->width;
+      row.height = 1;
+
+      gegl_buffer_get (gegl_buffer, 1.0, &row, writer->format,
+                       writer->row_pointer[0], GEGL_AUTO_ROWSTRIDE);
+
+      jpeg_write_scanlines (&writer->cinfo, writer->row_pointer, 1);
+    }
+}
 
-    jpeg_write_scanlines (&cinfo, row_pointer, 1);
-  }
+static void
+jpg_writer_close (JpgWriter *writer)
+{
+  if (writer->cinfo.next_scanline == writer->cinfo.image_height)
+    jpeg_finish_compress (&writer->cinfo);
+  jpeg_destroy_compress (&writer->cinfo);
 
-  jpeg_finish_compress (&cinfo);
-  jpeg_destroy_compress (&cinfo);
+  g_free (writer->row_pointer[0]);
 
-  g_free (row_pointer[0]);
+  if (stdout != writer->fp)
+    fclose (writer->fp);
 
-  if (stdout != fp)
-    fclose (fp);
+  g_free (writer);
+}
+
+static gint
+gegl_buffer_export_jpg (GeglBuffer  *gegl_buffer,
+                        const gchar *path,
+                        gint         quality,
+                        gint         smoothing,
+                        gboolean     optimize,
+                        gboolean     progressive,
+                        gboolean     grayscale,
+                        gint         src_x,
+                        gint         src_y,
+                        gint         width,
+                        gint         height)
+{
+  GeglRectangle  rect = { src_x, src_y, width, height };
+  JpgWriter     *writer;
+
+  writer = jpg_writer_open (path, quality, smoothing, optimize,
+                            progressive, grayscale, width, height);
+  if (!writer)
+    return -1;
+
+  jpg_writer_write (writer, gegl_buffer, &rect);
+  jpg_writer_close (writer);
 
   return 0;
 }
@@ -170,6 +228,49 @@ gegl_jpg_save_process (GeglOperation       *operation,
   return  TRUE;
 }
 
+static gboolean
+gegl_jpg_save_stream_begin (GeglOperation       *operation,
+                            const GeglRectangle *roi)
+{
+  GeglChantO *o = GEGL_CHANT_PROPERTIES (operation);
+
+  /* failing to open the file fails the first band */
+  o->chant_data = jpg_writer_open (o->path, o->quality, o->smoothing,
+                                   o->optimize, o->progressive, o->grayscale,
+                                   roi->width, roi->height);
+  return TRUE;
+}
+
+static gboolean
+gegl_jpg_save_stream_band (GeglOperation       *operation,
+                           GeglBuffer          *input,
+                           const GeglRectangle *band)
+{
+  GeglChantO *o = GEGL_CHANT_PROPERTIES (operation);
+
+  if (!o->chant_data)
+    return FALSE;
+
+  jpg_writer_write (o->chant_data, input, band);
+  return TRUE;
+}
+
+/* a partially written file is removed */
+static void
+gegl_jpg_save_stream_end (GeglOperation *operation,
+                          gboolean       success)
+{
+  GeglChantO *o = GEGL_CHANT_PROPERTIES (operation);
+
+  if (o->chant_data)
+    {
+      jpg_writer_close (o->chant_data);
+      if (!success && strcmp (o->path, "-"))
+        g_unlink (o->path);
+    }
+  o->chant_data = NULL;
+}
+
 
 static void
 gegl_chant_class_init (GeglChantClass *klass)
@@ -180,8 +281,11 @@ gegl_chant_class_init (GeglChantClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   sink_class      = GEGL_OPERATION_SINK_CLASS (klass);
 
-  sink_class->process    = gegl_jpg_save_process;
-  sink_class->needs_full = TRUE;
+  sink_class->process      = gegl_jpg_save_process;
+  sink_class->needs_full   = TRUE;
+  sink_class->stream_begin = gegl_jpg_save_stream_begin;
+  sink_class->stream_band  = gegl_jpg_save_stream_band;
+  sink_class->stream_end   = gegl_jpg_save_stream_end;
 
   operation_class->name        = "gegl:jpg-save";
   operation_class->categories  = "output";
@@ -36,41 +36,56 @@ gegl_chant_int    (bitdepth, _("Bitdepth"),
 #define GEGL_CHANT_C_FILE       "png-save.c"
 
 #include "gegl-chant.h"
+#include <glib/gstdio.h>
 #include <png.h>
 #include <stdio.h>
 
-/* this call is available when the png-save plug-in is loaded,
- * it might have to be dlsymed to be used?
+/* a png file being written from the top down, rows are written in as
+ * many calls as wanted
  */
-gint
-gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
-                        const gchar *path,
-                        gint         compression,
-                        gint         bd,
-                        gint         src_x,
-                        gint         src_y,
-                        gint         width,
-                        gint         height);
+typedef struct
+{
+  FILE       *fp;
+  png_struct *png;
+  png_info   *info;
+  const Babl *format;
+  guchar     *pixels;
+} PngWriter;
 
-gint
-gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
-                        const gchar *path,
-                        gint         compression,
-                        gint         bd,
-                        gint         src_x,
-                        gint         src_y,
-                        gint         width,
-                        gint         height)
+static void
+png_writer_close (PngWriter *writer,
+                  gboolean   finish)
+{
+  if (finish)
+    {
+      if (!setjmp (png_jmpbuf (writer->png)))
+        png_write_end (writer->png, writer->info);
+    }
+
+  png_destroy_write_struct (&writer->png, &writer->info);
+  g_free (writer->pixels);
+
+  if (stdout != writer->fp)
+    fclose (writer->fp);
+
+  g_free (writer);
+}
+
+static PngWriter *
+png_writer_open (const gchar *path,
+                 gint         compression,
+                 gint         bd,
+                 const Babl  *babl,
+                 gint         width,
+                 gint         height)
 {
   FILE          *fp;
-  gint           i;
+  PngWriter     *writer;
   png_struct    *png;
   png_info      *info;
-  guchar        *pixels;
   png_color_16   white;
   int            png_color_type;
   gchar          format_string[16];
-  Babl          *format;
   gint           bit_depth = 8;
 
   if (!strcmp (path, "-"))
@@ -83,14 +98,10 @@ gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
     }
   if (!fp)
     {
-      return -1;
+      return NULL;
     }
 
   {
-    const Babl *babl; /*= gegl_buffer->format;*/
-
-    g_object_get (gegl_buffer, "format", &babl, NULL);
-
     if (babl_format_get_type (babl, 0) != babl_type ("u8"))
       bit_depth = 16;
 
@@ -134,17 +145,18 @@ gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
       if (stdout != fp)
         fclose (fp);
 
-      return -1;
+      return NULL;
     }
 
   info = png_create_info_struct (png);
 
   if (setjmp (png_jmpbuf (png)))
     {
+      png_destroy_write_struct (&png, &info);
       if (stdout != fp)
         fclose (fp);
 
-      return -1;
+      return NULL;
     }
 
   png_set_compression_level (png, compression);
@@ -171,32 +183,83 @@ gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
     png_set_swap (png);
 #endif
 
-  format = babl_format (format_string);
-  pixels = g_malloc0 (width * babl_format_get_bytes_per_pixel (format));
+  writer         = g_new0 (PngWriter, 1);
+  writer->fp     = fp;
+  writer->png    = png;
+  writer->info   = info;
+  writer->format = babl_format (format_string);
+  writer->pixels = g_malloc0 (width * babl_format_get_bytes_per_pixel (writer->format));
+
+  return writer;
+}
+
+/* writes the rows of rect from gegl_buffer, returns FALSE on errors */
+static gboolean
+png_writer_write (PngWriter           *writer,
+                  GeglBuffer          *gegl_buffer,
+                  const GeglRectangle *rect)
+{
+  gint i;
+
+  if (setjmp (png_jmpbuf (writer->png)))
+    return FALSE;
 
-  for (i=0; i< height; i++)
+  for (i=0; i< rect->height; i++)
     {
-      GeglRectangle rect;
+      GeglRectangle row;
 
-      rect.x = src_x;
-      rect.y = src_y+i;
-      rect.width = width;
-      rect.height = 1;
+      row.x = rect->x;
+      row.y = rect->y+i;
+      row.width = rect->width;
+      row.height = 1;
 
-      gegl_buffer_get (gegl_buffer, 1.0, &rect, format, pixels, GEGL_AUTO_ROWSTRIDE);
+      gegl_buffer_get (gegl_buffer, 1.0, &row, writer->format,
+                       writer->pixels, GEGL_AUTO_ROWSTRIDE);
 
-      png_write_rows (png, &pixels, 1);
+      png_write_rows (writer->png, &writer->pixels, 1);
     }
 
-  png_write_end (png, info);
+  return TRUE;
+}
 
-  png_destroy_write_struct (&png, &info);
-  g_free (pixels);
+/* this call is available when the png-save plug-in is loaded,
+ * it might have to be dlsymed to be used?
+ */
+gint
+gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
+                        const gchar *path,
+                        gint         compression,
+                        gint         bd,
+                        gint         src_x,
+                        gint         src_y,
+                        gint         width,
+                        gint         height);
+
+gint
+gegl_buffer_export_png (GeglBuffer  *gegl_buffer,
+                        const gchar *path,
+                        gint         compression,
+                        gint         bd,
+                        gint         src_x,
+                        gint         src_y,
+                        gint         width,
+                        gint         height)
+{
+  GeglRectangle  rect = { src_x, src_y, width, height };
+  PngWriter     *writer;
+  const Babl    *babl; /*= gegl_buffer->format;*/
+  gboolean       success;
 
-  if (stdout != fp)
-    fclose (fp);
+  g_object_get (gegl_buffer, "format", &babl, NULL);
 
-  return 0;
+  writer = png_writer_open (path, compression, bd, babl, width, height);
+  if (!writer)
+    return -1;
+
+  success = png_writer_write (writer, gegl_buffer, &rect);
+  png_writer_close (writer, success);
+
+  return success ? 0 : -1;
 }
 
 static gboolean
@@ -212,6 +275,69 @@ gegl_png_save_process (GeglOperation       *operation,
   return  TRUE;
 }
 
+/* the state of a streamed save, the file is opened with the first band,
+ * which provides the format to write
+ */
+typedef struct
+{
+  GeglRectangle  roi;
+  PngWriter     *writer;
+} PngStream;
+
+static gboolean
+gegl_png_save_stream_begin (GeglOperation       *operation,
+                            const GeglRectangle *roi)
+{
+  GeglChantO *o      = GEGL_CHANT_PROPERTIES (operation);
+  PngStream  *stream = g_new0 (PngStream, 1);
+
+  stream->roi   = *roi;
+  o->chant_data = stream;
+  return TRUE;
+}
+
+static gboolean
+gegl_png_save_stream_band (GeglOperation       *operation,
+                           GeglBuffer          *input,
+                           const GeglRectangle *band)
+{
+  GeglChantO *o      = GEGL_CHANT_PROPERTIES (operation);
+  PngStream  *stream = o->chant_data;
+
+  if (!stream->writer)
+    {
+      const Babl *babl;
+
+      g_object_get (input, "format", &babl, NULL);
+
+      stream->writer = png_writer_open (o->path, o->compression, o->bitdepth,
+                                        babl, stream->roi.width,
+                                        stream->roi.height);
+      if (!stream->writer)
+        return FALSE;
+    }
+
+  return png_writer_write (stream->writer, input, band);
+}
+
+/* a partially written file is removed */
+static void
+gegl_png_save_stream_end (GeglOperation *operation,
+                          gboolean       success)
+{
+  GeglChantO *o      = GEGL_CHANT_PROPERTIES (operation);
+  PngStream  *stream = o->chant_data;
+
+  if (stream->writer)
+    {
+      png_writer_close (stream->writer, success);
+      if (!success && strcmp (o->path, "-"))
+        g_unlink (o->path);
+    }
+  g_free (stream);
+  o->chant_data = NULL;
+}
+
 
 static void
 gegl_chant_class_init (GeglChantClass *klass)
@@ -222,8 +348,11 @@ gegl_chant_class_init (GeglChantClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   sink_class      = GEGL_OPERATION_SINK_CLASS (klass);
 
-  sink_class->process    = gegl_png_save_process;
-  sink_class->needs_full = TRUE;
+  sink_class->process      = gegl_png_save_process;
+  sink_class->needs_full   = TRUE;
+  sink_class->stream_begin = gegl_png_save_stream_begin;
+  sink_class->stream_band  = gegl_png_save_stream_band;
+  sink_class->stream_end   = gegl_png_save_stream_end;
 
   operation_class->name        = "gegl:png-save";
   operation_class->categories  = "output";
@@ -0,0 +1,79 @@
+#include "test-common.h"
+
+/* measures the speedup of multi threaded gegl_node_blit when the cost
+ * is concentrated in a part of the image, an expensive blur covers a
+ * strip along the left edge of an otherwise cheap composition.
+ */
+
+#define SIZE       1024
+#define ITERATIONS 4
+#define THREADS    4
+
+static glong
+run (GeglNode *node,
+     gint      threads,
+     gfloat   *buf)
+{
+  GeglRectangle roi = {0, 0, SIZE, SIZE};
+  long          ticks;
+  gchar        *id;
+  gint          i;
+
+  g_object_set (gegl_config (), "threads", threads, NULL);
+
+  id = g_strdup_printf ("blit-skewed-%i-threads", threads);
+  test_start ();
+  ticks = babl_ticks ();
+  for (i = 0; i < ITERATIONS; i++)
+    gegl_node_blit (node, 1.0, &roi, babl_format ("RGBA float"), buf,
+                    GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+  ticks = babl_ticks () - ticks;
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * 16);
+  g_free (id);
+
+  return ticks;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer;
+  GeglNode   *gegl, *source, *blur, *crop, *over;
+  gfloat     *buf;
+  glong       serial, parallel;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+  buf    = g_malloc (SIZE * SIZE * 16);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl, "operation", "gegl:buffer-source",
+                                "buffer", buffer, NULL);
+  blur   = gegl_node_new_child (gegl, "operation", "gegl:gaussian-blur",
+                                "std-dev-x", 20.0,
+                                "std-dev-y", 20.0,
+                                NULL);
+  crop   = gegl_node_new_child (gegl, "operation", "gegl:crop",
+                                "x", 0.0, "y", 0.0,
+                                "width", SIZE / 4.0, "height", (gdouble) SIZE,
+                                NULL);
+  over   = gegl_node_new_child (gegl, "operation", "gegl:over", NULL);
+
+  gegl_node_link_many (source, blur, crop, NULL);
+  gegl_node_connect_to (source, "output", over, "input");
+  gegl_node_connect_to (crop, "output", over, "aux");
+
+  serial   = run (over, 1, buf);
+  parallel = run (over, THREADS, buf);
+  g_print ("@ blit-skewed-speedup: %.2f times faster with %i threads\n",
+           serial / (gdouble) parallel, THREADS);
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+  g_free (buf);
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include "test-common.h"
+
+/* creates, writes and destroys many small buffers while a large buffer
+ * keeps a lot of tiles in the cache, the way area filters produce
+ * temporary buffers during a render.
+ */
+
+#define ITERATIONS 4000
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer    *buffer;
+  GeglRectangle  small = {0, 0, 64, 64};
+  gfloat        *buf;
+  gint           i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (2048, 2048, babl_format ("RGBA float"));
+  buf = g_malloc0 (small.width * small.height * 16);
+
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      GeglBuffer *temp = gegl_buffer_new (&small, babl_format ("RGBA float"));
+
+      gegl_buffer_set (temp, &small, NULL, buf, GEGL_AUTO_ROWSTRIDE);
+      g_object_unref (temp);
+    }
+  test_end ("buffer-create-destroy", (glong) small.width * small.height * 16 * ITERATIONS);
+
+  g_free (buf);
+  g_object_unref (buffer);
+
+  return 0;
+}
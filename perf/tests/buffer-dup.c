@@ -0,0 +1,43 @@
+#include "test-common.h"
+
+/* measures duplicating and copying large buffers, with tile aligned
+ * rectangles the tiles are shared copy on write instead of copying
+ * pixels.
+ */
+
+#define SIZE       4096
+#define ITERATIONS 16
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer    *buffer;
+  GeglBuffer    *copy;
+  GeglRectangle  bound = {0, 0, SIZE, SIZE};
+  gint           i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      copy = gegl_buffer_dup (buffer);
+      g_object_unref (copy);
+    }
+  test_end ("buffer-dup", (glong) ITERATIONS * SIZE * SIZE * 16);
+
+  copy = gegl_buffer_new (&bound, babl_format ("RGBA float"));
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    gegl_buffer_copy (buffer, NULL, copy, NULL);
+  test_end ("buffer-copy", (glong) ITERATIONS * SIZE * SIZE * 16);
+  g_object_unref (copy);
+
+  g_object_unref (buffer);
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include "test-common.h"
+
+/* measures the throughput of OpenCL point filters on results that don't
+ * line up with the tile grid, which are sent to the device in bands.
+ * Rendered in a single band nothing overlaps, with small bands un-tiling
+ * and tiling on the cpu overlap with the device processing the band
+ * before. Runs on any OpenCL runtime, cpu ones like POCL included.
+ */
+
+#define SIZE       1000
+#define ITERATIONS 8
+
+static glong
+run (GeglBuffer *buffer,
+     gint        chunk_size)
+{
+  GeglBuffer *buffer2;
+  GeglNode   *gegl, *sink;
+  long        ticks;
+  gchar      *id;
+  gint        i;
+
+  g_object_set (gegl_config (), "chunk-size", chunk_size, NULL);
+
+  id = g_strdup_printf ("cl-pipeline-%i-pixel-bands", chunk_size);
+  test_start ();
+  ticks = babl_ticks ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      gegl = gegl_graph (sink = gegl_node ("gegl:buffer-sink", "buffer", &buffer2, NULL,
+                                gegl_node ("gegl:levels", "out-high", 0.8, NULL,
+                                gegl_node ("gegl:brightness-contrast", "contrast", 0.2, NULL,
+                                gegl_node ("gegl:buffer-source", "buffer", buffer, NULL)))));
+
+      gegl_node_process (sink);
+      g_object_unref (gegl);
+      g_object_unref (buffer2);
+    }
+  ticks = babl_ticks () - ticks;
+  test_end (id, gegl_buffer_get_pixel_count (buffer) * 16 * ITERATIONS);
+  g_free (id);
+
+  return ticks;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer;
+  glong       single, banded;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+
+  single = run (buffer, SIZE * SIZE);
+  banded = run (buffer, 128 * 128);
+  g_print ("@ cl-pipeline-speedup: %.2f times faster in bands\n",
+           single / (gdouble) banded);
+
+  g_object_unref (buffer);
+
+  return 0;
+}
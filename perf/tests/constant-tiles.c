@@ -0,0 +1,52 @@
+#include "test-common.h"
+
+/* measures reading a buffer of uniform content, the tiles share their
+ * data and reads fill the destination instead of converting every pixel.
+ */
+
+#define SIZE       4096
+#define ITERATIONS 4
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer    *buffer;
+  GeglRectangle  bound = {0, 0, SIZE, SIZE};
+  gfloat        *buf;
+  guchar        *buf8;
+  gint           i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buf  = g_malloc (SIZE * SIZE * 16);
+  buf8 = g_malloc (SIZE * SIZE * 4);
+  for (i = 0; i < SIZE * SIZE; i++)
+    {
+      buf[i * 4 + 0] = 0.2;
+      buf[i * 4 + 1] = 0.4;
+      buf[i * 4 + 2] = 0.6;
+      buf[i * 4 + 3] = 1.0;
+    }
+
+  buffer = gegl_buffer_new (&bound, babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, NULL, babl_format ("RGBA float"), buf, GEGL_AUTO_ROWSTRIDE);
+
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    gegl_buffer_get (buffer, 1.0, NULL, babl_format ("R'G'B'A u8"), buf8,
+                     GEGL_AUTO_ROWSTRIDE);
+  test_end ("constant-tiles-get", (glong) ITERATIONS * SIZE * SIZE * 16);
+
+  test_start ();
+  for (i = 0; i < ITERATIONS; i++)
+    gegl_buffer_clear (buffer, NULL);
+  test_end ("constant-tiles-clear", (glong) ITERATIONS * SIZE * SIZE * 16);
+
+  g_object_unref (buffer);
+  g_free (buf8);
+  g_free (buf);
+
+  return 0;
+}
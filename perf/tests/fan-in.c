@@ -0,0 +1,102 @@
+#include "test-common.h"
+
+/* measures the speedup of evaluating the independent branches of a wide
+ * fan-in graph concurrently, differently blurred copies of a source are
+ * stacked with gegl:over and rendered one tile at a time, like an
+ * interactive client requesting the tiles it displays would.
+ */
+
+#define SIZE       512
+#define BRANCHES   8
+#define ITERATIONS 2
+#define THREADS    4
+
+static glong
+run (GeglNode *node,
+     gint      threads,
+     gfloat   *buf)
+{
+  gint   tile_width  = gegl_config ()->tile_width;
+  gint   tile_height = gegl_config ()->tile_height;
+  long   ticks;
+  gchar *id;
+  gint   i, x, y;
+
+  g_object_set (gegl_config (), "threads", threads, NULL);
+
+  id = g_strdup_printf ("fan-in-%i-threads", threads);
+  test_start ();
+  ticks = babl_ticks ();
+  for (i = 0; i < ITERATIONS; i++)
+    for (y = 0; y < SIZE; y += tile_height)
+      for (x = 0; x < SIZE; x += tile_width)
+        {
+          GeglRectangle roi = {x, y, tile_width, tile_height};
+
+          gegl_node_blit (node, 1.0, &roi, babl_format ("RGBA float"), buf,
+                          GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+        }
+  ticks = babl_ticks () - ticks;
+  test_end (id, (glong) ITERATIONS * SIZE * SIZE * 16);
+  g_free (id);
+
+  return ticks;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer;
+  GeglNode   *gegl, *source, *top = NULL;
+  gfloat     *buf;
+  glong       serial, parallel;
+  gint        i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+  buf    = g_malloc (gegl_config ()->tile_width * gegl_config ()->tile_height * 16);
+
+  gegl   = gegl_node_new ();
+  source = gegl_node_new_child (gegl, "operation", "gegl:buffer-source",
+                                "buffer", buffer, NULL);
+
+  for (i = 0; i < BRANCHES; i++)
+    {
+      GeglNode *blur = gegl_node_new_child (gegl,
+                                            "operation", "gegl:gaussian-blur",
+                                            "std-dev-x", 2.0 + i,
+                                            "std-dev-y", 2.0 + i,
+                                            NULL);
+
+      gegl_node_connect_to (source, "output", blur, "input");
+
+      if (top)
+        {
+          GeglNode *over = gegl_node_new_child (gegl,
+                                                "operation", "gegl:over",
+                                                NULL);
+
+          gegl_node_connect_to (top, "output", over, "input");
+          gegl_node_connect_to (blur, "output", over, "aux");
+          top = over;
+        }
+      else
+        {
+          top = blur;
+        }
+    }
+
+  serial   = run (top, 1, buf);
+  parallel = run (top, THREADS, buf);
+  g_print ("@ fan-in-speedup: %.2f times faster with %i threads\n",
+           serial / (gdouble) parallel, THREADS);
+
+  g_object_unref (gegl);
+  g_object_unref (buffer);
+  g_free (buf);
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "test-common.h"
+
+/* measures swap throughput and the disk space used by swap files, with
+ * and without tile compression, for a buffer much larger than the tile
+ * cache consisting of flat regions, an opaque alpha plane and some noise.
+ */
+
+#define SIZE       2048
+#define CACHE_SIZE (8 * 1024 * 1024)
+
+static void
+fill (gfloat *buf)
+{
+  gint x, y;
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        gfloat *pixel = buf + (y * SIZE + x) * 4;
+
+        if (x >= SIZE / 4 * 3)
+          {
+            pixel[0] = g_random_double_range (0.0, 1.0);
+            pixel[1] = g_random_double_range (0.0, 1.0);
+            pixel[2] = g_random_double_range (0.0, 1.0);
+          }
+        else
+          {
+            pixel[0] = (x / 256) / 8.0;
+            pixel[1] = (y / 256) / 8.0;
+            pixel[2] = 0.5;
+          }
+        pixel[3] = 1.0;
+      }
+}
+
+/* the disk blocks used by swap files of this process */
+static glong
+swap_footprint (void)
+{
+  const gchar *name;
+  gchar       *prefix;
+  glong        bytes = 0;
+  GDir        *dir;
+
+  if (!gegl_config ()->swap)
+    return 0;
+
+  dir = g_dir_open (gegl_config ()->swap, 0, NULL);
+  if (!dir)
+    return 0;
+
+  prefix = g_strdup_printf ("%i-", getpid ());
+  while ((name = g_dir_read_name (dir)))
+    if (g_str_has_prefix (name, prefix))
+      {
+        gchar       *path = g_build_filename (gegl_config ()->swap, name, NULL);
+        struct stat  st;
+
+        if (stat (path, &st) == 0)
+          bytes += st.st_blocks * 512;
+        g_free (path);
+      }
+  g_free (prefix);
+  g_dir_close (dir);
+
+  return bytes;
+}
+
+static void
+run (const gchar *id,
+     const gchar *format,
+     gboolean     compression,
+     gfloat      *buf)
+{
+  GeglRectangle  bound = {0, 0, SIZE, SIZE};
+  GeglBuffer    *buffer;
+  glong          before;
+  gchar         *name;
+
+  g_object_set (gegl_config (), "swap-compression", compression, NULL);
+  before = swap_footprint ();
+
+  buffer = gegl_buffer_new (&bound, babl_format (format));
+
+  test_start ();
+  gegl_buffer_set (buffer, NULL, babl_format (format), buf, GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_get (buffer, 1.0, NULL, babl_format (format), buf, GEGL_AUTO_ROWSTRIDE);
+  test_end (id, (glong) SIZE * SIZE * 16 * 2);
+
+  name = g_strdup_printf ("%s-footprint", id);
+  g_print ("@ %s: %.2f megabytes on disk\n", name,
+           (swap_footprint () - before) / 1024.0 / 1024.0);
+  g_free (name);
+
+  g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gfloat *buf;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+  g_object_set (gegl_config (), "cache-size", CACHE_SIZE, NULL);
+
+  buf = g_malloc (SIZE * SIZE * 16);
+  fill (buf);
+
+  /* swap storages are reused per format, so each run uses its own
+   * format with the same pixel size to get a storage created with the
+   * desired compression setting
+   */
+  run ("swap-uncompressed", "RGBA float", FALSE, buf);
+  fill (buf);
+  run ("swap-compressed", "RaGaBaA float", TRUE, buf);
+
+  g_free (buf);
+  return 0;
+}
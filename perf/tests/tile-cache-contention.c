@@ -0,0 +1,56 @@
+#include "test-common.h"
+
+/* measures throughput of cache hits with several threads fetching tiles
+ * at the same time, each thread uses its own buffer so the only shared
+ * state is the global tile cache.
+ */
+
+#define THREADS    8
+#define ITERATIONS 20000
+#define SIZE       512
+
+static gpointer
+fetch_tiles (gpointer data)
+{
+  GeglBuffer    *buffer = data;
+  GeglRectangle  roi    = {0, 0, 64, 64};
+  gfloat        *buf    = g_malloc (roi.width * roi.height * 16);
+  gint           i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      roi.x = g_random_int_range (0, SIZE / 64) * 64;
+      roi.y = g_random_int_range (0, SIZE / 64) * 64;
+      gegl_buffer_get (buffer, 1.0, &roi, NULL, buf, GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (buf);
+  return NULL;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffers[THREADS];
+  GThread    *threads[THREADS];
+  gint        i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  for (i = 0; i < THREADS; i++)
+    buffers[i] = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+
+  test_start ();
+  for (i = 0; i < THREADS; i++)
+    threads[i] = g_thread_create (fetch_tiles, buffers[i], TRUE, NULL);
+  for (i = 0; i < THREADS; i++)
+    g_thread_join (threads[i]);
+  test_end ("tile-cache-contention", (glong) THREADS * ITERATIONS * 64 * 64 * 16);
+
+  for (i = 0; i < THREADS; i++)
+    g_object_unref (buffers[i]);
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+TEST ()
+{
+  GeglBuffer    *buffer, *buffer2;
+  GeglRectangle  bound = {0, 0, 1, 1};
+  GeglRectangle  pixel = {0, 0, 1, 1};
+  gint           tile_width, tile_height;
+  gfloat         a, b;
+  test_start ();
+  buffer = gegl_buffer_new (&bound, babl_format ("Y float"));
+  g_object_get (buffer, "tile-width", &tile_width,
+                        "tile-height", &tile_height,
+                        NULL);
+
+  /* whole tiles, so the copy shares them instead of converting pixels */
+  bound.width  = tile_width * 2;
+  bound.height = tile_height * 2;
+  gegl_buffer_set_extent (buffer, &bound);
+  buffer2 = gegl_buffer_new (&bound, babl_format ("Y float"));
+
+#define print_pixels(what) \
+  gegl_buffer_get (buffer, 1.0, &pixel, babl_format ("Y float"), &a, 0); \
+  gegl_buffer_get (buffer2, 1.0, &pixel, babl_format ("Y float"), &b, 0); \
+  print (("%s: source %.2f copy %.2f\n", what, a, b));
+
+  fill (buffer, 0.5);
+  gegl_buffer_copy (buffer, &bound, buffer2, &bound);
+  pixel.x = tile_width + 1;
+  pixel.y = tile_height + 1;
+  print_pixels ("copied");
+
+  fill (buffer, 1.0);
+  print_pixels ("source written");
+
+  fill_rect (buffer2, &bound, 0.25);
+  pixel.x = 0;
+  pixel.y = 0;
+  print_pixels ("copy written");
+
+#undef print_pixels
+
+  gegl_buffer_destroy (buffer);
+  gegl_buffer_destroy (buffer2);
+  test_end ();
+}
@@ -0,0 +1,42 @@
+TEST ()
+{
+  GeglBuffer    *buffer, *buffer2, *sub;
+  GeglRectangle  bound = {0, 0, 1, 1};
+  GeglRectangle  pixel = {1, 1, 1, 1};
+  gint           tile_width, tile_height;
+  gfloat         a, b;
+  test_start ();
+  buffer = gegl_buffer_new (&bound, babl_format ("Y float"));
+  g_object_get (buffer, "tile-width", &tile_width,
+                        "tile-height", &tile_height,
+                        NULL);
+
+  /* whole tiles, so that copy and clear replace the cached tiles */
+  bound.width  = tile_width * 2;
+  bound.height = tile_height * 2;
+  gegl_buffer_set_extent (buffer, &bound);
+  buffer2 = gegl_buffer_new (&bound, babl_format ("Y float"));
+  sub = gegl_buffer_create_sub_buffer (buffer, &bound);
+
+#define print_pixels(what) \
+  gegl_buffer_get (buffer, 1.0, &pixel, babl_format ("Y float"), &a, 0); \
+  gegl_buffer_get (sub, 1.0, &pixel, babl_format ("Y float"), &b, 0); \
+  print (("%s: buffer %.2f sub-buffer %.2f\n", what, a, b));
+
+  fill (buffer, 0.5);
+  fill (buffer2, 1.0);
+  print_pixels ("filled");
+
+  gegl_buffer_copy (buffer2, &bound, buffer, &bound);
+  print_pixels ("copied");
+
+  gegl_buffer_clear (buffer, &bound);
+  print_pixels ("cleared");
+
+#undef print_pixels
+
+  gegl_buffer_destroy (sub);
+  gegl_buffer_destroy (buffer);
+  gegl_buffer_destroy (buffer2);
+  test_end ();
+}
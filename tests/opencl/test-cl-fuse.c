@@ -0,0 +1,152 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Renders a chain of point filters that are fused into a single OpenCL
+ * kernel and checks that every pixel matches rendering the chain on the
+ * cpu.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <babl/babl.h>
+
+#include "gegl.h"
+#include "gegl-cl-init.h"
+#include "gegl-cl-pool.h"
+
+
+#define SUCCESS 0
+#define FAILURE (-1)
+
+#define SIZE      256
+#define TOLERANCE 0.0001
+
+/* the OpenCL buffers allocated so far, every device path allocates them
+ * from the pool */
+static gint
+device_allocations (void)
+{
+  gint hits;
+  gint misses;
+
+  gegl_cl_pool_get_stats (&hits, &misses, NULL);
+  return hits + misses;
+}
+
+static GeglBuffer *
+create_input (void)
+{
+  GeglRectangle  rect   = { 0, 0, SIZE, SIZE };
+  GeglBuffer    *buffer = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  gfloat        *data   = g_new (gfloat, SIZE * SIZE * 4);
+  gint           i;
+
+  for (i = 0; i < SIZE * SIZE; i++)
+    {
+      data[i * 4 + 0] = (i % SIZE) / (gfloat) SIZE;
+      data[i * 4 + 1] = (i / SIZE) / (gfloat) SIZE;
+      data[i * 4 + 2] = (i % 7) / 7.0;
+      data[i * 4 + 3] = (i % 3) / 2.0;
+    }
+  gegl_buffer_set (buffer, &rect, babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE);
+  g_free (data);
+
+  return buffer;
+}
+
+static void
+render (GeglBuffer *input,
+        gboolean    use_opencl,
+        gfloat     *result)
+{
+  GeglRectangle  rect = { 0, 0, SIZE, SIZE };
+  GeglNode      *graph;
+  GeglNode      *levels;
+
+  g_object_set (gegl_config (), "use-opencl", use_opencl, NULL);
+
+  graph = gegl_graph (levels = gegl_node ("gegl:levels",
+                                          "in-low", 0.1, "in-high", 0.9,
+                                          "out-low", 0.05, "out-high", 0.95, NULL,
+                               gegl_node ("gegl:value-invert", NULL,
+                               gegl_node ("gegl:invert", NULL,
+                               gegl_node ("gegl:brightness-contrast",
+                                          "brightness", 0.1, "contrast", 0.8, NULL,
+                               gegl_node ("gegl:buffer-source", "buffer", input, NULL))))));
+
+  gegl_node_blit (levels, 1.0, &rect, babl_format ("RGBA float"), result,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gint        retval = SUCCESS;
+  gint        n      = SIZE * SIZE * 4;
+  gfloat     *cpu    = g_new (gfloat, n);
+  gfloat     *device = g_new (gfloat, n);
+  GeglBuffer *input;
+  gint        allocations;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  input = create_input ();
+
+  allocations = device_allocations ();
+  render (input, FALSE, cpu);
+  if (device_allocations () != allocations)
+    {
+      printf ("the cpu render used the OpenCL device\n");
+      retval = FAILURE;
+    }
+
+  allocations = device_allocations ();
+  render (input, TRUE, device);
+
+  if (!cl_status.is_opencl_available)
+    {
+      printf ("OpenCL is not available, skipping\n");
+    }
+  else if (device_allocations () == allocations)
+    {
+      printf ("the OpenCL render didn't use the device\n");
+      retval = FAILURE;
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        if (fabs (cpu[i] - device[i]) > TOLERANCE)
+          {
+            printf ("pixel %i of the fused chain differs: %f != %f\n",
+                    i / 4, device[i], cpu[i]);
+            retval = FAILURE;
+            break;
+          }
+    }
+
+  g_object_unref (input);
+  g_free (cpu);
+  g_free (device);
+
+  gegl_exit ();
+
+  return retval;
+}
@@ -0,0 +1,103 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+#include "graph/gegl-node.h"
+
+
+#define ADD_TEST(function) g_test_add_func ("/invalidate-setup/" #function, function);
+
+/* branches that join again, every node downstream is reached by
+ * 2^DIAMONDS paths
+ */
+#define DIAMONDS 12
+
+
+static void
+render_pixel (GeglNode *node)
+{
+  GeglRectangle pixel = { 0, 0, 1, 1 };
+  gfloat        value[4];
+
+  gegl_node_blit (node, 1.0, &pixel, babl_format ("RGBA float"), value,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+}
+
+/**
+ * Tests that changing a property upstream of a chain of diamonds,
+ * branches that join again, gets the downstream nodes prepared again
+ * with an updated bounding box.
+ **/
+static void
+property_change (void)
+{
+  GeglNode      *graph = gegl_node_new ();
+  GeglNode      *crop;
+  GeglNode      *last;
+  GeglRectangle  bbox;
+  gint           i;
+
+  crop = gegl_node_new_child (graph, "operation", "gegl:crop",
+                              "width",  10.0,
+                              "height", 10.0,
+                              NULL);
+  gegl_node_link (gegl_node_new_child (graph, "operation", "gegl:color", NULL),
+                  crop);
+
+  last = crop;
+  for (i = 0; i < DIAMONDS; i++)
+    {
+      GeglNode *a    = gegl_node_new_child (graph, "operation", "gegl:invert", NULL);
+      GeglNode *b    = gegl_node_new_child (graph, "operation", "gegl:invert", NULL);
+      GeglNode *over = gegl_node_new_child (graph, "operation", "gegl:over", NULL);
+
+      gegl_node_link (last, a);
+      gegl_node_link (last, b);
+      gegl_node_connect_to (a, "output", over, "input");
+      gegl_node_connect_to (b, "output", over, "aux");
+      last = over;
+    }
+
+  render_pixel (last);
+  g_assert (last->valid_prepare);
+  bbox = gegl_node_get_bounding_box (last);
+  g_assert_cmpint (bbox.width, ==, 10);
+
+  gegl_node_set (crop, "width", 20.0, NULL);
+  g_assert (!last->valid_prepare);
+  bbox = gegl_node_get_bounding_box (last);
+  g_assert_cmpint (bbox.width, ==, 20);
+
+  render_pixel (last);
+  g_assert (last->valid_prepare);
+
+  g_object_unref (graph);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  gegl_init (&argc, &argv);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (property_change);
+
+  return g_test_run ();
+}
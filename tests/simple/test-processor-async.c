@@ -0,0 +1,202 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gegl.h"
+
+
+#define ADD_TEST(function) g_test_add_func ("/processor-async/" #function, function);
+
+#define SIZE  512
+
+/* small chunks make a render take many steps of the main loop */
+#define CHUNK (64 * 64)
+
+
+typedef struct
+{
+  GMainLoop     *loop;
+  GCancellable  *cancellable;
+  guchar        *computed;   /* SIZE×SIZE, set for every pixel computed */
+  gint           n_computed; /* the number of "computed" emissions */
+  GeglRectangle  first;      /* the first rectangle computed */
+  gboolean       finished;
+  GError        *error;
+} Render;
+
+static GeglNode *
+create_graph (GeglNode **crop)
+{
+  GeglNode *graph = gegl_node_new ();
+  GeglNode *color = gegl_node_new_child (graph, "operation", "gegl:color", NULL);
+
+  *crop = gegl_node_new_child (graph, "operation", "gegl:crop",
+                               "width",  (gdouble) SIZE,
+                               "height", (gdouble) SIZE,
+                               NULL);
+  gegl_node_link (color, *crop);
+
+  return graph;
+}
+
+static void
+computed_cb (GeglProcessor *processor,
+             GeglRectangle *rect,
+             Render        *render)
+{
+  GeglRectangle bounds = { 0, 0, SIZE, SIZE };
+  GeglRectangle clipped;
+  gint          y;
+
+  if (render->n_computed++ == 0)
+    render->first = *rect;
+
+  if (gegl_rectangle_intersect (&clipped, rect, &bounds))
+    for (y = clipped.y; y < clipped.y + clipped.height; y++)
+      memset (render->computed + y * SIZE + clipped.x, 1, clipped.width);
+
+  if (render->cancellable)
+    g_cancellable_cancel (render->cancellable);
+}
+
+static void
+finished_cb (GObject      *source,
+             GAsyncResult *result,
+             gpointer      data)
+{
+  Render *render = data;
+
+  render->finished = gegl_processor_render_finish (GEGL_PROCESSOR (source),
+                                                   result, &render->error);
+  g_main_loop_quit (render->loop);
+}
+
+/* renders SIZE×SIZE pixels from the main loop, after prioritizing
+ * priority when it is given
+ */
+static void
+run (Render              *render,
+     const GeglRectangle *priority)
+{
+  GeglRectangle  roi = { 0, 0, SIZE, SIZE };
+  GeglNode      *crop;
+  GeglNode      *graph = create_graph (&crop);
+  GeglProcessor *processor;
+
+  render->loop     = g_main_loop_new (NULL, FALSE);
+  render->computed = g_malloc0 (SIZE * SIZE);
+
+  processor = g_object_new (GEGL_TYPE_PROCESSOR,
+                            "node",      crop,
+                            "rectangle", &roi,
+                            "chunksize", CHUNK,
+                            NULL);
+  g_signal_connect (processor, "computed", G_CALLBACK (computed_cb), render);
+  if (priority)
+    gegl_processor_prioritize (processor, priority);
+
+  gegl_processor_render_async (processor, G_PRIORITY_DEFAULT_IDLE,
+                               render->cancellable, finished_cb, render);
+  g_main_loop_run (render->loop);
+
+  gegl_processor_destroy (processor);
+  g_object_unref (graph);
+  g_main_loop_unref (render->loop);
+}
+
+static void
+render_clear (Render *render)
+{
+  g_free (render->computed);
+  g_clear_error (&render->error);
+  if (render->cancellable)
+    g_object_unref (render->cancellable);
+}
+
+/**
+ * Tests that a render runs to completion from the main loop and that
+ * the "computed" rectangles cover the whole area.
+ **/
+static void
+complete (void)
+{
+  Render render = { 0, };
+  gint   i;
+
+  run (&render, NULL);
+
+  g_assert (render.finished);
+  g_assert_no_error (render.error);
+  for (i = 0; i < SIZE * SIZE; i++)
+    g_assert (render.computed[i]);
+
+  render_clear (&render);
+}
+
+/**
+ * Tests that a render cancelled part-way reports G_IO_ERROR_CANCELLED.
+ **/
+static void
+cancel (void)
+{
+  Render render = { 0, };
+
+  render.cancellable = g_cancellable_new ();
+  run (&render, NULL);
+
+  g_assert (!render.finished);
+  g_assert_error (render.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_cmpint (render.n_computed, ==, 1);
+  g_assert (!render.computed[SIZE * SIZE - 1]);
+
+  render_clear (&render);
+}
+
+/**
+ * Tests that a prioritized rectangle is computed before the rest.
+ **/
+static void
+prioritize (void)
+{
+  GeglRectangle priority = { SIZE / 2, SIZE / 2, 64, 64 };
+  Render        render   = { 0, };
+
+  run (&render, &priority);
+
+  g_assert (render.finished);
+  g_assert (gegl_rectangle_contains (&priority, &render.first));
+
+  render_clear (&render);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  gegl_init (&argc, &argv);
+  g_test_init (&argc, &argv, NULL);
+
+  /* one fragment per step, so a step computes a single rectangle */
+  g_object_set (gegl_config (), "threads", 1, NULL);
+
+  ADD_TEST (complete);
+  ADD_TEST (cancel);
+  ADD_TEST (prioritize);
+
+  return g_test_run ();
+}
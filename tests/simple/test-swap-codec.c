@@ -0,0 +1,218 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <glib/gstdio.h>
+#include <gegl.h>
+#include <gegl-buffer-backend.h>
+#include "gegl-buffer-index.h"
+#include "gegl-tile-backend-file.h"
+
+
+#define ADD_TEST(function) g_test_add_func ("/swap-codec/" #function, function);
+
+#define TILE_WIDTH  64
+#define TILE_HEIGHT 64
+#define PX_SIZE     4
+#define N_PIXELS    (TILE_WIDTH * TILE_HEIGHT)
+#define TILE_SIZE   (N_PIXELS * PX_SIZE)
+
+
+static gchar *
+temp_path (const gchar *name)
+{
+  gchar *path = g_build_filename (g_get_tmp_dir (), name, NULL);
+
+  g_unlink (path);
+  return path;
+}
+
+static void
+set_pixel (guchar *data,
+           gint    i,
+           guint32 value)
+{
+  memcpy (data + i * PX_SIZE, &value, PX_SIZE);
+}
+
+/* stores data in a compressing file backend and reads it back, returns
+ * the bytes of the file the stored tile occupies
+ */
+static guint64
+round_trip (const guchar *data)
+{
+  GeglTileBackend *backend;
+  GeglTile        *tile;
+  guint64          before;
+  guint64          after;
+  gchar           *path = temp_path ("test-swap-codec.swap");
+
+  backend = g_object_new (GEGL_TYPE_TILE_BACKEND_FILE,
+                          "tile-width",  TILE_WIDTH,
+                          "tile-height", TILE_HEIGHT,
+                          "format",      babl_format ("RGBA u8"),
+                          "path",        path,
+                          "compression", TRUE,
+                          NULL);
+
+  gegl_tile_backend_file_get_stats (GEGL_TILE_BACKEND_FILE (backend),
+                                    &before, NULL);
+
+  tile = gegl_tile_new (TILE_SIZE);
+  memcpy (gegl_tile_get_data (tile), data, TILE_SIZE);
+  gegl_tile_source_set_tile (GEGL_TILE_SOURCE (backend), 0, 0, 0, tile);
+  gegl_tile_unref (tile);
+
+  gegl_tile_backend_file_get_stats (GEGL_TILE_BACKEND_FILE (backend),
+                                    &after, NULL);
+
+  tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (backend), 0, 0, 0);
+  g_assert (tile);
+  g_assert (memcmp (gegl_tile_get_data (tile), data, TILE_SIZE) == 0);
+  gegl_tile_unref (tile);
+
+  g_object_unref (backend);
+  g_unlink (path);
+  g_free (path);
+
+  return after - before;
+}
+
+/**
+ * Tests that a tile of a single repeated pixel survives being stored
+ * as that pixel.
+ **/
+static void
+constant_tile (void)
+{
+  guchar data[TILE_SIZE];
+  gint   i;
+
+  for (i = 0; i < N_PIXELS; i++)
+    set_pixel (data, i, 0xff1e140a);
+
+  g_assert_cmpuint (round_trip (data), <, TILE_SIZE);
+}
+
+/**
+ * Tests that runs longer than a single run code can hold, 129 pixels,
+ * are split and restored, also when mixed with literal pixels.
+ **/
+static void
+long_runs (void)
+{
+  guchar data[TILE_SIZE];
+  gint   i;
+
+  for (i = 0; i < N_PIXELS; i++)
+    {
+      if (i % 1000 < 300)
+        set_pixel (data, i, 0xff000000 | (i / 1000));
+      else if (i % 1000 < 430)
+        set_pixel (data, i, 0xff000000 | i);
+      else
+        set_pixel (data, i, 0x80ffffff);
+    }
+
+  g_assert_cmpuint (round_trip (data), <, TILE_SIZE);
+}
+
+/**
+ * Tests that a tile the run length encoding would grow is stored raw.
+ **/
+static void
+incompressible_tile (void)
+{
+  guchar data[TILE_SIZE];
+  gint   i;
+
+  g_random_set_seed (42);
+  for (i = 0; i < N_PIXELS; i++)
+    set_pixel (data, i, (g_random_int () & ~0xff) | (i & 0xff));
+
+  g_assert_cmpuint (round_trip (data), ==, TILE_SIZE);
+}
+
+/**
+ * Tests that a file whose index entries predate the size and codec
+ * fields of GeglBufferTile is read as full uncompressed tiles.
+ **/
+static void
+old_index (void)
+{
+  GeglBufferHeader header  = { { 0, }, };
+  GeglBufferTile   entry   = { { 0, }, };
+  GeglRectangle    rect    = { 0, 0, TILE_WIDTH, TILE_HEIGHT };
+  guint32          old_len = sizeof (GeglBufferTile) - 2 * sizeof (guint32);
+  guchar           data[TILE_SIZE];
+  guchar           result[TILE_SIZE];
+  GeglBuffer      *buffer;
+  gchar           *path = temp_path ("test-swap-codec.gegl");
+  gint             fd;
+  gint             i;
+
+  for (i = 0; i < N_PIXELS; i++)
+    set_pixel (data, i, 0xff000000 | (i / 7));
+
+  memcpy (header.magic, "GEGL", 4);
+  header.flags           = GEGL_FLAG_HEADER;
+  header.next            = sizeof (GeglBufferHeader);
+  header.tile_width      = TILE_WIDTH;
+  header.tile_height     = TILE_HEIGHT;
+  header.bytes_per_pixel = PX_SIZE;
+  header.width           = TILE_WIDTH;
+  header.height          = TILE_HEIGHT;
+  g_strlcpy (header.description, "RGBA u8", sizeof (header.description));
+
+  entry.block.length = old_len;
+  entry.block.flags  = GEGL_FLAG_TILE;
+  entry.block.next   = 0;
+  entry.offset       = sizeof (GeglBufferHeader) + old_len;
+
+  fd = open (path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  g_assert (fd != -1);
+  g_assert (write (fd, &header, sizeof (header)) == sizeof (header));
+  g_assert (write (fd, &entry, old_len) == (gssize) old_len);
+  g_assert (write (fd, data, TILE_SIZE) == TILE_SIZE);
+  close (fd);
+
+  buffer = gegl_buffer_open (path);
+  gegl_buffer_get (buffer, 1.0, &rect, babl_format ("RGBA u8"), result,
+                   GEGL_AUTO_ROWSTRIDE);
+  g_assert (memcmp (result, data, TILE_SIZE) == 0);
+  g_object_unref (buffer);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  gegl_init (&argc, &argv);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (constant_tile);
+  ADD_TEST (long_runs);
+  ADD_TEST (incompressible_tile);
+  ADD_TEST (old_index);
+
+  return g_test_run ();
+}